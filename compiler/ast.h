@@ -2,116 +2,289 @@
 
 #include <memory>
 #include <vector>
-#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+#include "interner.h"
+#include "ast_arena.h"
 
-// 前向声明
-struct ASTNode;
+// 节点种类：构造时写入 ASTNode::kind，各遍历按它 switch 分派，不依赖 RTTI。
+// 语句与表达式的种类各自连续排列，nodeCast<Statement>/nodeCast<Expression> 按区间判断。
+enum class NodeKind : uint8_t {
+    Program,
+    ImportDecl,
+    TypeNode,
+    FunctionDecl,
+    StructDecl,
+    ImplBlock,
+    // 语句
+    VariableDecl,
+    Block,
+    ReturnStmt,
+    ExpressionStmt,
+    // 表达式
+    Identifier,
+    Literal,
+    BinaryOp,
+    UnaryOp,
+    FunctionCall,
+};
 
 // AST 节点基类
+// 节点由 Program 的 AstArena 分配，子节点用裸指针相连，不单独释放；名字与文本是驻留表或 arena 中的视图。
+// 节点没有虚函数，可平凡析构：整棵树随 arena 的分块一起释放。
 struct ASTNode {
-    virtual ~ASTNode() = default;
+    NodeKind kind;
     int line = 0;
     int column = 0;
+
+protected:
+    explicit ASTNode(NodeKind k) : kind(k) {}
 };
 
 // 导入声明
 struct ImportDecl : public ASTNode {
-    std::string moduleName;
+    static constexpr NodeKind kKind = NodeKind::ImportDecl;
+    std::string_view moduleName;
+
+    ImportDecl(std::string_view module) : ASTNode(kKind), moduleName(module) {}
+};
+
+struct Block;
+
+// 骨架模式下函数体的来源：按 Token 区间补解析函数体，节点分配在所属 Program 的 arena 中
+class BodySource {
+public:
+    virtual ~BodySource() = default;
+    virtual Block* parseBody(size_t begin, size_t end) = 0;
+};
 
-    ImportDecl(const std::string& module) : moduleName(module) {}
+// 尚未解析的函数体：[begin, end) 是从 '{' 到配对的 '}' 的 Token 区间
+struct LazyBody {
+    BodySource* source;
+    size_t begin;
+    size_t end;
 };
 
-// 程序根节点
+// 顶层项在Token序列中的区间及其内容哈希（与位置无关，流式模式下不记录，hash 为 0）。
+// 增量重解析按哈希把内容未变的项从旧 Program 移过来
+struct TokenSpan {
+    size_t begin = 0;
+    size_t end = 0;
+    uint64_t hash = 0;
+};
+
+// 程序根节点：持有整棵树的 arena（其余节点都分配在其中）
 struct Program : public ASTNode {
-    std::vector<std::unique_ptr<ASTNode>> statements;
+    static constexpr NodeKind kKind = NodeKind::Program;
+    AstArena arena;
+    std::vector<ASTNode*> statements;
+    // 骨架模式下补解析函数体用；须在 Token 序列仍然有效时使用
+    std::unique_ptr<BodySource> bodySource;
+    // 自上次完整解析以来的增量重解析次数（被替换的旧节点仍占着 arena）
+    uint32_t reparses = 0;
+
+    Program() : ASTNode(kKind) {}
 };
 
 // 语句基类 - 需要提前定义
 struct Statement : public ASTNode {
-    // 语句基类
+protected:
+    using ASTNode::ASTNode;
 };
 
 // 类型定义
 struct TypeNode : public ASTNode {
-    std::string name;
+    static constexpr NodeKind kKind = NodeKind::TypeNode;
+    std::string_view name;
 
-    TypeNode(const std::string& typeName) : name(typeName) {}
+    TypeNode(std::string_view typeName) : ASTNode(kKind), name(typeName) {}
 };
 
 // 变量声明 - 继承自Statement，因为它也可以作为语句
 struct VariableDecl : public Statement {
-    std::string name;
-    std::unique_ptr<TypeNode> type;
-    std::unique_ptr<ASTNode> initializer;
+    static constexpr NodeKind kKind = NodeKind::VariableDecl;
+    std::string_view name;
+    SymbolId symbol = Interner::kNone;  // name 的驻留编号，查找一律用它
+    TypeNode* type = nullptr;
+    ASTNode* initializer = nullptr;
     bool isConst = false;
+
+    VariableDecl() : Statement(kKind) {}
 };
 
 // 函数声明
 struct FunctionDecl : public ASTNode {
-    std::string name;
-    std::vector<std::unique_ptr<VariableDecl>> parameters;
-    std::unique_ptr<TypeNode> returnType;
-    std::unique_ptr<ASTNode> body;
+    static constexpr NodeKind kKind = NodeKind::FunctionDecl;
+    std::string_view name;
+    SymbolId symbol = Interner::kNone;
+    NodeList<VariableDecl*> parameters;
+    TypeNode* returnType = nullptr;
+    ASTNode* body = nullptr;
+    LazyBody* lazyBody = nullptr;  // 骨架模式下尚未解析的函数体
+    TokenSpan span;                // 仅顶层函数记录
+
+    FunctionDecl() : ASTNode(kKind) {}
+
+    // 函数体；骨架模式下首次访问时才解析（函数体有语法错误时在此抛出 ParserError）
+    ASTNode* getBody();
 };
 
 // 结构体定义
 struct StructDecl : public ASTNode {
-    std::string name;
-    std::vector<std::unique_ptr<VariableDecl>> fields;
+    static constexpr NodeKind kKind = NodeKind::StructDecl;
+    std::string_view name;
+    SymbolId symbol = Interner::kNone;
+    NodeList<VariableDecl*> fields;
+    TokenSpan span;
+
+    StructDecl() : ASTNode(kKind) {}
 };
 
 // 实现块
 struct ImplBlock : public ASTNode {
-    std::string structName;
-    std::vector<std::unique_ptr<FunctionDecl>> methods;
+    static constexpr NodeKind kKind = NodeKind::ImplBlock;
+    std::string_view structName;
+    NodeList<FunctionDecl*> methods;
+    TokenSpan span;
+
+    ImplBlock() : ASTNode(kKind) {}
 };
 
 // 表达式基类
 struct Expression : public ASTNode {
-    // 表达式基类
+protected:
+    using ASTNode::ASTNode;
 };
 
 // 标识符表达式
 struct Identifier : public Expression {
-    std::string name;
+    static constexpr NodeKind kKind = NodeKind::Identifier;
+    std::string_view name;
+    SymbolId symbol;
 
-    Identifier(const std::string& n) : name(n) {}
+    Identifier(std::string_view n, SymbolId id) : Expression(kKind), name(n), symbol(id) {}
 };
 
 // 字面值表达式
 struct Literal : public Expression {
-    std::string value;
-    std::string type; // "int", "float", "string", "bool", "char"
+    static constexpr NodeKind kKind = NodeKind::Literal;
+    std::string_view value;
+    std::string_view type; // "int", "float", "string", "bool", "char"
+    // 数值字面值在词法阶段解码的结果（value 保留源码写法，如 0xFF、1_000）
+    int64_t intValue = 0;
+    double floatValue = 0.0;
 
-    Literal(const std::string& v, const std::string& t) : value(v), type(t) {}
+    Literal(std::string_view v, std::string_view t) : Expression(kKind), value(v), type(t) {}
 };
 
 // 二元运算表达式
 struct BinaryOp : public Expression {
-    std::unique_ptr<Expression> left;
-    std::string operator_;
-    std::unique_ptr<Expression> right;
+    static constexpr NodeKind kKind = NodeKind::BinaryOp;
+    Expression* left = nullptr;
+    std::string_view operator_;
+    Expression* right = nullptr;
+
+    BinaryOp() : Expression(kKind) {}
+};
+
+// 一元运算表达式（前缀 - 与 !）
+struct UnaryOp : public Expression {
+    static constexpr NodeKind kKind = NodeKind::UnaryOp;
+    std::string_view operator_;
+    Expression* operand = nullptr;
+
+    UnaryOp() : Expression(kKind) {}
 };
 
 // 函数调用表达式
 struct FunctionCall : public Expression {
-    std::string name;
-    std::vector<std::unique_ptr<Expression>> arguments;
+    static constexpr NodeKind kKind = NodeKind::FunctionCall;
+    std::string_view name;
+    SymbolId symbol;
+    NodeList<Expression*> arguments;
 
-    FunctionCall(const std::string& n) : name(n) {}
+    FunctionCall(std::string_view n, SymbolId id) : Expression(kKind), name(n), symbol(id) {}
 };
 
 // 块语句
 struct Block : public Statement {
-    std::vector<std::unique_ptr<Statement>> statements;
+    static constexpr NodeKind kKind = NodeKind::Block;
+    NodeList<Statement*> statements;
+
+    Block() : Statement(kKind) {}
 };
 
+inline ASTNode* FunctionDecl::getBody() {
+    if (lazyBody) {
+        body = lazyBody->source->parseBody(lazyBody->begin, lazyBody->end);
+        lazyBody = nullptr;
+    }
+    return body;
+}
+
 // 返回语句
 struct ReturnStmt : public Statement {
-    std::unique_ptr<Expression> value;
+    static constexpr NodeKind kKind = NodeKind::ReturnStmt;
+    Expression* value = nullptr;
+
+    ReturnStmt() : Statement(kKind) {}
 };
 
 // 表达式语句
 struct ExpressionStmt : public Statement {
-    std::unique_ptr<Expression> expression;
+    static constexpr NodeKind kKind = NodeKind::ExpressionStmt;
+    Expression* expression = nullptr;
+
+    ExpressionStmt() : Statement(kKind) {}
 };
+
+// 节点种类是否属于 T（T 为具体节点类型或 Statement/Expression 基类）
+template <typename T>
+constexpr bool isKindOf(NodeKind kind) {
+    if constexpr (std::is_same_v<T, ASTNode>) {
+        return true;
+    } else if constexpr (std::is_same_v<T, Statement>) {
+        return kind >= NodeKind::VariableDecl && kind <= NodeKind::ExpressionStmt;
+    } else if constexpr (std::is_same_v<T, Expression>) {
+        return kind >= NodeKind::Identifier && kind <= NodeKind::FunctionCall;
+    } else {
+        return kind == T::kKind;
+    }
+}
+
+// 按种类检查的向下转换（取代 dynamic_cast）：node 为空或种类不符时返回 nullptr
+template <typename T>
+T* nodeCast(ASTNode* node) {
+    return node && isKindOf<T>(node->kind) ? static_cast<T*>(node) : nullptr;
+}
+
+// 按节点种类分派：以具体类型的指针调用 visitor，整个分派只是一次 switch。
+// visitor 对每种节点类型都须可调用（通常是 auto* 参数的泛型 lambda）；node 不能为空。
+template <typename Visitor>
+decltype(auto) visit(ASTNode* node, Visitor&& visitor) {
+    switch (node->kind) {
+        case NodeKind::Program: return visitor(static_cast<Program*>(node));
+        case NodeKind::ImportDecl: return visitor(static_cast<ImportDecl*>(node));
+        case NodeKind::TypeNode: return visitor(static_cast<TypeNode*>(node));
+        case NodeKind::FunctionDecl: return visitor(static_cast<FunctionDecl*>(node));
+        case NodeKind::StructDecl: return visitor(static_cast<StructDecl*>(node));
+        case NodeKind::ImplBlock: return visitor(static_cast<ImplBlock*>(node));
+        case NodeKind::VariableDecl: return visitor(static_cast<VariableDecl*>(node));
+        case NodeKind::Block: return visitor(static_cast<Block*>(node));
+        case NodeKind::ReturnStmt: return visitor(static_cast<ReturnStmt*>(node));
+        case NodeKind::ExpressionStmt: return visitor(static_cast<ExpressionStmt*>(node));
+        case NodeKind::Identifier: return visitor(static_cast<Identifier*>(node));
+        case NodeKind::Literal: return visitor(static_cast<Literal*>(node));
+        case NodeKind::BinaryOp: return visitor(static_cast<BinaryOp*>(node));
+        case NodeKind::UnaryOp: return visitor(static_cast<UnaryOp*>(node));
+        case NodeKind::FunctionCall: return visitor(static_cast<FunctionCall*>(node));
+    }
+    std::abort();  // 种类值损坏
+}
+
+// arena 中的节点不调用析构函数
+static_assert(std::is_trivially_destructible_v<BinaryOp> && std::is_trivially_destructible_v<FunctionDecl> &&
+                  std::is_trivially_destructible_v<Block> && std::is_trivially_destructible_v<Literal>,
+              "AST 节点须可平凡析构");
@@ -0,0 +1,79 @@
+#include "ast_arena.h"
+#include <cstdlib>
+#include <cstring>
+
+AstArena::AstArena(AstArena&& other) noexcept {
+    *this = std::move(other);
+}
+
+AstArena& AstArena::operator=(AstArena&& other) noexcept {
+    if (this != &other) {
+        release();
+        chunks = std::move(other.chunks);
+        finalizers = std::move(other.finalizers);
+        cursor = other.cursor;
+        limit = other.limit;
+        nextChunkSize = other.nextChunkSize;
+        used = other.used;
+        other.chunks.clear();
+        other.finalizers.clear();
+        other.cursor = other.limit = nullptr;
+        other.nextChunkSize = kFirstChunkSize;
+        other.used = 0;
+    }
+    return *this;
+}
+
+void AstArena::release() {
+    // 逆序析构：后构造的对象先销毁
+    for (auto it = finalizers.rbegin(); it != finalizers.rend(); ++it) {
+        it->destroy(it->object);
+    }
+    for (char* chunk : chunks) {
+        std::free(chunk);
+    }
+    finalizers.clear();
+    chunks.clear();
+    cursor = limit = nullptr;
+    used = 0;
+}
+
+void* AstArena::allocateSlow(size_t size, size_t align) {
+    size_t needed = size + align;
+    if (needed > nextChunkSize) {
+        // 大对象单独成块，不打断当前块的分配
+        char* chunk = static_cast<char*>(std::malloc(needed));
+        if (!chunk) throw std::bad_alloc();
+        chunks.push_back(chunk);
+        used += size;
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(chunk) + align - 1) & ~static_cast<uintptr_t>(align - 1);
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    char* chunk = static_cast<char*>(std::malloc(nextChunkSize));
+    if (!chunk) throw std::bad_alloc();
+    chunks.push_back(chunk);
+    cursor = chunk;
+    limit = chunk + nextChunkSize;
+    if (nextChunkSize < kMaxChunkSize) nextChunkSize *= 2;
+    return allocate(size, align);
+}
+
+std::string_view AstArena::copy(std::string_view text) {
+    if (text.empty()) return std::string_view();
+    char* data = allocateArray<char>(text.size());
+    std::memcpy(data, text.data(), text.size());
+    return std::string_view(data, text.size());
+}
+
+void AstArena::adopt(AstArena&& other) {
+    if (this == &other) return;
+    chunks.insert(chunks.end(), other.chunks.begin(), other.chunks.end());
+    finalizers.insert(finalizers.end(), other.finalizers.begin(), other.finalizers.end());
+    used += other.used;
+    // 当前块继续分配；other 的剩余空间不再使用
+    other.chunks.clear();
+    other.finalizers.clear();
+    other.cursor = other.limit = nullptr;
+    other.used = 0;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// 存放在 AstArena 中的定长序列（子节点列表等），随 arena 一起释放
+template <typename T>
+class NodeList {
+private:
+    T* items = nullptr;
+    uint32_t count = 0;
+
+public:
+    NodeList() = default;
+    NodeList(T* data, uint32_t size) : items(data), count(size) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T* begin() const { return items; }
+    T* end() const { return items + count; }
+    T& operator[](size_t index) const { return items[index]; }
+};
+
+// AST 节点的分块分配器：按指针递增分配，节点不单独释放。
+// 整棵树随 arena 一起销毁，代价只与分块数有关；非平凡析构的对象另行登记，销毁时统一（非递归地）调用析构函数。
+// arena 只能移动，节点地址在 arena 销毁前保持不变。
+class AstArena {
+private:
+    static constexpr size_t kFirstChunkSize = 16 * 1024;
+    static constexpr size_t kMaxChunkSize = 1024 * 1024;
+
+    struct Finalizer {
+        void* object;
+        void (*destroy)(void*);
+    };
+
+    std::vector<char*> chunks;
+    std::vector<Finalizer> finalizers;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t nextChunkSize = kFirstChunkSize;
+    size_t used = 0;
+
+    // 当前块放不下时开新块（超过块大小的请求单独成块）
+    void* allocateSlow(size_t size, size_t align);
+    void release();
+
+public:
+    AstArena() = default;
+    AstArena(AstArena&& other) noexcept;
+    AstArena& operator=(AstArena&& other) noexcept;
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+    ~AstArena() { release(); }
+
+    void* allocate(size_t size, size_t align) {
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~static_cast<uintptr_t>(align - 1);
+        if (cursor && aligned + size <= reinterpret_cast<uintptr_t>(limit)) {
+            cursor = reinterpret_cast<char*>(aligned + size);
+            used += size;
+            return reinterpret_cast<void*>(aligned);
+        }
+        return allocateSlow(size, align);
+    }
+
+    // 在 arena 中构造对象
+    template <typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            finalizers.push_back({object, [](void* p) { static_cast<T*>(p)->~T(); }});
+        }
+        return object;
+    }
+
+    // 分配未初始化的数组（元素须可平凡析构）
+    template <typename T>
+    T* allocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena 数组不调用析构函数");
+        return count ? static_cast<T*>(allocate(sizeof(T) * count, alignof(T))) : nullptr;
+    }
+
+    // 把 items 复制为 arena 中的定长列表
+    template <typename T>
+    NodeList<T> list(const T* items, size_t count) {
+        T* data = allocateArray<T>(count);
+        for (size_t i = 0; i < count; ++i) {
+            new (data + i) T(items[i]);
+        }
+        return NodeList<T>(data, static_cast<uint32_t>(count));
+    }
+
+    // 把文本复制进 arena，返回的视图与 arena 同寿命
+    std::string_view copy(std::string_view text);
+
+    // 接管另一个 arena 的全部内存（other 变为空）；用于把独立构建的子树并入同一个 Program
+    void adopt(AstArena&& other);
+
+    // 已分配的字节数与分块数
+    size_t bytesUsed() const { return used; }
+    size_t chunkCount() const { return chunks.size(); }
+};
@@ -1,4 +1,5 @@
 #include "ast_interpreter.h"
+#include "error.h"
 #include <iostream>
 #include <fstream>
 #include <typeinfo>
@@ -7,6 +8,123 @@
 
 namespace polyglot {
 
+namespace {
+
+// 运算的求值规则，树遍历与扁平 AST 两条路径共用
+
+// && 与 ||：左值已能决定结果时不再求右侧
+template <typename EvaluateRight>
+ASTValue logicalOperation(std::string_view op, const ASTValue& left, EvaluateRight&& evaluateRight) {
+    if (left.getType() == ASTValue::BOOL) {
+        bool value = left.get<bool>();
+        if (value == (op == "||")) {
+            return ASTValue(value);
+        }
+        ASTValue right = evaluateRight();
+        if (right.getType() == ASTValue::BOOL) {
+            return ASTValue(right.get<bool>());
+        }
+    }
+    std::cerr << "⚠️ 不支持的二元运算: " << op << std::endl;
+    return ASTValue();
+}
+
+// 带溢出检查的 int64 加、减、乘（有符号溢出在 C++ 中是未定义行为）：溢出时返回 true。
+// GCC/Clang 用内建函数；MSVC 先按无符号运算回绕（有定义），再由符号判断是否溢出
+bool addOverflows(int64_t l, int64_t r, int64_t* result) {
+#if defined(_MSC_VER)
+    *result = static_cast<int64_t>(static_cast<uint64_t>(l) + static_cast<uint64_t>(r));
+    return (l >= 0) == (r >= 0) && (*result >= 0) != (l >= 0);
+#else
+    return __builtin_add_overflow(l, r, result);
+#endif
+}
+
+bool subOverflows(int64_t l, int64_t r, int64_t* result) {
+#if defined(_MSC_VER)
+    *result = static_cast<int64_t>(static_cast<uint64_t>(l) - static_cast<uint64_t>(r));
+    return (l >= 0) != (r >= 0) && (*result >= 0) != (l >= 0);
+#else
+    return __builtin_sub_overflow(l, r, result);
+#endif
+}
+
+bool mulOverflows(int64_t l, int64_t r, int64_t* result) {
+#if defined(_MSC_VER)
+    *result = static_cast<int64_t>(static_cast<uint64_t>(l) * static_cast<uint64_t>(r));
+    return l != 0 && ((l == -1 && r == INT64_MIN) || *result / l != r);
+#else
+    return __builtin_mul_overflow(l, r, result);
+#endif
+}
+
+ASTValue binaryOperation(std::string_view op, const ASTValue& left, const ASTValue& right) {
+    if (left.getType() == ASTValue::INT && right.getType() == ASTValue::INT) {
+        int64_t l = left.get<int64_t>();
+        int64_t r = right.get<int64_t>();
+        int64_t result = 0;
+        if (op == "+" || op == "-" || op == "*") {
+            bool overflow = op == "+"   ? addOverflows(l, r, &result)
+                            : op == "-" ? subOverflows(l, r, &result)
+                                        : mulOverflows(l, r, &result);
+            if (overflow) {
+                const char* name = op == "+" ? "加法" : op == "-" ? "减法" : "乘法";
+                throw RuntimeError(std::string("整数") + name + "溢出: " + std::to_string(l) + " " + std::string(op) +
+                                   " " + std::to_string(r));
+            }
+            return ASTValue(result);
+        }
+        if (op == "/" || op == "%") {
+            // 除零与 INT64_MIN / -1 在 C++ 中是未定义行为，须在运算前拦下
+            if (r == 0) {
+                throw RuntimeError(op == "/" ? "除数为零" : "取模的除数为零");
+            }
+            if (r == -1) {
+                // 任何数模 -1 都为 0；INT64_MIN / -1 的结果超出 int64 范围
+                if (op == "%") return ASTValue(int64_t{0});
+                if (l == INT64_MIN) throw RuntimeError("整数除法溢出: " + std::to_string(l) + " / -1");
+            }
+            return ASTValue(op == "/" ? l / r : l % r);
+        }
+        if (op == "==") return ASTValue(l == r);
+        if (op == "!=") return ASTValue(l != r);
+        if (op == "<") return ASTValue(l < r);
+        if (op == ">") return ASTValue(l > r);
+        if (op == "<=") return ASTValue(l <= r);
+        if (op == ">=") return ASTValue(l >= r);
+    } else if (left.getType() == right.getType() &&
+               (left.getType() == ASTValue::STRING || left.getType() == ASTValue::BOOL)) {
+        if (op == "==") return ASTValue(left.toString() == right.toString());
+        if (op == "!=") return ASTValue(left.toString() != right.toString());
+    }
+
+    std::cerr << "⚠️ 不支持的二元运算: " << op << std::endl;
+    return ASTValue();
+}
+
+ASTValue unaryOperation(std::string_view op, const ASTValue& operand) {
+    if (op == "-") {
+        if (operand.getType() == ASTValue::INT) {
+            // 与 INT64_MIN / -1 同理（字面值 -9223372036854775808 在语法分析时已合并，不经过这里）
+            if (operand.get<int64_t>() == INT64_MIN) {
+                throw RuntimeError("整数取负溢出: -(" + std::to_string(INT64_MIN) + ")");
+            }
+            return ASTValue(-operand.get<int64_t>());
+        } else if (operand.getType() == ASTValue::FLOAT) {
+            return ASTValue(-operand.get<double>());
+        }
+    } else if (op == "!") {
+        if (operand.getType() == ASTValue::BOOL) {
+            return ASTValue(!operand.get<bool>());
+        }
+    }
+
+    std::cerr << "⚠️ 不支持的一元运算: " << op << std::endl;
+    return ASTValue();
+}
+
+}  // namespace
+
 // AST解释器实现
 ASTValue ASTInterpreter::interpret(std::unique_ptr<Program>& program) {
     ASTValue result;
@@ -16,19 +134,19 @@ ASTValue ASTInterpreter::interpret(std::unique_ptr<Program>& program) {
     // 先遍历一遍，记录入口函数（main/主函数）
     FunctionDecl* entry = nullptr;
     for (auto& stmt : program->statements) {
-        if (auto f = dynamic_cast<FunctionDecl*>(stmt.get())) {
-            if (f->name == "main" || f->name == "主函数") {
+        if (auto f = nodeCast<FunctionDecl>(stmt)) {
+            if (f->symbol == Interner::kMain || f->symbol == Interner::kMainChinese) {
                 entry = f;
             }
         }
         // 仍然走一遍常规访问，处理顶层语句/变量等
-        result = visit(stmt.get());
+        result = visit(stmt);
     }
 
     // 自动执行入口函数（仅限无参数）
-    if (entry && entry->body) {
+    if (entry && entry->getBody()) {
         // 直接访问函数体节点，避免类型不匹配
-        (void)visit(entry->body.get());
+        (void)visit(entry->body);
     }
 
     std::cout << "✅ AST解释执行完成" << std::endl;
@@ -36,33 +154,42 @@ ASTValue ASTInterpreter::interpret(std::unique_ptr<Program>& program) {
 }
 
 ASTValue ASTInterpreter::visit(ASTNode* node) {
-    // 使用dynamic_cast进行类型判断
-    if (auto import = dynamic_cast<ImportDecl*>(node)) {
-        return visitImport(import);
-    } else if (auto varDecl = dynamic_cast<VariableDecl*>(node)) {
-        return visitVariableDecl(varDecl);
-    } else if (auto funcDecl = dynamic_cast<FunctionDecl*>(node)) {
-        return visitFunctionDecl(funcDecl);
-    } else if (auto structDecl = dynamic_cast<StructDecl*>(node)) {
-        return visitStructDecl(structDecl);
-    } else if (auto block = dynamic_cast<Block*>(node)) {
-        return visitBlock(block);
-    } else if (auto returnStmt = dynamic_cast<ReturnStmt*>(node)) {
-        return visitReturnStmt(returnStmt);
-    } else if (auto exprStmt = dynamic_cast<ExpressionStmt*>(node)) {
-        return visitExpressionStmt(exprStmt);
-    } else if (auto identifier = dynamic_cast<Identifier*>(node)) {
-        return visitIdentifier(identifier);
-    } else if (auto literal = dynamic_cast<Literal*>(node)) {
-        return visitLiteral(literal);
-    } else if (auto binaryOp = dynamic_cast<BinaryOp*>(node)) {
-        return visitBinaryOp(binaryOp);
-    } else if (auto funcCall = dynamic_cast<FunctionCall*>(node)) {
-        return visitFunctionCall(funcCall);
+    if (!node) {
+        return ASTValue();
     }
 
-    std::cerr << "⚠️ 未识别的AST节点类型" << std::endl;
-    return ASTValue();
+    // 按节点种类一次 switch 分派
+    return ::visit(node, [this](auto* n) -> ASTValue {
+        using T = std::remove_pointer_t<decltype(n)>;
+        if constexpr (std::is_same_v<T, ImportDecl>) {
+            return visitImport(n);
+        } else if constexpr (std::is_same_v<T, VariableDecl>) {
+            return visitVariableDecl(n);
+        } else if constexpr (std::is_same_v<T, FunctionDecl>) {
+            return visitFunctionDecl(n);
+        } else if constexpr (std::is_same_v<T, StructDecl>) {
+            return visitStructDecl(n);
+        } else if constexpr (std::is_same_v<T, Block>) {
+            return visitBlock(n);
+        } else if constexpr (std::is_same_v<T, ReturnStmt>) {
+            return visitReturnStmt(n);
+        } else if constexpr (std::is_same_v<T, ExpressionStmt>) {
+            return visitExpressionStmt(n);
+        } else if constexpr (std::is_same_v<T, Identifier>) {
+            return visitIdentifier(n);
+        } else if constexpr (std::is_same_v<T, Literal>) {
+            return visitLiteral(n);
+        } else if constexpr (std::is_same_v<T, BinaryOp>) {
+            return visitBinaryOp(n);
+        } else if constexpr (std::is_same_v<T, UnaryOp>) {
+            return visitUnaryOp(n);
+        } else if constexpr (std::is_same_v<T, FunctionCall>) {
+            return visitFunctionCall(n);
+        } else {
+            std::cerr << "⚠️ 未识别的AST节点类型" << std::endl;
+            return ASTValue();
+        }
+    });
 }
 
 ASTValue ASTInterpreter::visitImport(ImportDecl* node) {
@@ -73,10 +200,10 @@ ASTValue ASTInterpreter::visitImport(ImportDecl* node) {
 ASTValue ASTInterpreter::visitVariableDecl(VariableDecl* node) {
     ASTValue value;
     if (node->initializer) {
-        value = visit(node->initializer.get());
+        value = visit(node->initializer);
     }
 
-    environment->define(node->name, value);
+    environment->define(node->symbol, value);
     std::cout << "📝 定义变量: " << node->name << " = " << value.toString() << std::endl;
 
     return ASTValue();
@@ -100,7 +227,7 @@ ASTValue ASTInterpreter::visitBlock(Block* node) {
 
     ASTValue result;
     for (auto& stmt : node->statements) {
-        result = visit(stmt.get());
+        result = visit(stmt);
     }
 
     // 恢复上一层作用域
@@ -111,7 +238,7 @@ ASTValue ASTInterpreter::visitBlock(Block* node) {
 ASTValue ASTInterpreter::visitReturnStmt(ReturnStmt* node) {
     ASTValue value;
     if (node->value) {
-        value = visit(node->value.get());
+        value = visit(node->value);
     }
 
     std::cout << "↩️ 返回值: " << value.toString() << std::endl;
@@ -119,12 +246,12 @@ ASTValue ASTInterpreter::visitReturnStmt(ReturnStmt* node) {
 }
 
 ASTValue ASTInterpreter::visitExpressionStmt(ExpressionStmt* node) {
-    return visit(node->expression.get());
+    return visit(node->expression);
 }
 
 ASTValue ASTInterpreter::visitIdentifier(Identifier* node) {
     try {
-        return environment->get(node->name);
+        return environment->get(node->symbol);
     } catch (const std::runtime_error& e) {
         std::cerr << "❌ " << e.what() << std::endl;
         return ASTValue();
@@ -132,12 +259,13 @@ ASTValue ASTInterpreter::visitIdentifier(Identifier* node) {
 }
 
 ASTValue ASTInterpreter::visitLiteral(Literal* node) {
+    // 数值已在词法阶段解码，求值时不再解析文本
     if (node->type == "int") {
-        return ASTValue(std::stoi(node->value));
+        return ASTValue(node->intValue);
     } else if (node->type == "float") {
-        return ASTValue(std::stod(node->value));
+        return ASTValue(node->floatValue);
     } else if (node->type == "string") {
-        return ASTValue(node->value);
+        return ASTValue(std::string(node->value));
     } else if (node->type == "bool") {
         return ASTValue(node->value == "true");
     }
@@ -146,47 +274,134 @@ ASTValue ASTInterpreter::visitLiteral(Literal* node) {
 }
 
 ASTValue ASTInterpreter::visitBinaryOp(BinaryOp* node) {
-    ASTValue left = visit(node->left.get());
-    ASTValue right = visit(node->right.get());
+    std::string_view op = node->operator_;
+    ASTValue left = visit(node->left);
 
-    if (node->operator_ == "+") {
-        if (left.getType() == ASTValue::INT && right.getType() == ASTValue::INT) {
-            return ASTValue(left.get<int>() + right.get<int>());
-        }
-    } else if (node->operator_ == "-") {
-        if (left.getType() == ASTValue::INT && right.getType() == ASTValue::INT) {
-            return ASTValue(left.get<int>() - right.get<int>());
-        }
-    } else if (node->operator_ == "*") {
-        if (left.getType() == ASTValue::INT && right.getType() == ASTValue::INT) {
-            return ASTValue(left.get<int>() * right.get<int>());
-        }
-    } else if (node->operator_ == "/") {
-        if (left.getType() == ASTValue::INT && right.getType() == ASTValue::INT) {
-            return ASTValue(left.get<int>() / right.get<int>());
-        }
+    // 逻辑运算短路求值
+    if (op == "&&" || op == "||") {
+        return logicalOperation(op, left, [&] { return visit(node->right); });
     }
+    return binaryOperation(op, left, visit(node->right));
+}
 
-    std::cerr << "⚠️ 不支持的二元运算: " << node->operator_ << std::endl;
-    return ASTValue();
+ASTValue ASTInterpreter::visitUnaryOp(UnaryOp* node) {
+    return unaryOperation(node->operator_, visit(node->operand));
 }
 
 ASTValue ASTInterpreter::visitFunctionCall(FunctionCall* node) {
     std::vector<ASTValue> args;
     for (auto& arg : node->arguments) {
-        args.push_back(visit(arg.get()));
+        args.push_back(visit(arg));
+    }
+
+    return callBuiltinFunction(node->symbol, args);
+}
+
+ASTValue ASTInterpreter::interpret(const flat_ast::Ast& program) {
+    ASTValue result;
+
+    std::cout << "🚀 开始解释执行AST..." << std::endl;
+
+    flat_ast::Ref entry;
+    for (flat_ast::Ref stmt : program.statements()) {
+        if (stmt.kind() == NodeKind::FunctionDecl) {
+            SymbolId symbol = program.functionDecl(stmt).symbol;
+            if (symbol == Interner::kMain || symbol == Interner::kMainChinese) {
+                entry = stmt;
+            }
+        }
+        result = evaluate(program, stmt);
+    }
+
+    // 自动执行入口函数（仅限无参数）
+    if (entry && program.functionDecl(entry).body) {
+        (void)evaluate(program, program.functionDecl(entry).body);
     }
 
-    return callBuiltinFunction(node->name, args);
+    std::cout << "✅ AST解释执行完成" << std::endl;
+    return result;
+}
+
+ASTValue ASTInterpreter::evaluate(const flat_ast::Ast& ast, flat_ast::Ref node) {
+    if (!node) {
+        return ASTValue();
+    }
+
+    return ast.visit(node, [&](const auto& n) -> ASTValue {
+        using T = std::decay_t<decltype(n)>;
+        if constexpr (std::is_same_v<T, flat_ast::ImportDecl>) {
+            std::cout << "📦 导入模块: " << ast.text(n.moduleName) << std::endl;
+            return ASTValue();
+        } else if constexpr (std::is_same_v<T, flat_ast::VariableDecl>) {
+            ASTValue value = evaluate(ast, n.initializer);
+            environment->define(n.symbol, value);
+            std::cout << "📝 定义变量: " << ast.name(n.symbol) << " = " << value.toString() << std::endl;
+            return ASTValue();
+        } else if constexpr (std::is_same_v<T, flat_ast::FunctionDecl>) {
+            std::cout << "🔧 定义函数: " << ast.name(n.symbol) << std::endl;
+            return ASTValue();
+        } else if constexpr (std::is_same_v<T, flat_ast::StructDecl>) {
+            std::cout << "🏗️ 定义结构体: " << ast.name(n.symbol) << std::endl;
+            return ASTValue();
+        } else if constexpr (std::is_same_v<T, flat_ast::Block>) {
+            auto previous = environment;
+            environment = std::make_shared<Environment>(environment);
+            ASTValue result;
+            for (flat_ast::Ref stmt : ast.list(n.statements)) {
+                result = evaluate(ast, stmt);
+            }
+            environment = previous;
+            return result;
+        } else if constexpr (std::is_same_v<T, flat_ast::ReturnStmt>) {
+            ASTValue value = evaluate(ast, n.value);
+            std::cout << "↩️ 返回值: " << value.toString() << std::endl;
+            return value;
+        } else if constexpr (std::is_same_v<T, flat_ast::ExpressionStmt>) {
+            return evaluate(ast, n.expression);
+        } else if constexpr (std::is_same_v<T, flat_ast::Identifier>) {
+            try {
+                return environment->get(n.symbol);
+            } catch (const std::runtime_error& e) {
+                std::cerr << "❌ " << e.what() << std::endl;
+                return ASTValue();
+            }
+        } else if constexpr (std::is_same_v<T, flat_ast::Literal>) {
+            switch (n.type) {
+                case flat_ast::LiteralType::Int: return ASTValue(n.intValue);
+                case flat_ast::LiteralType::Float: return ASTValue(n.floatValue);
+                case flat_ast::LiteralType::String: return ASTValue(std::string(ast.text(n.value)));
+                case flat_ast::LiteralType::Bool: return ASTValue(ast.text(n.value) == "true");
+                default: return ASTValue();
+            }
+        } else if constexpr (std::is_same_v<T, flat_ast::BinaryOp>) {
+            std::string_view op = flat_ast::spelling(n.op);
+            ASTValue left = evaluate(ast, n.left);
+            if (n.op == flat_ast::Operator::And || n.op == flat_ast::Operator::Or) {
+                return logicalOperation(op, left, [&] { return evaluate(ast, n.right); });
+            }
+            return binaryOperation(op, left, evaluate(ast, n.right));
+        } else if constexpr (std::is_same_v<T, flat_ast::UnaryOp>) {
+            return unaryOperation(flat_ast::spelling(n.op), evaluate(ast, n.operand));
+        } else if constexpr (std::is_same_v<T, flat_ast::FunctionCall>) {
+            std::vector<ASTValue> args;
+            for (flat_ast::Ref arg : ast.list(n.arguments)) {
+                args.push_back(evaluate(ast, arg));
+            }
+            return callBuiltinFunction(n.symbol, args);
+        } else {
+            std::cerr << "⚠️ 未识别的AST节点类型" << std::endl;
+            return ASTValue();
+        }
+    });
 }
 
 void ASTInterpreter::setupBuiltins() {
     // 内置函数将在运行时处理
 }
 
-ASTValue ASTInterpreter::callBuiltinFunction(const std::string& name,
+ASTValue ASTInterpreter::callBuiltinFunction(SymbolId name,
                                            const std::vector<ASTValue>& args) {
-    if (name == "print" || name == "打印") {
+    if (name == Interner::kPrint || name == Interner::kPrintChinese) {
         std::string out;
         for (size_t i = 0; i < args.size(); ++i) {
             out += args[i].toString();
@@ -198,7 +413,7 @@ ASTValue ASTInterpreter::callBuiltinFunction(const std::string& name,
         return ASTValue();
     }
 
-    std::cerr << "❌ 未知的内置函数: " << name << std::endl;
+    std::cerr << "❌ 未知的内置函数: " << Interner::global().name(name) << std::endl;
     return ASTValue();
 }
 
@@ -208,26 +423,31 @@ void ASTVisualizer::printAST(ASTNode* node, int depth) {
     std::cout << nodeToString(node) << std::endl;
 
     // 递归打印子节点
-    if (auto program = dynamic_cast<Program*>(node)) {
-        for (auto& stmt : program->statements) {
-            printAST(stmt.get(), depth + 1);
-        }
-    } else if (auto block = dynamic_cast<Block*>(node)) {
-        for (auto& stmt : block->statements) {
-            printAST(stmt.get(), depth + 1);
-        }
-    } else if (auto funcDecl = dynamic_cast<FunctionDecl*>(node)) {
-        if (funcDecl->body) {
-            printAST(funcDecl->body.get(), depth + 1);
-        }
-    } else if (auto varDecl = dynamic_cast<VariableDecl*>(node)) {
-        if (varDecl->initializer) {
-            printAST(varDecl->initializer.get(), depth + 1);
+    ::visit(node, [depth](auto* n) {
+        using T = std::remove_pointer_t<decltype(n)>;
+        if constexpr (std::is_same_v<T, Program> || std::is_same_v<T, Block>) {
+            for (auto& stmt : n->statements) {
+                printAST(stmt, depth + 1);
+            }
+        } else if constexpr (std::is_same_v<T, FunctionDecl>) {
+            // 骨架模式下尚未解析的函数体只标出，不为打印而解析
+            if (n->lazyBody) {
+                printIndent(depth + 1);
+                std::cout << "⏳ 函数体未解析" << std::endl;
+            } else if (n->body) {
+                printAST(n->body, depth + 1);
+            }
+        } else if constexpr (std::is_same_v<T, VariableDecl>) {
+            if (n->initializer) {
+                printAST(n->initializer, depth + 1);
+            }
+        } else if constexpr (std::is_same_v<T, BinaryOp>) {
+            printAST(n->left, depth + 1);
+            printAST(n->right, depth + 1);
+        } else if constexpr (std::is_same_v<T, UnaryOp>) {
+            printAST(n->operand, depth + 1);
         }
-    } else if (auto binaryOp = dynamic_cast<BinaryOp*>(node)) {
-        printAST(binaryOp->left.get(), depth + 1);
-        printAST(binaryOp->right.get(), depth + 1);
-    }
+    });
 }
 
 void ASTVisualizer::printIndent(int depth) {
@@ -237,31 +457,36 @@ void ASTVisualizer::printIndent(int depth) {
 }
 
 std::string ASTVisualizer::nodeToString(ASTNode* node) {
-    if (auto program = dynamic_cast<Program*>(node)) {
-        return "🌍 Program";
-    } else if (auto import = dynamic_cast<ImportDecl*>(node)) {
-        return "📦 Import: " + import->moduleName;
-    } else if (auto varDecl = dynamic_cast<VariableDecl*>(node)) {
-        return "📝 Variable: " + varDecl->name;
-    } else if (auto funcDecl = dynamic_cast<FunctionDecl*>(node)) {
-        return "🔧 Function: " + funcDecl->name;
-    } else if (auto structDecl = dynamic_cast<StructDecl*>(node)) {
-        return "🏗️ Struct: " + structDecl->name;
-    } else if (auto block = dynamic_cast<Block*>(node)) {
-        return "📦 Block";
-    } else if (auto returnStmt = dynamic_cast<ReturnStmt*>(node)) {
-        return "↩️ Return";
-    } else if (auto identifier = dynamic_cast<Identifier*>(node)) {
-        return "🔗 Identifier: " + identifier->name;
-    } else if (auto literal = dynamic_cast<Literal*>(node)) {
-        return "💎 Literal: " + literal->value + " (" + literal->type + ")";
-    } else if (auto binaryOp = dynamic_cast<BinaryOp*>(node)) {
-        return "⚙️ BinaryOp: " + binaryOp->operator_;
-    } else if (auto funcCall = dynamic_cast<FunctionCall*>(node)) {
-        return "📞 FunctionCall: " + funcCall->name;
-    }
-
-    return "❓ Unknown";
+    return ::visit(node, [](auto* n) -> std::string {
+        using T = std::remove_pointer_t<decltype(n)>;
+        if constexpr (std::is_same_v<T, Program>) {
+            return "🌍 Program";
+        } else if constexpr (std::is_same_v<T, ImportDecl>) {
+            return "📦 Import: " + std::string(n->moduleName);
+        } else if constexpr (std::is_same_v<T, VariableDecl>) {
+            return "📝 Variable: " + std::string(n->name);
+        } else if constexpr (std::is_same_v<T, FunctionDecl>) {
+            return "🔧 Function: " + std::string(n->name);
+        } else if constexpr (std::is_same_v<T, StructDecl>) {
+            return "🏗️ Struct: " + std::string(n->name);
+        } else if constexpr (std::is_same_v<T, Block>) {
+            return "📦 Block";
+        } else if constexpr (std::is_same_v<T, ReturnStmt>) {
+            return "↩️ Return";
+        } else if constexpr (std::is_same_v<T, Identifier>) {
+            return "🔗 Identifier: " + std::string(n->name);
+        } else if constexpr (std::is_same_v<T, Literal>) {
+            return "💎 Literal: " + std::string(n->value) + " (" + std::string(n->type) + ")";
+        } else if constexpr (std::is_same_v<T, BinaryOp>) {
+            return "⚙️ BinaryOp: " + std::string(n->operator_);
+        } else if constexpr (std::is_same_v<T, UnaryOp>) {
+            return "⚙️ UnaryOp: " + std::string(n->operator_);
+        } else if constexpr (std::is_same_v<T, FunctionCall>) {
+            return "📞 FunctionCall: " + std::string(n->name);
+        } else {
+            return "❓ Unknown";
+        }
+    });
 }
 
 void ASTVisualizer::exportToJSON(ASTNode* node, const std::string& filename) {
@@ -286,7 +511,7 @@ ASTAnalyzer::AnalysisResult ASTAnalyzer::analyze(Program* program) {
     std::cout << "🔍 开始分析AST..." << std::endl;
 
     for (auto& stmt : program->statements) {
-        analyzeNode(stmt.get(), result, 0);
+        analyzeNode(stmt, result, 0);
     }
 
     std::cout << "📊 AST分析完成:" << std::endl;
@@ -302,9 +527,9 @@ void ASTAnalyzer::analyzeNode(ASTNode* node, AnalysisResult& result, int depth)
     result.totalNodes++;
     result.maxDepth = std::max(result.maxDepth, depth);
 
-    if (dynamic_cast<FunctionDecl*>(node)) {
+    if (node->kind == NodeKind::FunctionDecl) {
         result.functionCount++;
-    } else if (dynamic_cast<VariableDecl*>(node)) {
+    } else if (node->kind == NodeKind::VariableDecl) {
         result.variableCount++;
     }
 
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "ast.h"
+#include "flat_ast.h"
 #include <iostream>
 #include <memory>
 #include <map>
+#include <unordered_map>
+#include <stdexcept>
 #include <any>
 #include <string>
+#include <cstdint>
 
 namespace polyglot {
 
@@ -20,7 +24,8 @@ private:
 
 public:
     ASTValue() : type(VOID) {}
-    ASTValue(int v) : type(INT), value(v) {}
+    ASTValue(int v) : type(INT), value(static_cast<int64_t>(v)) {}
+    ASTValue(int64_t v) : type(INT), value(v) {}
     ASTValue(double v) : type(FLOAT), value(v) {}
     ASTValue(const std::string& v) : type(STRING), value(v) {}
     ASTValue(bool v) : type(BOOL), value(v) {}
@@ -32,7 +37,7 @@ public:
 
     std::string toString() const {
         switch(type) {
-            case INT: return std::to_string(std::any_cast<int>(value));
+            case INT: return std::to_string(std::any_cast<int64_t>(value));
             case FLOAT: {
                 char buf[64];
                 std::snprintf(buf, sizeof(buf), "%.6f", std::any_cast<double>(value));
@@ -49,37 +54,37 @@ public:
 // AST 环境（作用域）
 class Environment {
 private:
-    std::map<std::string, ASTValue> variables;
+    // 按名字的驻留编号索引（整数哈希，不比较字符串）
+    std::unordered_map<SymbolId, ASTValue> variables;
     std::shared_ptr<Environment> parent;
 
 public:
     Environment() : parent(nullptr) {}
     Environment(std::shared_ptr<Environment> p) : parent(p) {}
 
-    void define(const std::string& name, const ASTValue& value) {
+    void define(SymbolId name, const ASTValue& value) {
         variables[name] = value;
     }
 
-    ASTValue get(const std::string& name) {
-        if (variables.find(name) != variables.end()) {
-            return variables[name];
-        }
-        if (parent) {
-            return parent->get(name);
+    ASTValue get(SymbolId name) {
+        for (Environment* env = this; env; env = env->parent.get()) {
+            auto it = env->variables.find(name);
+            if (it != env->variables.end()) {
+                return it->second;
+            }
         }
-        throw std::runtime_error("Undefined variable: " + name);
+        throw std::runtime_error("Undefined variable: " + std::string(Interner::global().name(name)));
     }
 
-    void assign(const std::string& name, const ASTValue& value) {
-        if (variables.find(name) != variables.end()) {
-            variables[name] = value;
-            return;
-        }
-        if (parent) {
-            parent->assign(name, value);
-            return;
+    void assign(SymbolId name, const ASTValue& value) {
+        for (Environment* env = this; env; env = env->parent.get()) {
+            auto it = env->variables.find(name);
+            if (it != env->variables.end()) {
+                it->second = value;
+                return;
+            }
         }
-        throw std::runtime_error("Undefined variable: " + name);
+        throw std::runtime_error("Undefined variable: " + std::string(Interner::global().name(name)));
     }
 };
 
@@ -87,7 +92,7 @@ public:
 class ASTInterpreter {
 private:
     std::shared_ptr<Environment> environment;
-    std::map<std::string, std::unique_ptr<FunctionDecl>> functions;
+    std::unordered_map<SymbolId, FunctionDecl*> functions;
 
 public:
     ASTInterpreter() {
@@ -98,6 +103,8 @@ public:
 
     // 解释执行AST
     ASTValue interpret(std::unique_ptr<Program>& program);
+    // 在扁平 AST 上解释执行，输出与上面的树遍历一致
+    ASTValue interpret(const flat_ast::Ast& program);
 
     // 访问者模式方法
     ASTValue visit(ASTNode* node);
@@ -111,11 +118,14 @@ public:
     ASTValue visitIdentifier(Identifier* node);
     ASTValue visitLiteral(Literal* node);
     ASTValue visitBinaryOp(BinaryOp* node);
+    ASTValue visitUnaryOp(UnaryOp* node);
     ASTValue visitFunctionCall(FunctionCall* node);
 
 private:
+    ASTValue evaluate(const flat_ast::Ast& ast, flat_ast::Ref node);
+
     void setupBuiltins();
-    ASTValue callBuiltinFunction(const std::string& name,
+    ASTValue callBuiltinFunction(SymbolId name,
                                const std::vector<ASTValue>& args);
 };
 
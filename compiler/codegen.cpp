@@ -4,8 +4,14 @@
 #include <algorithm>
 
 std::string CodeGenerator::generate(const std::unique_ptr<Program>& program) {
+    return generate(flat_ast::Ast::fromProgram(*program));
+}
+
+std::string CodeGenerator::generate(const flat_ast::Ast& program) {
     std::cout << "   ⚙️ 开始生成C++代码..." << std::endl;
 
+    ast = &program;
+
     // 生成C++头部
     output.clear();
     output += "#include <iostream>\n";
@@ -14,8 +20,8 @@ std::string CodeGenerator::generate(const std::unique_ptr<Program>& program) {
     output += "#include <vector>\n\n";
 
     // 生成程序内容
-    for (const auto& stmt : program->statements) {
-        generateStatement(stmt.get());
+    for (flat_ast::Ref stmt : program.statements()) {
+        generateStatement(stmt);
     }
 
     // 如果没有main函数，生成一个默认的
@@ -29,70 +35,64 @@ std::string CodeGenerator::generate(const std::unique_ptr<Program>& program) {
 
     std::cout << "   ✅ C++代码生成完成，共 " << countLines(output) << " 行" << std::endl;
 
+    ast = nullptr;
     return output;
 }
 
-void CodeGenerator::generateStatement(ASTNode* node) {
+void CodeGenerator::generateStatement(flat_ast::Ref node) {
     if (!node) return;
 
-    // 尝试转换为不同类型的节点
-    if (auto funcDecl = dynamic_cast<FunctionDecl*>(node)) {
-        generateFunction(funcDecl);
-    } else if (auto structDecl = dynamic_cast<StructDecl*>(node)) {
-        generateStruct(structDecl);
-    } else if (auto implBlock = dynamic_cast<ImplBlock*>(node)) {
-        generateImplBlock(implBlock);
-    } else if (auto varDecl = dynamic_cast<VariableDecl*>(node)) {
-        generateVariableDecl(varDecl);
-    } else if (auto returnStmt = dynamic_cast<ReturnStmt*>(node)) {
-        generateReturnStmt(returnStmt);
-    } else if (auto exprStmt = dynamic_cast<ExpressionStmt*>(node)) {
-        generateExpressionStmt(exprStmt);
-    } else if (auto block = dynamic_cast<Block*>(node)) {
-        generateBlock(block);
-    }
+    ast->visit(node, [this](const auto& n) {
+        using T = std::decay_t<decltype(n)>;
+        if constexpr (std::is_same_v<T, flat_ast::FunctionDecl>) {
+            generateFunction(n);
+        } else if constexpr (std::is_same_v<T, flat_ast::StructDecl>) {
+            generateStruct(n);
+        } else if constexpr (std::is_same_v<T, flat_ast::ImplBlock>) {
+            generateImplBlock(n);
+        } else if constexpr (std::is_same_v<T, flat_ast::VariableDecl>) {
+            generateVariableDecl(n);
+        } else if constexpr (std::is_same_v<T, flat_ast::ReturnStmt>) {
+            generateReturnStmt(n);
+        } else if constexpr (std::is_same_v<T, flat_ast::ExpressionStmt>) {
+            generateExpressionStmt(n);
+        } else if constexpr (std::is_same_v<T, flat_ast::Block>) {
+            generateBlock(n);
+        }
+    });
 }
 
-void CodeGenerator::generateFunction(FunctionDecl* funcDecl) {
-    output += "\n// 函数: " + funcDecl->name + "\n";
+void CodeGenerator::generateFunction(const flat_ast::FunctionDecl& funcDecl) {
+    std::string funcName(ast->name(funcDecl.symbol));
+    output += "\n// 函数: " + funcName + "\n";
 
     // 确定返回类型
     std::string returnType = "void";
-    if (funcDecl->returnType) {
-        returnType = convertType(funcDecl->returnType->name);
+    if (!funcDecl.returnType.empty()) {
+        returnType = convertType(ast->text(funcDecl.returnType));
     }
 
     // 处理main函数特殊情况
-    if (funcDecl->name == "main" || funcDecl->name == "主函数") {
+    if (funcDecl.symbol == Interner::kMain || funcDecl.symbol == Interner::kMainChinese) {
         returnType = "int";
     }
 
     output += returnType + " ";
 
     // 函数名转换
-    std::string funcName = funcDecl->name;
     if (funcName == "主函数") {
         funcName = "main";
     }
     output += funcName + "(";
 
     // 生成参数列表
-    for (size_t i = 0; i < funcDecl->parameters.size(); ++i) {
-        if (i > 0) output += ", ";
-
-        auto& param = funcDecl->parameters[i];
-        std::string paramType = "auto";
-        if (param->type) {
-            paramType = convertType(param->type->name);
-        }
-        output += paramType + " " + param->name;
-    }
+    generateParameters(funcDecl);
 
     output += ") ";
 
     // 生成函数体
-    if (funcDecl->body) {
-        generateStatement(funcDecl->body.get());
+    if (funcDecl.body) {
+        generateStatement(funcDecl.body);
     } else {
         output += "{\n    // 函数体为空\n}\n";
     }
@@ -100,17 +100,19 @@ void CodeGenerator::generateFunction(FunctionDecl* funcDecl) {
     output += "\n";
 }
 
-void CodeGenerator::generateStruct(StructDecl* structDecl) {
-    output += "\n// 结构体: " + structDecl->name + "\n";
-    output += "struct " + structDecl->name + " {\n";
+void CodeGenerator::generateStruct(const flat_ast::StructDecl& structDecl) {
+    std::string structName(ast->name(structDecl.symbol));
+    output += "\n// 结构体: " + structName + "\n";
+    output += "struct " + structName + " {\n";
 
     // 生成字段
-    for (const auto& field : structDecl->fields) {
+    for (flat_ast::Ref ref : ast->list(structDecl.fields)) {
+        const auto& field = ast->variableDecl(ref);
         output += "    ";
-        if (field->type) {
-            output += convertType(field->type->name) + " " + field->name;
+        if (!field.type.empty()) {
+            output += convertType(ast->text(field.type)) + " " + std::string(ast->name(field.symbol));
         } else {
-            output += "auto " + field->name;
+            output += "auto " + std::string(ast->name(field.symbol));
         }
         output += ";\n";
     }
@@ -118,36 +120,30 @@ void CodeGenerator::generateStruct(StructDecl* structDecl) {
     output += "};\n\n";
 }
 
-void CodeGenerator::generateImplBlock(ImplBlock* implBlock) {
-    output += "\n// 实现块: " + implBlock->structName + "\n";
+void CodeGenerator::generateImplBlock(const flat_ast::ImplBlock& implBlock) {
+    std::string structName(ast->text(implBlock.structName));
+    output += "\n// 实现块: " + structName + "\n";
 
     // 为结构体生成成员函数
-    for (const auto& method : implBlock->methods) {
+    for (flat_ast::Ref ref : ast->list(implBlock.methods)) {
+        const auto& method = ast->functionDecl(ref);
+
         // 生成成员函数的前向声明（在结构体外部）
         std::string returnType = "void";
-        if (method->returnType) {
-            returnType = convertType(method->returnType->name);
+        if (!method.returnType.empty()) {
+            returnType = convertType(ast->text(method.returnType));
         }
 
-        output += returnType + " " + implBlock->structName + "::" + method->name + "(";
+        output += returnType + " " + structName + "::" + std::string(ast->name(method.symbol)) + "(";
 
         // 参数列表
-        for (size_t i = 0; i < method->parameters.size(); ++i) {
-            if (i > 0) output += ", ";
-
-            auto& param = method->parameters[i];
-            std::string paramType = "auto";
-            if (param->type) {
-                paramType = convertType(param->type->name);
-            }
-            output += paramType + " " + param->name;
-        }
+        generateParameters(method);
 
         output += ") ";
 
         // 函数体
-        if (method->body) {
-            generateStatement(method->body.get());
+        if (method.body) {
+            generateStatement(method.body);
         } else {
             output += "{\n    // 方法体为空\n}\n";
         }
@@ -156,105 +152,144 @@ void CodeGenerator::generateImplBlock(ImplBlock* implBlock) {
     }
 }
 
-void CodeGenerator::generateVariableDecl(VariableDecl* varDecl) {
+void CodeGenerator::generateParameters(const flat_ast::FunctionDecl& funcDecl) {
+    auto parameters = ast->list(funcDecl.parameters);
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        if (i > 0) output += ", ";
+
+        const auto& param = ast->variableDecl(parameters[i]);
+        std::string paramType = "auto";
+        if (!param.type.empty()) {
+            paramType = convertType(ast->text(param.type));
+        }
+        output += paramType + " " + std::string(ast->name(param.symbol));
+    }
+}
+
+void CodeGenerator::generateVariableDecl(const flat_ast::VariableDecl& varDecl) {
     output += "    ";
 
-    if (varDecl->type) {
-        output += convertType(varDecl->type->name) + " " + varDecl->name;
+    if (!varDecl.type.empty()) {
+        output += convertType(ast->text(varDecl.type)) + " " + std::string(ast->name(varDecl.symbol));
     } else {
-        output += "auto " + varDecl->name;
+        output += "auto " + std::string(ast->name(varDecl.symbol));
     }
 
-    if (varDecl->initializer) {
+    if (varDecl.initializer) {
         output += " = ";
-        generateExpression(varDecl->initializer.get());
+        generateExpression(varDecl.initializer);
     }
 
     output += ";\n";
 }
 
-void CodeGenerator::generateReturnStmt(ReturnStmt* returnStmt) {
+void CodeGenerator::generateReturnStmt(const flat_ast::ReturnStmt& returnStmt) {
     output += "    return";
 
-    if (returnStmt->value) {
+    if (returnStmt.value) {
         output += " ";
-        generateExpression(returnStmt->value.get());
+        generateExpression(returnStmt.value);
     }
 
     output += ";\n";
 }
 
-void CodeGenerator::generateExpressionStmt(ExpressionStmt* exprStmt) {
+void CodeGenerator::generateExpressionStmt(const flat_ast::ExpressionStmt& exprStmt) {
     output += "    ";
-    generateExpression(exprStmt->expression.get());
+    generateExpression(exprStmt.expression);
     output += ";\n";
 }
 
-void CodeGenerator::generateBlock(Block* block) {
+void CodeGenerator::generateBlock(const flat_ast::Block& block) {
     output += "{\n";
 
-    for (const auto& stmt : block->statements) {
-        generateStatement(stmt.get());
+    for (flat_ast::Ref stmt : ast->list(block.statements)) {
+        generateStatement(stmt);
     }
 
     output += "}\n";
 }
 
-void CodeGenerator::generateExpression(ASTNode* expr) {
+void CodeGenerator::generateExpression(flat_ast::Ref expr) {
     if (!expr) return;
 
-    if (auto identifier = dynamic_cast<Identifier*>(expr)) {
-        output += identifier->name;
-    } else if (auto literal = dynamic_cast<Literal*>(expr)) {
-        generateLiteral(literal);
-    } else if (auto binaryOp = dynamic_cast<BinaryOp*>(expr)) {
-        generateBinaryOp(binaryOp);
-    } else if (auto funcCall = dynamic_cast<FunctionCall*>(expr)) {
-        generateFunctionCall(funcCall);
-    }
+    ast->visit(expr, [this](const auto& n) {
+        using T = std::decay_t<decltype(n)>;
+        if constexpr (std::is_same_v<T, flat_ast::Identifier>) {
+            output += ast->name(n.symbol);
+        } else if constexpr (std::is_same_v<T, flat_ast::Literal>) {
+            generateLiteral(n);
+        } else if constexpr (std::is_same_v<T, flat_ast::BinaryOp>) {
+            generateBinaryOp(n);
+        } else if constexpr (std::is_same_v<T, flat_ast::UnaryOp>) {
+            output += flat_ast::spelling(n.op);
+            generateOperand(n.operand);
+        } else if constexpr (std::is_same_v<T, flat_ast::FunctionCall>) {
+            generateFunctionCall(n);
+        }
+    });
 }
 
-void CodeGenerator::generateFunctionCall(FunctionCall* funcCall) {
+void CodeGenerator::generateFunctionCall(const flat_ast::FunctionCall& funcCall) {
+    auto arguments = ast->list(funcCall.arguments);
+
     // 检查是否是内置的print函数
-    if (funcCall->name == "print" || funcCall->name == "打印") {
+    if (funcCall.symbol == Interner::kPrint || funcCall.symbol == Interner::kPrintChinese) {
         output += "std::cout";
 
         // 处理参数
-        for (size_t i = 0; i < funcCall->arguments.size(); ++i) {
+        for (size_t i = 0; i < arguments.size(); ++i) {
             output += " << ";
-            generateExpression(funcCall->arguments[i].get());
+            // << 的优先级高于比较与逻辑运算，运算表达式须加括号
+            generateOperand(arguments[i]);
         }
 
         // 自动添加换行
         output += " << std::endl";
     } else {
         // 普通函数调用
-        output += funcCall->name + "(";
+        output += std::string(ast->name(funcCall.symbol)) + "(";
 
-        for (size_t i = 0; i < funcCall->arguments.size(); ++i) {
+        for (size_t i = 0; i < arguments.size(); ++i) {
             if (i > 0) output += ", ";
-            generateExpression(funcCall->arguments[i].get());
+            generateExpression(arguments[i]);
         }
 
         output += ")";
     }
 }
 
-void CodeGenerator::generateLiteral(Literal* literal) {
-    if (literal->type == "string") {
-        output += "\"" + literal->value + "\"";
+void CodeGenerator::generateLiteral(const flat_ast::Literal& literal) {
+    std::string_view value = ast->text(literal.value);
+    if (literal.type == flat_ast::LiteralType::String) {
+        output += "\"" + std::string(value) + "\"";
+    } else if (literal.type == flat_ast::LiteralType::Int) {
+        output += std::to_string(literal.intValue);
+    } else if (literal.type == flat_ast::LiteralType::Float) {
+        // 去掉数字分隔符 _（目标代码不支持）
+        std::string text(value);
+        text.erase(std::remove(text.begin(), text.end(), '_'), text.end());
+        output += text;
     } else {
-        output += literal->value;
+        output += value;
     }
 }
 
-void CodeGenerator::generateBinaryOp(BinaryOp* binaryOp) {
-    generateExpression(binaryOp->left.get());
-    output += " " + binaryOp->operator_ + " ";
-    generateExpression(binaryOp->right.get());
+void CodeGenerator::generateBinaryOp(const flat_ast::BinaryOp& binaryOp) {
+    generateOperand(binaryOp.left);
+    output += " " + std::string(flat_ast::spelling(binaryOp.op)) + " ";
+    generateOperand(binaryOp.right);
+}
+
+void CodeGenerator::generateOperand(flat_ast::Ref operand) {
+    // 嵌套的运算加上括号，保持 AST 的结合顺序（源码中的括号不会保留在 AST 里）
+    bool nested = operand && (operand.kind() == NodeKind::BinaryOp || operand.kind() == NodeKind::UnaryOp);
+    if (nested) output += "(";
+    generateExpression(operand);
+    if (nested) output += ")";
 }
 
-std::string CodeGenerator::convertType(const std::string& polyglotType) {
+std::string CodeGenerator::convertType(std::string_view polyglotType) {
     // polyglot类型到C++类型的映射
     if (polyglotType == "整数" || polyglotType == "int" || polyglotType == "i32") {
         return "int";
@@ -270,7 +305,7 @@ std::string CodeGenerator::convertType(const std::string& polyglotType) {
         return "char";
     } else {
         // 默认返回原类型名（可能是用户定义的结构体）
-        return polyglotType;
+        return std::string(polyglotType);
     }
 }
 
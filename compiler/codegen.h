@@ -1,28 +1,37 @@
 #pragma once
 
 #include "ast.h"
+#include "flat_ast.h"
+#include <memory>
 #include <string>
 
+// 代码生成在扁平 AST 上进行：整程序遍历只访问连续数组
 class CodeGenerator {
 private:
     std::string output;
+    const flat_ast::Ast* ast = nullptr;
 
-    void generateStatement(ASTNode* node);
-    void generateFunction(FunctionDecl* funcDecl);
-    void generateStruct(StructDecl* structDecl);
-    void generateImplBlock(ImplBlock* implBlock);
-    void generateVariableDecl(VariableDecl* varDecl);
-    void generateReturnStmt(ReturnStmt* returnStmt);
-    void generateExpressionStmt(ExpressionStmt* exprStmt);
-    void generateBlock(Block* block);
-    void generateExpression(ASTNode* expr);
-    void generateFunctionCall(FunctionCall* funcCall);
-    void generateLiteral(Literal* literal);
-    void generateBinaryOp(BinaryOp* binaryOp);
+    void generateStatement(flat_ast::Ref node);
+    void generateFunction(const flat_ast::FunctionDecl& funcDecl);
+    void generateStruct(const flat_ast::StructDecl& structDecl);
+    void generateImplBlock(const flat_ast::ImplBlock& implBlock);
+    void generateParameters(const flat_ast::FunctionDecl& funcDecl);
+    void generateVariableDecl(const flat_ast::VariableDecl& varDecl);
+    void generateReturnStmt(const flat_ast::ReturnStmt& returnStmt);
+    void generateExpressionStmt(const flat_ast::ExpressionStmt& exprStmt);
+    void generateBlock(const flat_ast::Block& block);
+    void generateExpression(flat_ast::Ref expr);
+    void generateFunctionCall(const flat_ast::FunctionCall& funcCall);
+    void generateLiteral(const flat_ast::Literal& literal);
+    void generateBinaryOp(const flat_ast::BinaryOp& binaryOp);
+    // 运算的操作数：嵌套的运算加括号
+    void generateOperand(flat_ast::Ref operand);
 
-    std::string convertType(const std::string& polyglotType);
+    std::string convertType(std::string_view polyglotType);
     int countLines(const std::string& code);
 
 public:
+    // 先把指针树转换为扁平 AST，再生成
     std::string generate(const std::unique_ptr<Program>& program);
+    std::string generate(const flat_ast::Ast& program);
 };
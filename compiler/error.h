@@ -58,4 +58,10 @@ class CodeGenError : public CompilerError {
 public:
     CodeGenError(const std::string& msg)
         : CompilerError("代码生成错误: " + msg) {}
+};
+
+class RuntimeError : public CompilerError {
+public:
+    RuntimeError(const std::string& msg)
+        : CompilerError("运行时错误: " + msg) {}
 };
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "flat_ast.h"
+#include "error.h"
+#include <array>
+
+namespace flat_ast {
+
+namespace {
+
+constexpr std::array<std::string_view, static_cast<size_t>(Operator::Not) + 1> kSpellings = {
+    "=", "+=", "-=",
+    "||", "&&",
+    "==", "!=",
+    "<", ">", "<=", ">=",
+    "+", "-", "*", "/", "%",
+    "!",
+};
+
+Operator operatorFromSpelling(std::string_view text) {
+    for (size_t i = 0; i < kSpellings.size(); ++i) {
+        if (kSpellings[i] == text) return static_cast<Operator>(i);
+    }
+    throw CompilerError("扁平 AST 不支持的运算符: " + std::string(text));
+}
+
+LiteralType literalTypeFromName(std::string_view type) {
+    if (type == "int") return LiteralType::Int;
+    if (type == "float") return LiteralType::Float;
+    if (type == "string") return LiteralType::String;
+    if (type == "bool") return LiteralType::Bool;
+    return LiteralType::Char;
+}
+
+}  // namespace
+
+std::string_view spelling(Operator op) {
+    return kSpellings[static_cast<size_t>(op)];
+}
+
+// 树到扁平数组的转换：子节点先于父节点写入，列表先收集到局部数组再整体追加到 extra，
+// 保证每个列表在 extra 中连续。
+class Builder {
+private:
+    Ast& ast;
+
+    template <typename T>
+    static Ref push(std::vector<T>& nodes, NodeKind kind, const T& node) {
+        if (nodes.size() > Ref::kIndexMask) {
+            throw CompilerError("扁平 AST 单种节点数超出上限");
+        }
+        nodes.push_back(node);
+        return Ref(kind, static_cast<uint32_t>(nodes.size() - 1));
+    }
+
+    Text text(std::string_view value) {
+        Text range{static_cast<uint32_t>(ast.strings.size()), static_cast<uint32_t>(value.size())};
+        ast.strings.append(value);
+        return range;
+    }
+
+    Text typeName(const TypeNode* type) {
+        return type ? text(type->name) : Text{};
+    }
+
+    template <typename T>
+    List list(const NodeList<T*>& nodes) {
+        std::vector<Ref> refs;
+        refs.reserve(nodes.size());
+        for (T* node : nodes) {
+            refs.push_back(convert(node));
+        }
+        return append(refs);
+    }
+
+    List append(const std::vector<Ref>& refs) {
+        List range{static_cast<uint32_t>(ast.extra.size()), static_cast<uint32_t>(refs.size())};
+        ast.extra.insert(ast.extra.end(), refs.begin(), refs.end());
+        return range;
+    }
+
+public:
+    explicit Builder(Ast& target) : ast(target) {}
+
+    Ref convert(ASTNode* node) {
+        if (!node) return Ref();
+
+        return ::visit(node, [this](auto* n) -> Ref {
+            using T = std::remove_pointer_t<decltype(n)>;
+            if constexpr (std::is_same_v<T, ::ImportDecl>) {
+                return push(ast.imports, T::kKind, flat_ast::ImportDecl{text(n->moduleName)});
+            } else if constexpr (std::is_same_v<T, ::VariableDecl>) {
+                Ref initializer = convert(n->initializer);
+                return push(ast.variables, T::kKind,
+                            flat_ast::VariableDecl{n->symbol, typeName(n->type), initializer, n->isConst});
+            } else if constexpr (std::is_same_v<T, ::FunctionDecl>) {
+                List parameters = list(n->parameters);
+                // 骨架模式下尚未解析的函数体为空（入口函数的函数体已在 convertProgram 中解析）
+                Ref body = convert(n->body);
+                return push(ast.functions, T::kKind,
+                            flat_ast::FunctionDecl{n->symbol, typeName(n->returnType), parameters, body});
+            } else if constexpr (std::is_same_v<T, ::StructDecl>) {
+                List fields = list(n->fields);
+                return push(ast.structs, T::kKind, flat_ast::StructDecl{n->symbol, fields});
+            } else if constexpr (std::is_same_v<T, ::ImplBlock>) {
+                List methods = list(n->methods);
+                return push(ast.impls, T::kKind, flat_ast::ImplBlock{text(n->structName), methods});
+            } else if constexpr (std::is_same_v<T, ::Block>) {
+                List statements = list(n->statements);
+                return push(ast.blocks, T::kKind, flat_ast::Block{statements});
+            } else if constexpr (std::is_same_v<T, ::ReturnStmt>) {
+                Ref value = convert(n->value);
+                return push(ast.returns, T::kKind, flat_ast::ReturnStmt{value});
+            } else if constexpr (std::is_same_v<T, ::ExpressionStmt>) {
+                Ref expression = convert(n->expression);
+                return push(ast.expressionStmts, T::kKind, flat_ast::ExpressionStmt{expression});
+            } else if constexpr (std::is_same_v<T, ::Identifier>) {
+                return push(ast.identifiers, T::kKind, flat_ast::Identifier{n->symbol});
+            } else if constexpr (std::is_same_v<T, ::Literal>) {
+                flat_ast::Literal literal{text(n->value), literalTypeFromName(n->type), {0}};
+                if (literal.type == LiteralType::Float) {
+                    literal.floatValue = n->floatValue;
+                } else {
+                    literal.intValue = n->intValue;
+                }
+                return push(ast.literals, T::kKind, literal);
+            } else if constexpr (std::is_same_v<T, ::BinaryOp>) {
+                Ref left = convert(n->left);
+                Ref right = convert(n->right);
+                return push(ast.binaryOps, T::kKind,
+                            flat_ast::BinaryOp{left, right, operatorFromSpelling(n->operator_)});
+            } else if constexpr (std::is_same_v<T, ::UnaryOp>) {
+                Ref operand = convert(n->operand);
+                return push(ast.unaryOps, T::kKind, flat_ast::UnaryOp{operand, operatorFromSpelling(n->operator_)});
+            } else if constexpr (std::is_same_v<T, ::FunctionCall>) {
+                List arguments = list(n->arguments);
+                return push(ast.calls, T::kKind, flat_ast::FunctionCall{n->symbol, arguments});
+            } else {
+                // Program 不会嵌套出现，TypeNode 已折叠进声明
+                throw CompilerError("扁平 AST 无法转换该节点");
+            }
+        });
+    }
+
+    void convertProgram(Program& program) {
+        std::vector<Ref> statements;
+        statements.reserve(program.statements.size());
+        for (ASTNode* stmt : program.statements) {
+            // 解释执行的入口只在顶层函数中查找，实现块里同名的方法不算
+            auto function = nodeCast<::FunctionDecl>(stmt);
+            if (function && (function->symbol == Interner::kMain || function->symbol == Interner::kMainChinese)) {
+                function->getBody();
+            }
+            statements.push_back(convert(stmt));
+        }
+        ast.topLevel = append(statements);
+    }
+};
+
+Ast Ast::fromProgram(Program& program) {
+    Ast ast;
+    Builder(ast).convertProgram(program);
+    return ast;
+}
+
+size_t Ast::nodeCount() const {
+    return imports.size() + variables.size() + functions.size() + structs.size() + impls.size() +
+           blocks.size() + returns.size() + expressionStmts.size() + identifiers.size() + literals.size() +
+           binaryOps.size() + unaryOps.size() + calls.size();
+}
+
+size_t Ast::bytesUsed() const {
+    return imports.size() * sizeof(ImportDecl) + variables.size() * sizeof(VariableDecl) +
+           functions.size() * sizeof(FunctionDecl) + structs.size() * sizeof(StructDecl) +
+           impls.size() * sizeof(ImplBlock) + blocks.size() * sizeof(Block) + returns.size() * sizeof(ReturnStmt) +
+           expressionStmts.size() * sizeof(ExpressionStmt) + identifiers.size() * sizeof(Identifier) +
+           literals.size() * sizeof(Literal) + binaryOps.size() * sizeof(BinaryOp) +
+           unaryOps.size() * sizeof(UnaryOp) + calls.size() * sizeof(FunctionCall) + extra.size() * sizeof(Ref) +
+           strings.size();
+}
+
+}  // namespace flat_ast
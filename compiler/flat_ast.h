@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast.h"
+
+// 扁平 AST：同一种类的节点存放在一个连续数组中，子节点用 32 位引用（种类 + 下标）相连，
+// 变长的子节点列表统一存放在 extra 数组，文本存放在一个字符串池。
+// 由 Program 一次转换得到，转换后只读；供解释执行、代码生成等整程序遍历使用。
+// 名字只保存驻留编号；类型名直接记在声明上，不再单独成为 TypeNode。
+namespace flat_ast {
+
+// 节点引用：高 4 位为 NodeKind，低 28 位为该种类数组中的下标
+struct Ref {
+    static constexpr uint32_t kNone = UINT32_MAX;
+    static constexpr uint32_t kIndexBits = 28;
+    static constexpr uint32_t kIndexMask = (1u << kIndexBits) - 1;
+
+    uint32_t bits = kNone;
+
+    Ref() = default;
+    Ref(NodeKind kind, uint32_t index) : bits(static_cast<uint32_t>(kind) << kIndexBits | index) {}
+
+    bool empty() const { return bits == kNone; }
+    explicit operator bool() const { return !empty(); }
+    NodeKind kind() const { return static_cast<NodeKind>(bits >> kIndexBits); }
+    uint32_t index() const { return bits & kIndexMask; }
+};
+
+// 字符串池中的一段文本；length 为 0 表示没有（如未写类型）
+struct Text {
+    uint32_t offset = 0;
+    uint32_t length = 0;
+
+    bool empty() const { return length == 0; }
+};
+
+// extra 数组中的一段子节点引用
+struct List {
+    uint32_t begin = 0;
+    uint32_t count = 0;
+};
+
+// 运算符：spelling() 给出源码写法
+enum class Operator : uint8_t {
+    Assign, PlusAssign, MinusAssign,
+    Or, And,
+    Equal, NotEqual,
+    Less, Greater, LessEqual, GreaterEqual,
+    Add, Subtract, Multiply, Divide, Modulo,
+    Not,
+};
+
+std::string_view spelling(Operator op);
+
+enum class LiteralType : uint8_t { Int, Float, String, Bool, Char };
+
+struct ImportDecl {
+    Text moduleName;
+};
+
+struct VariableDecl {
+    SymbolId symbol;
+    Text type;
+    Ref initializer;
+    bool isConst;
+};
+
+struct FunctionDecl {
+    SymbolId symbol;
+    Text returnType;
+    List parameters;  // VariableDecl
+    Ref body;  // 骨架模式下未用到、尚未解析的函数体为空
+};
+
+struct StructDecl {
+    SymbolId symbol;
+    List fields;  // VariableDecl
+};
+
+struct ImplBlock {
+    Text structName;
+    List methods;  // FunctionDecl
+};
+
+struct Block {
+    List statements;
+};
+
+struct ReturnStmt {
+    Ref value;
+};
+
+struct ExpressionStmt {
+    Ref expression;
+};
+
+struct Identifier {
+    SymbolId symbol;
+};
+
+struct Literal {
+    Text value;  // 源码写法
+    LiteralType type;
+    union {
+        int64_t intValue;
+        double floatValue;
+    };
+};
+
+struct BinaryOp {
+    Ref left;
+    Ref right;
+    Operator op;
+};
+
+struct UnaryOp {
+    Ref operand;
+    Operator op;
+};
+
+struct FunctionCall {
+    SymbolId symbol;
+    List arguments;
+};
+
+class Ast {
+private:
+    std::vector<ImportDecl> imports;
+    std::vector<VariableDecl> variables;
+    std::vector<FunctionDecl> functions;
+    std::vector<StructDecl> structs;
+    std::vector<ImplBlock> impls;
+    std::vector<Block> blocks;
+    std::vector<ReturnStmt> returns;
+    std::vector<ExpressionStmt> expressionStmts;
+    std::vector<Identifier> identifiers;
+    std::vector<Literal> literals;
+    std::vector<BinaryOp> binaryOps;
+    std::vector<UnaryOp> unaryOps;
+    std::vector<FunctionCall> calls;
+
+    std::vector<Ref> extra;
+    std::string strings;
+    List topLevel;
+
+    friend class Builder;
+
+public:
+    // 从指针树转换；树中不出现的节点（如 TypeNode）折叠进父节点。
+    // 骨架模式下只转换已解析的函数体；顶层入口函数的函数体若尚未解析则先解析（可能抛出 ParserError）
+    static Ast fromProgram(Program& program);
+
+    // 顶层语句，按源码顺序
+    NodeList<const Ref> statements() const { return list(topLevel); }
+
+    NodeList<const Ref> list(List range) const {
+        return NodeList<const Ref>(extra.data() + range.begin, range.count);
+    }
+
+    std::string_view text(Text range) const { return std::string_view(strings).substr(range.offset, range.length); }
+    static std::string_view name(SymbolId symbol) { return Interner::global().name(symbol); }
+
+    const ImportDecl& importDecl(Ref ref) const { return imports[ref.index()]; }
+    const VariableDecl& variableDecl(Ref ref) const { return variables[ref.index()]; }
+    const FunctionDecl& functionDecl(Ref ref) const { return functions[ref.index()]; }
+    const StructDecl& structDecl(Ref ref) const { return structs[ref.index()]; }
+    const ImplBlock& implBlock(Ref ref) const { return impls[ref.index()]; }
+    const Block& block(Ref ref) const { return blocks[ref.index()]; }
+    const ReturnStmt& returnStmt(Ref ref) const { return returns[ref.index()]; }
+    const ExpressionStmt& expressionStmt(Ref ref) const { return expressionStmts[ref.index()]; }
+    const Identifier& identifier(Ref ref) const { return identifiers[ref.index()]; }
+    const Literal& literal(Ref ref) const { return literals[ref.index()]; }
+    const BinaryOp& binaryOp(Ref ref) const { return binaryOps[ref.index()]; }
+    const UnaryOp& unaryOp(Ref ref) const { return unaryOps[ref.index()]; }
+    const FunctionCall& functionCall(Ref ref) const { return calls[ref.index()]; }
+
+    // 节点总数与占用的字节数（按各数组的元素个数计）
+    size_t nodeCount() const;
+    size_t bytesUsed() const;
+
+    // 按引用的种类分派：以具体节点的 const 引用调用 visitor；ref 不能为空
+    template <typename Visitor>
+    decltype(auto) visit(Ref ref, Visitor&& visitor) const {
+        switch (ref.kind()) {
+            case NodeKind::ImportDecl: return visitor(importDecl(ref));
+            case NodeKind::VariableDecl: return visitor(variableDecl(ref));
+            case NodeKind::FunctionDecl: return visitor(functionDecl(ref));
+            case NodeKind::StructDecl: return visitor(structDecl(ref));
+            case NodeKind::ImplBlock: return visitor(implBlock(ref));
+            case NodeKind::Block: return visitor(block(ref));
+            case NodeKind::ReturnStmt: return visitor(returnStmt(ref));
+            case NodeKind::ExpressionStmt: return visitor(expressionStmt(ref));
+            case NodeKind::Identifier: return visitor(identifier(ref));
+            case NodeKind::Literal: return visitor(literal(ref));
+            case NodeKind::BinaryOp: return visitor(binaryOp(ref));
+            case NodeKind::UnaryOp: return visitor(unaryOp(ref));
+            case NodeKind::FunctionCall: return visitor(functionCall(ref));
+            case NodeKind::Program:
+            case NodeKind::TypeNode:
+                break;
+        }
+        std::abort();  // 扁平 AST 中没有这两种节点
+    }
+};
+
+}  // namespace flat_ast
@@ -0,0 +1,194 @@
+#include "incremental_lexer.h"
+#include "error.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+// 间隙不够时整体搬一次，另外预留这么多字节再加上源码长度的一半，编辑引起的搬移因此是均摊常数
+constexpr size_t kMinGap = 4096;
+
+}  // namespace
+
+IncrementalLexer::IncrementalLexer(std::string_view source) {
+    source = utf8::stripBom(source);
+    if (source.length() > UINT32_MAX) {
+        throw LexerError("源码超过 4GB，无法扫描", 1, 1);
+    }
+
+    // 间隙起初放在开头（行首），整个源码都在间隙之后
+    text.assign(kMinGap, '\0');
+    text.append(source);
+    gapBegin = 0;
+    gapEnd = kMinGap;
+
+    const std::string_view view(text.data() + gapEnd, source.length());
+    Lexer lexer(view);
+    const std::vector<Token> scanned = lexer.scan().toTokens();
+    before.reserve(scanned.size());
+    for (const Token& token : scanned) {
+        before.push_back(Entry{token.type, static_cast<uint32_t>(token.text.length()),
+                               static_cast<size_t>(token.text.data() - view.data()), token.line, token.number});
+    }
+    lastLine = scanned.back().line;
+}
+
+void IncrementalLexer::moveTextGap(size_t offset) {
+    if (offset < gapBegin) {
+        const size_t count = gapBegin - offset;
+        std::memmove(&text[gapEnd - count], &text[offset], count);
+        gapBegin -= count;
+        gapEnd -= count;
+    } else if (offset > gapBegin) {
+        const size_t count = offset - gapBegin;
+        std::memmove(&text[gapBegin], &text[gapEnd], count);
+        gapBegin += count;
+        gapEnd += count;
+    }
+}
+
+void IncrementalLexer::replaceText(size_t offset, size_t length, std::string_view replacement) {
+    moveTextGap(offset);
+    gapEnd += length;
+    if (gapEnd - gapBegin < replacement.length()) {
+        const size_t tail = text.size() - gapEnd;
+        const size_t gap = replacement.length() + kMinGap + sourceSize() / 2;
+        std::string grown(gapBegin + gap + tail, '\0');
+        std::memcpy(&grown[0], text.data(), gapBegin);
+        std::memcpy(&grown[gapBegin + gap], text.data() + gapEnd, tail);
+        text.swap(grown);
+        gapEnd = gapBegin + gap;
+    }
+    if (!replacement.empty()) {
+        std::memcpy(&text[gapBegin], replacement.data(), replacement.length());
+        gapBegin += replacement.length();
+    }
+}
+
+// x 与 sourceSize() - x、line 与 lastLine - line 互为换算，两个方向是同一个公式
+void IncrementalLexer::shiftAfter() {
+    Entry moved = before.back();
+    before.pop_back();
+    moved.position = sourceSize() - moved.position;
+    moved.line = lastLine - moved.line;
+    after.push_back(moved);
+}
+
+void IncrementalLexer::shiftBefore() {
+    Entry moved = after.back();
+    after.pop_back();
+    moved.position = sourceSize() - moved.position;
+    moved.line = lastLine - moved.line;
+    before.push_back(moved);
+}
+
+RelexResult IncrementalLexer::relex(EditRange edit, std::string_view newText) {
+    const size_t oldLength = sourceSize();
+    if (edit.offset > oldLength || edit.length > oldLength - edit.offset) {
+        throw std::out_of_range("IncrementalLexer::relex 编辑区间超出源码范围");
+    }
+    if (oldLength - edit.length + newText.length() > UINT32_MAX) {
+        throw LexerError("源码超过 4GB，无法扫描", 1, 1);
+    }
+
+    // Token 的间隙先移到编辑位置，再退到这一行的行首：重启点紧跟在编辑位置之前最后一个完整的 NEWLINE 之后，
+    // 此处一定位于行首且不在注释或字符串中
+    while (!before.empty() && before.back().position >= edit.offset) {
+        shiftAfter();
+    }
+    while (!after.empty() && oldLength - after.back().position < edit.offset) {
+        shiftBefore();
+    }
+    while (!before.empty() && !(before.back().type == TokenType::NEWLINE &&
+                                before.back().position + before.back().length <= edit.offset)) {
+        shiftAfter();
+    }
+    const size_t restartIndex = before.size();
+    const size_t restartOffset = before.empty() ? 0 : before.back().position + before.back().length;
+    const int restartLine = before.empty() ? 1 : before.back().line + 1;
+
+    // 改写源码后把间隙停在重启点，需要重新扫描的 [restartOffset, 末尾) 因此是连续的
+    moveTextGap(edit.offset);
+    const std::string removed(text.data() + gapEnd, edit.length);
+    replaceText(edit.offset, edit.length, newText);
+    moveTextGap(restartOffset);
+
+    // 从重启点扫描；在编辑之后遇到与旧序列同一位置的 NEWLINE 时视为重新对齐。
+    // 编辑之后的旧Token到源码末尾的距离不变，因此 after 中的记录可以直接比较
+    const size_t length = sourceSize();
+    const size_t editEnd = edit.offset + newText.length();
+    const std::string_view rest(text.data() + gapEnd, length - restartOffset);
+    Lexer lexer(rest, SourcePosition{restartLine, 1});
+    size_t oldIndex = after.size();  // after[oldIndex - 1] 是还没越过的第一个旧Token
+    bool synced = false;
+    try {
+        while (!lexer.finished) {
+            lexer.scanToken();
+            const TokenStore& scanned = lexer.store;
+            const size_t last = scanned.size() - 1;
+            if (scanned.kind(last) != TokenType::NEWLINE) continue;
+            const size_t offset = restartOffset + scanned.offset(last);
+            if (offset < editEnd) continue;
+
+            const size_t toEnd = length - offset;
+            while (oldIndex > 0 && after[oldIndex - 1].position > toEnd) {
+                --oldIndex;
+            }
+            if (oldIndex > 0 && after[oldIndex - 1].position == toEnd &&
+                after[oldIndex - 1].type == TokenType::NEWLINE) {
+                synced = true;
+                break;
+            }
+        }
+    } catch (...) {
+        // 撤销这次编辑，Token序列还没有改动
+        replaceText(edit.offset, newText.length(), removed);
+        moveTextGap(restartOffset);
+        throw;
+    }
+
+    // 新扫描的Token接在间隙之前；旧序列中被替换的部分到对齐的 NEWLINE 为止（没有对齐则到 EOF）
+    const std::vector<Token> relexed = lexer.store.toTokens(PositionCursor(rest, 0, SourcePosition{restartLine, 1}));
+    const size_t kept = synced ? oldIndex - 1 : 0;
+    RelexResult result;
+    result.changedBegin = restartIndex;
+    result.changedEnd = restartIndex + relexed.size();
+    result.oldChangedEnd = restartIndex + (after.size() - kept);
+
+    lastLine = synced ? relexed.back().line + after[oldIndex - 1].line : relexed.back().line;
+    after.erase(after.begin() + static_cast<std::ptrdiff_t>(kept), after.end());
+    for (const Token& token : relexed) {
+        before.push_back(Entry{token.type, static_cast<uint32_t>(token.text.length()),
+                               restartOffset + static_cast<size_t>(token.text.data() - rest.data()), token.line,
+                               token.number});
+    }
+    return result;
+}
+
+std::string IncrementalLexer::sourceText() const {
+    std::string source(text.data(), gapBegin);
+    source.append(text.data() + gapEnd, text.size() - gapEnd);
+    return source;
+}
+
+Token IncrementalLexer::token(size_t i) const {
+    // 列号从行首数到词素开头；间隙总在行首，同一行的文本不会跨过间隙
+    const size_t start = offset(i);
+    const size_t segmentBegin = start >= gapBegin ? gapBegin : 0;
+    const std::string_view segment(textAt(segmentBegin), start - segmentBegin);
+    const size_t newline = segment.rfind('\n');
+    const std::string_view prefix = newline == std::string_view::npos ? segment : segment.substr(newline + 1);
+
+    Token materialized(kind(i), lexeme(i), line(i), locateOffset(prefix, prefix.length()).column);
+    materialized.number = entry(i).number;
+    return materialized;
+}
+
+std::vector<Token> IncrementalLexer::tokens() const {
+    std::vector<Token> result;
+    result.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+        result.push_back(token(i));
+    }
+    return result;
+}
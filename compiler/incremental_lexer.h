@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "lexer.h"
+
+// 源码编辑：把 [offset, offset + length) 的字节替换为新文本（偏移从 BOM 之后算起，与 Token 偏移一致）
+struct EditRange {
+    size_t offset;
+    size_t length;
+};
+
+// relex 的结果：新序列中重新扫描得到的Token为 [changedBegin, changedEnd)，
+// 它们替换了旧序列中的 [changedBegin, oldChangedEnd)
+struct RelexResult {
+    size_t changedBegin = 0;
+    size_t changedEnd = 0;
+    size_t oldChangedEnd = 0;
+};
+
+// 增量词法分析（编辑器场景）：持有一份可编辑的源码及其完整的Token序列（保留 NEWLINE，不折叠换行）。
+// 源码与Token序列都存放在间隙缓冲区中，间隙停在最近一次重新扫描的起点（总在行首）：
+// 间隙之前的Token记绝对偏移与行号，之后的记到源码末尾的距离，插入或删除文本时后者不必逐个平移。
+// 一次 relex 的代价只与编辑长度、重新扫描的行数以及间隙移动的距离（与上次编辑位置的远近）有关，与文件大小无关。
+class IncrementalLexer {
+private:
+    struct Entry {
+        TokenType type;
+        uint32_t length;
+        size_t position;  // 间隙之前：源码偏移；之后：到源码末尾的字节数
+        int line;         // 间隙之前：行号；之后：到 EOF 所在行的行数
+        NumberValue number;
+    };
+
+    // 源码：[gapBegin, gapEnd) 是间隙，逻辑偏移不计间隙
+    std::string text;
+    size_t gapBegin = 0;
+    size_t gapEnd = 0;
+    // Token：before 按源码顺序，after 逆序存放（back() 紧跟在间隙之后）
+    std::vector<Entry> before;
+    std::vector<Entry> after;
+    int lastLine = 1;  // EOF 所在的行
+
+    const char* textAt(size_t offset) const {
+        return text.data() + (offset < gapBegin ? offset : offset + (gapEnd - gapBegin));
+    }
+    const Entry& entry(size_t i) const {
+        return i < before.size() ? before[i] : after[after.size() - 1 - (i - before.size())];
+    }
+    void moveTextGap(size_t offset);
+    void replaceText(size_t offset, size_t length, std::string_view replacement);
+    // 把间隙两侧紧邻的一个Token移到另一侧（两种记法互相换算）
+    void shiftBefore();
+    void shiftAfter();
+
+public:
+    explicit IncrementalLexer(std::string_view source);
+
+    // 把 edit 区间替换为 newText：从编辑位置之前最近的换行处重新扫描，
+    // 直到新旧Token流在编辑之后的某个换行处重新对齐。扫描报错时撤销这次编辑并抛出 LexerError
+    RelexResult relex(EditRange edit, std::string_view newText);
+
+    size_t size() const { return before.size() + after.size(); }
+    size_t sourceSize() const { return text.size() - (gapEnd - gapBegin); }
+    std::string sourceText() const;
+
+    TokenType kind(size_t i) const { return entry(i).type; }
+    size_t offset(size_t i) const {
+        return i < before.size() ? before[i].position : sourceSize() - entry(i).position;
+    }
+    int line(size_t i) const { return i < before.size() ? before[i].line : lastLine - entry(i).line; }
+    // 词素视图在下一次 relex 之前有效
+    std::string_view lexeme(size_t i) const { return std::string_view(textAt(offset(i)), entry(i).length); }
+
+    // 物化第 i 个Token（列号从行首按需计算）；视图同样只在下一次 relex 之前有效
+    Token token(size_t i) const;
+    std::vector<Token> tokens() const;
+};
@@ -0,0 +1,36 @@
+#include "interner.h"
+
+Interner::Interner() {
+    // 顺序须与头文件中的内置编号一致
+    for (std::string_view builtin : {"print", "打印", "main", "主函数"}) {
+        intern(builtin);
+    }
+}
+
+Interner& Interner::global() {
+    static Interner instance;
+    return instance;
+}
+
+SymbolId Interner::intern(std::string_view text) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = ids.find(text);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    SymbolId id = static_cast<SymbolId>(names.size());
+    names.emplace_back(text);
+    ids.emplace(names.back(), id);
+    return id;
+}
+
+std::string_view Interner::name(SymbolId id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (id >= names.size()) return std::string_view();
+    return names[id];
+}
+
+size_t Interner::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return names.size();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// 名字的驻留编号：同一进程内相同的名字总是得到同一个编号，编号从 0 开始连续分配
+using SymbolId = uint32_t;
+
+// 标识符/字符串驻留表（进程级别，多线程安全）
+// 语法分析时把名字驻留一次，之后语义分析与解释执行都按编号查找，不再哈希或比较字符串。
+// 名字存放在不会移动的节点中，name() 返回的视图在进程结束前一直有效。
+class Interner {
+private:
+    mutable std::mutex mutex;
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, SymbolId> ids;
+
+    Interner();
+
+public:
+    static constexpr SymbolId kNone = UINT32_MAX;
+
+    // 预先驻留的内置名字，编号固定
+    static constexpr SymbolId kPrint = 0;         // print
+    static constexpr SymbolId kPrintChinese = 1;  // 打印
+    static constexpr SymbolId kMain = 2;          // main
+    static constexpr SymbolId kMainChinese = 3;   // 主函数
+
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+    static Interner& global();
+
+    SymbolId intern(std::string_view text);
+    std::string_view name(SymbolId id) const;
+    size_t size() const;
+};
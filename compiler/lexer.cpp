@@ -1,62 +1,139 @@
 #include "lexer.h"
 #include "error.h"
+#include "symbol_tables.h"
+#include "lexer_simd.h"
 #include <iostream>
 #include <cctype>
 #include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <cstring>
+#include <array>
+#include <charconv>
 
 // 静态成员初始化
+bool Lexer::sLocalized = false;
 bool Lexer::sUseExternalMap = false;
 std::unordered_map<std::string, TokenType> Lexer::sExternalMap;
 
-Lexer::Lexer(const std::string& sourceCode)
-    : source(sourceCode), current(0), line(1), column(1) {
-    initSymbolMap();
-}
-
-void Lexer::initSymbolMap() {
-    // === polyglot 英文版符号语法映射（默认） ===
-
-    // 核心符号
-    symbolMap[">>"] = TokenType::IMPORT;           // 模块导入
-    symbolMap["?"] = TokenType::QUESTION;          // 变量声明
-    symbolMap[":="] = TokenType::CONDITIONAL_ASSIGN; // 值拷贝赋值
-    symbolMap["<-"] = TokenType::RETURN_ARROW;     // 返回语句
-    symbolMap["@"] = TokenType::STRUCT_DEF;        // 结构体定义
-    symbolMap["&"] = TokenType::IMPL_DEF;          // 方法实现
-    symbolMap["->"] = TokenType::ARROW;            // 函数返回类型
-    symbolMap["%"] = TokenType::INTERFACE;         // 接口定义
-    symbolMap["#"] = TokenType::ENUM;              // 枚举定义
-    symbolMap["^"] = TokenType::LOOP;              // 循环语句
-    symbolMap["*"] = TokenType::CONSTANT;          // 常量声明
-
-    // 控制流复合符号
-    symbolMap["<<"] = TokenType::BREAK_STMT;       // 跳出循环
-
-    // 特殊引用
-    symbolMap["_"] = TokenType::SELF_REF;          // 自身引用
-
-    // === 基本数据类型映射 ===
-    symbolMap["i8"] = TokenType::TYPE_I8;
-    symbolMap["i16"] = TokenType::TYPE_I16;
-    symbolMap["i32"] = TokenType::TYPE_I32;
-    symbolMap["i64"] = TokenType::TYPE_I64;
-    symbolMap["f32"] = TokenType::TYPE_F32;
-    symbolMap["f64"] = TokenType::TYPE_F64;
-    symbolMap["bool"] = TokenType::TYPE_BOOL;
-    symbolMap["string"] = TokenType::TYPE_STRING;
-    symbolMap["char"] = TokenType::TYPE_CHAR;
-
-    // 布尔值映射
-    symbolMap["true"] = TokenType::TRUE;
-    symbolMap["false"] = TokenType::FALSE;
-
-    // 如果设置了外部映射，则覆盖默认映射
+// BOM 在这里跳过而不是加载时复制一份去掉 BOM 的源码；Token 偏移与行列号都从 BOM 之后算起。
+// CRLF 的 '\r' 与空格一样由 skipBlanks 跳过，换行仍以 '\n' 为准。
+Lexer::Lexer(const SourceBuffer& buffer)
+    : source(utf8::stripBom(buffer.text())), current(0), store(source), encoding(buffer.encoding()) {
+    if (source.length() > UINT32_MAX) {
+        throw LexerError("源码超过 4GB，无法扫描", 1, 1);
+    }
+}
+
+Lexer::Lexer(std::string_view chunk, SourcePosition origin)
+    : source(chunk), current(0), store(source), origin(origin) {
+}
+
+TokenType Lexer::lookupKeyword(std::string_view text) const {
     if (sUseExternalMap) {
-        symbolMap = sExternalMap;
+        auto it = sExternalMap.find(std::string(text));
+        if (it != sExternalMap.end()) {
+            return it->second;
+        }
+        return symbol_tables::kLocalizedKeywords.find(text);
     }
+    return sLocalized ? symbol_tables::kLocalizedKeywords.find(text)
+                      : symbol_tables::kDefaultKeywords.find(text);
+}
+
+namespace {
+
+// 自定义符号映射对应的运行期 DFA：与生成器相同的前缀树构造，只是不合并字节类
+constexpr size_t kTokenTypeCount = static_cast<size_t>(TokenType::UNKNOWN) + 1;
+
+// 各 Token 类型是否存在含非 ASCII 字符的写法（据此区分“写成半角”与“两种风格写法相同”）
+using FullWidthTypes = std::array<bool, kTokenTypeCount>;
+
+template <typename Entries>
+FullWidthTypes collectFullWidthTypes(const Entries& entries) {
+    FullWidthTypes types{};
+    for (const auto& entry : entries) {
+        std::string_view text = entry.first;
+        bool ascii = std::all_of(text.begin(), text.end(),
+                                 [](char c) { return static_cast<unsigned char>(c) < 0x80; });
+        if (!ascii) types[static_cast<size_t>(entry.second)] = true;
+    }
+    return types;
+}
+
+struct RuntimeSymbolDfa {
+    std::vector<uint8_t> classes;
+    std::vector<uint16_t> next;
+    std::vector<TokenType> accept;
+    symbol_tables::SymbolDfa dfa{};
+
+    void build(const std::unordered_map<std::string, TokenType>& external) {
+        std::vector<symbol_tables::SymbolEntry> entries(std::begin(symbol_tables::kDefaultOperators),
+                                                        std::end(symbol_tables::kDefaultOperators));
+        for (const auto& pair : external) {
+            bool ascii = std::all_of(pair.first.begin(), pair.first.end(),
+                                     [](char c) { return static_cast<unsigned char>(c) < 0x80; });
+            if (!ascii) entries.push_back({pair.first, pair.second});
+        }
+
+        classes.assign(256, 0);
+        uint32_t classCount = 1;
+        for (const auto& entry : entries) {
+            for (char c : entry.text) {
+                uint8_t& cls = classes[static_cast<unsigned char>(c)];
+                if (cls == 0) cls = static_cast<uint8_t>(classCount++);
+            }
+        }
+
+        next.assign(2 * classCount, 0);
+        accept.assign(2, TokenType::UNKNOWN);
+        for (const auto& entry : entries) {
+            size_t state = 1;
+            for (char c : entry.text) {
+                uint16_t& target = next[state * classCount + classes[static_cast<unsigned char>(c)]];
+                if (target == 0) {
+                    target = static_cast<uint16_t>(accept.size());
+                    accept.push_back(TokenType::UNKNOWN);
+                    next.resize(next.size() + classCount, 0);
+                }
+                state = next[state * classCount + classes[static_cast<unsigned char>(c)]];
+            }
+            accept[state] = entry.type;
+        }
+        dfa = {classes.data(), next.data(), accept.data(), classCount};
+        fullWidthTypes = collectFullWidthTypes(external);
+    }
+
+    FullWidthTypes fullWidthTypes{};
+};
+
+RuntimeSymbolDfa gExternalDfa;
+
+const FullWidthTypes& builtinFullWidthTypes() {
+    static const FullWidthTypes types = [] {
+        std::vector<std::pair<std::string_view, TokenType>> entries;
+        const auto& table = symbol_tables::kLocalizedSymbols;
+        for (uint32_t i = 0; i < table.capacity(); ++i) {
+            if (!table.slots[i].text.empty()) entries.emplace_back(table.slots[i].text, table.slots[i].type);
+        }
+        return collectFullWidthTypes(entries);
+    }();
+    return types;
+}
+
+} // namespace
+
+const symbol_tables::SymbolDfa& Lexer::activeDfa() {
+    if (sUseExternalMap) return gExternalDfa.dfa;
+    return sLocalized ? symbol_tables::kLocalizedDfa : symbol_tables::kDefaultDfa;
 }
 
-char Lexer::peek() {
+bool Lexer::hasFullWidthSpelling(TokenType type) {
+    const FullWidthTypes& types = sUseExternalMap ? gExternalDfa.fullWidthTypes : builtinFullWidthTypes();
+    return types[static_cast<size_t>(type)];
+}
+
+char Lexer::peekChar() {
     if (current >= source.length()) return '\0';
     return source[current];
 }
@@ -66,54 +143,45 @@ char Lexer::peekNext() {
     return source[current + 1];
 }
 
+// 行列号不在扫描时维护：前进只移动偏移
 char Lexer::advance() {
     if (current >= source.length()) return '\0';
+    return source[current++];
+}
 
-    char c = source[current++];
-    if (c == '\n') {
-        line++;
-        column = 1;
-    } else {
-        column++;
-    }
-    return c;
+void Lexer::addToken(TokenType type, size_t start) {
+    emitToken(type, start, current - start);
+}
+
+void Lexer::error(const std::string& message, size_t offset) const {
+    SourcePosition position = locateOffset(source, offset);
+    // 分块总从行首开始，只需平移行号
+    throw LexerError(message, position.line + origin.line - 1, position.column);
 }
 
 void Lexer::skipWhitespace() {
-    while (true) {
-        char c = peek();
-        if (c == ' ' || c == '\r' || c == '\t') {
-            advance();
-        } else {
-            break;
-        }
-    }
+    current += lexer_simd::skipBlanks(source.data() + current, source.length() - current);
 }
 
 void Lexer::skipComment() {
     // 跳过单行注释 //
-    if (peek() == '/' && peekNext() == '/') {
-        while (peek() != '\n' && peek() != '\0') {
-            advance();
-        }
+    if (peekChar() == '/' && peekNext() == '/') {
+        static constexpr char kLineEnd[4] = {'\n', '\0', '\n', '\0'};
+        current += lexer_simd::findAny(source.data() + current, source.length() - current, kLineEnd);
     }
 
     // 跳过多行注释 /* */
-    if (peek() == '/' && peekNext() == '*') {
+    if (peekChar() == '/' && peekNext() == '*') {
         advance(); // /
         advance(); // *
 
-        while (true) {
-            if (peek() == '\0') {
-                throw LexerError("未结束的多行注释", line, column);
-            }
-            if (peek() == '*' && peekNext() == '/') {
-                advance(); // *
-                advance(); // /
-                break;
-            }
-            advance();
+        // 一次跳到 "*/" 或 '\0'
+        current += lexer_simd::findCommentEnd(source.data() + current, source.length() - current);
+        if (peekChar() == '\0') {
+            error("未结束的多行注释", current);
         }
+        advance(); // *
+        advance(); // /
     }
 }
 
@@ -130,279 +198,260 @@ bool Lexer::isAlphaNumeric(char c) {
 }
 
 void Lexer::scanString() {
-    int startLine = line;
-    int startColumn = column;
+    size_t start = current;
 
-    advance(); // 跳过开始的 "
+    // 跳过开始的引号：ASCII " 或本地化模式下的 “ ”（任一引号都可以结束字符串）
+    if (peekChar() == '"') {
+        advance();
+    } else {
+        current += 3;
+    }
 
-    std::string value = "";
-    while (peek() != '"' && peek() != '\0') {
-        if (peek() == '\n') {
-            throw LexerError("字符串字面值不能跨行", startLine, startColumn);
+    // 只校验转义序列，不在此处构造字符串值（由 Token::value() 按需解码）
+    static constexpr char kStringSpecial[4] = {'"', '\\', '\n', '\0'};
+    static constexpr char kLocalizedStringSpecial[4] = {'"', '\\', '\n', '\xE2'};
+    while (true) {
+        // 普通字符整段跳过（不含换行，只推进列号）
+        const char* p = source.data() + current;
+        size_t n;
+        if (sLocalized) {
+            n = lexer_simd::findAny(p, source.length() - current, kLocalizedStringSpecial);
+            if (const void* nul = std::memchr(p, '\0', n)) n = static_cast<size_t>(static_cast<const char*>(nul) - p);
+        } else {
+            n = lexer_simd::findAny(p, source.length() - current, kStringSpecial);
         }
+        current += n;
+        if (peekChar() == '"' || peekChar() == '\0') break;
+        if (sLocalized && atCurlyDoubleQuote()) break;
 
-        if (peek() == '\\') {
+        if (peekChar() == '\n') {
+            error("字符串字面值不能跨行", start);
+        }
+
+        if (peekChar() == '\\') {
             advance(); // 跳过反斜杠
+            if (sLocalized && atCurlyDoubleQuote()) {
+                current += 3;
+                continue;
+            }
             char escaped = advance();
             switch (escaped) {
-                case 'n': value += '\n'; break;
-                case 't': value += '\t'; break;
-                case 'r': value += '\r'; break;
-                case '\\': value += '\\'; break;
-                case '"': value += '"'; break;
+                case 'n': case 't': case 'r': case '\\': case '"':
+                    break;
                 default:
-                    throw LexerError("未知的转义序列: \\" + std::string(1, escaped), line, column);
+                    error("未知的转义序列: \\" + std::string(1, escaped), current);
             }
         } else {
-            value += advance();
+            advance();
         }
     }
 
-    if (peek() == '\0') {
-        throw LexerError("未结束的字符串字面值", startLine, startColumn);
+    if (peekChar() == '\0') {
+        error("未结束的字符串字面值", start);
     }
 
-    advance(); // 跳过结束的 "
-    tokens.emplace_back(TokenType::STRING_LITERAL, value, startLine, startColumn);
+    // 跳过结束的引号
+    if (peekChar() == '"') {
+        advance();
+    } else {
+        current += 3;
+    }
+    addToken(TokenType::STRING_LITERAL, start);
 }
 
 void Lexer::scanChar() {
-    int startLine = line;
-    int startColumn = column;
+    size_t start = current;
 
     advance(); // 跳过开始的 '
 
-    if (peek() == '\0' || peek() == '\n') {
-        throw LexerError("未结束的字符字面值", startLine, startColumn);
+    if (peekChar() == '\0' || peekChar() == '\n') {
+        error("未结束的字符字面值", start);
     }
 
-    char value;
-    if (peek() == '\\') {
+    if (peekChar() == '\\') {
         advance(); // 跳过反斜杠
         char escaped = advance();
         switch (escaped) {
-            case 'n': value = '\n'; break;
-            case 't': value = '\t'; break;
-            case 'r': value = '\r'; break;
-            case '\\': value = '\\'; break;
-            case '\'': value = '\''; break;
+            case 'n': case 't': case 'r': case '\\': case '\'':
+                break;
             default:
-                throw LexerError("未知的转义序列: \\" + std::string(1, escaped), line, column);
+                error("未知的转义序列: \\" + std::string(1, escaped), current);
         }
     } else {
-        value = advance();
+        advance();
     }
 
-    if (peek() != '\'') {
-        throw LexerError("字符字面值必须以 ' 结束", line, column);
+    if (peekChar() != '\'') {
+        error("字符字面值必须以 ' 结束", current);
     }
 
     advance(); // 跳过结束的 '
-    tokens.emplace_back(TokenType::CHAR_LITERAL, std::string(1, value), startLine, startColumn);
+    addToken(TokenType::CHAR_LITERAL, start);
 }
 
-void Lexer::scanNumber() {
-    int startLine = line;
-    int startColumn = column;
-    std::string number = "";
+static bool isDigitOf(char c, int base) {
+    switch (base) {
+        case 2: return c == '0' || c == '1';
+        case 16: return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+        default: return std::isdigit(static_cast<unsigned char>(c)) != 0;
+    }
+}
 
-    // 扫描整数部分
-    while (isDigit(peek())) {
-        number += advance();
+std::string_view Lexer::scanDigits(int base, std::string& scratch) {
+    size_t start = current;
+    bool separated = false;
+    while (isDigitOf(peekChar(), base) || peekChar() == '_') {
+        if (peekChar() == '_') {
+            // 下划线只能夹在两个数字之间：1_000 合法，_1、1_、1__0 不合法
+            if (current == start || !isDigitOf(peekNext(), base)) {
+                error("数字字面值中的下划线只能出现在数字之间", current);
+            }
+            separated = true;
+        }
+        advance();
     }
 
-    // 检查是否是浮点数
-    if (peek() == '.' && isDigit(peekNext())) {
-        number += advance(); // .
+    std::string_view digits = source.substr(start, current - start);
+    if (!separated) return digits;
+    scratch.assign(digits.begin(), digits.end());
+    scratch.erase(std::remove(scratch.begin(), scratch.end(), '_'), scratch.end());
+    return scratch;
+}
 
-        while (isDigit(peek())) {
-            number += advance();
+// 整数字面值本身不带符号，最大可写到 2^63（-9223372036854775808 中负号之后的部分），此时以 INT64_MIN 存放；
+// 是否在 i64 或声明类型的范围内由语义分析在合并负号之后判断
+NumberValue Lexer::decodeInteger(std::string_view digits, int base, size_t start) {
+    uint64_t magnitude = 0;
+    auto result = std::from_chars(digits.data(), digits.data() + digits.size(), magnitude, base);
+    if (result.ec == std::errc::result_out_of_range || magnitude > uint64_t{1} << 63) {
+        error("整数字面值超出 i64 范围: " + std::string(source.substr(start, current - start)), start);
+    }
+    NumberValue value{};
+    value.integer = static_cast<int64_t>(magnitude);
+    return value;
+}
+
+// 数值字面值：十进制整数/小数、0x 十六进制、0b 二进制，数字之间可用 _ 分隔。
+// 用 from_chars 解码一次，超出 f64 或 2^63 时报错（按声明宽度的检查在语义分析阶段）。
+void Lexer::scanNumber() {
+    size_t start = current;
+    std::string scratch;
+
+    char prefix = peekChar() == '0' ? static_cast<char>(std::tolower(static_cast<unsigned char>(peekNext()))) : '\0';
+    if (prefix == 'x' || prefix == 'b') {
+        const int base = prefix == 'x' ? 16 : 2;
+        current += 2;
+        if (!isDigitOf(peekChar(), base)) {
+            error(base == 16 ? "十六进制字面值缺少数字" : "二进制字面值缺少数字", start);
         }
+        std::string_view digits = scanDigits(base, scratch);
+        addNumber(TokenType::INTEGER_LITERAL, start, decodeInteger(digits, base, start));
+        return;
+    }
 
-        tokens.emplace_back(TokenType::FLOAT_LITERAL, number, startLine, startColumn);
+    // 整数部分
+    std::string_view integer = scanDigits(10, scratch);
+
+    // 检查是否是浮点数
+    if (peekChar() == '.' && isDigit(peekNext())) {
+        std::string text(integer);
+        advance(); // .
+        std::string fractionScratch;
+        text += '.';
+        text += scanDigits(10, fractionScratch);
+
+        NumberValue value{};
+        auto result = std::from_chars(text.data(), text.data() + text.size(), value.real);
+        if (result.ec == std::errc::result_out_of_range) {
+            error("浮点字面值超出 f64 范围: " + std::string(source.substr(start, current - start)), start);
+        }
+        addNumber(TokenType::FLOAT_LITERAL, start, value);
     } else {
-        tokens.emplace_back(TokenType::INTEGER_LITERAL, number, startLine, startColumn);
+        addNumber(TokenType::INTEGER_LITERAL, start, decodeInteger(integer, 10, start));
     }
 }
 
 void Lexer::scanIdentifier() {
-    int startLine = line;
-    int startColumn = column;
-    std::string text = "";
+    size_t start = current;
 
     // 检查是否以$开头（变量前缀）
     bool hasVariablePrefix = false;
-    if (peek() == '$') {
-        text += advance();
+    if (peekChar() == '$') {
+        advance();
         hasVariablePrefix = true;
     }
 
     // 扫描标识符的其余部分
-    while (isAlphaNumeric(peek())) {
-        text += advance();
+    while (isAlphaNumeric(peekChar())) {
+        advance();
     }
 
+    std::string_view text = source.substr(start, current - start);
+
     // 如果只有$符号，当作变量前缀Token处理
     if (text == "$") {
-        tokens.emplace_back(TokenType::VARIABLE_PREFIX, text, startLine, startColumn);
+        addToken(TokenType::VARIABLE_PREFIX, start);
         return;
     }
 
     // 检查是否是保留的类型符号（不包含$前缀的标识符）
     if (!hasVariablePrefix) {
-        auto it = symbolMap.find(text);
-        if (it != symbolMap.end()) {
-            tokens.emplace_back(it->second, text, startLine, startColumn);
+        TokenType keyword = lookupKeyword(text);
+        if (keyword != TokenType::UNKNOWN) {
+            addToken(keyword, start);
             return;
         }
     }
 
     // 普通标识符（可能带有$前缀）
-    tokens.emplace_back(TokenType::IDENTIFIER, text, startLine, startColumn);
+    addToken(TokenType::IDENTIFIER, start);
 }
 
 void Lexer::scanSymbol() {
-    int startLine = line;
-    int startColumn = column;
-    char c = advance();
-
-    switch (c) {
-        // 检查多字符符号
-        case '>':
-            if (peek() == '>') {
-                advance();
-                tokens.emplace_back(TokenType::IMPORT, ">>", startLine, startColumn);
-            } else if (peek() == '=') {
-                advance();
-                tokens.emplace_back(TokenType::GREATER_EQUAL, ">=", startLine, startColumn);
-            } else {
-                tokens.emplace_back(TokenType::GREATER_THAN, ">", startLine, startColumn);
-            }
-            break;
+    size_t start = current;
 
-        case '<':
-            if (peek() == '<') {
-                advance();
-                tokens.emplace_back(TokenType::BREAK_STMT, "<<", startLine, startColumn);
-            } else if (peek() == '-') {
-                advance();
-                tokens.emplace_back(TokenType::RETURN_ARROW, "<-", startLine, startColumn);
-            } else if (peek() == '=') {
-                advance();
-                tokens.emplace_back(TokenType::LESS_EQUAL, "<=", startLine, startColumn);
-            } else {
-                tokens.emplace_back(TokenType::LESS_THAN, "<", startLine, startColumn);
-            }
-            break;
-
-        case ':':
-            if (peek() == '=') {
-                advance();
-                tokens.emplace_back(TokenType::CONDITIONAL_ASSIGN, ":=", startLine, startColumn);
-            } else {
-                tokens.emplace_back(TokenType::COLON, ":", startLine, startColumn);
-            }
-            break;
+    // 半角与全角运算符统一由 DFA 做最长匹配（》》、《-、：= 等）
+    size_t length = 0;
+    TokenType type = activeDfa().match(source.substr(current), length);
 
-        case '-':
-            if (peek() == '>') {
-                advance();
-                tokens.emplace_back(TokenType::CONTINUE_STMT, "->", startLine, startColumn);
-            } else if (peek() == '=') {
-                advance();
-                tokens.emplace_back(TokenType::MINUS_ASSIGN, "-=", startLine, startColumn);
-            } else {
-                tokens.emplace_back(TokenType::MINUS, "-", startLine, startColumn);
-            }
-            break;
-
-        case '=':
-            if (peek() == '=') {
-                advance();
-                tokens.emplace_back(TokenType::EQUAL, "==", startLine, startColumn);
-            } else {
-                tokens.emplace_back(TokenType::ASSIGN, "=", startLine, startColumn);
-            }
-            break;
-
-        case '!':
-            if (peek() == '=') {
-                advance();
-                tokens.emplace_back(TokenType::NOT_EQUAL, "!=", startLine, startColumn);
-            } else {
-                tokens.emplace_back(TokenType::LOGICAL_NOT, "!", startLine, startColumn);
-            }
-            break;
-
-        case '&':
-            if (peek() == '&') {
-                advance();
-                tokens.emplace_back(TokenType::LOGICAL_AND, "&&", startLine, startColumn);
-            } else {
-                tokens.emplace_back(TokenType::IMPL_DEF, "&", startLine, startColumn);
-            }
-            break;
-
-        case '|':
-            if (peek() == '|') {
-                advance();
-                tokens.emplace_back(TokenType::LOGICAL_OR, "||", startLine, startColumn);
-            } else {
-                throw LexerError("未知符号: " + std::string(1, c), startLine, startColumn);
-            }
-            break;
-
-        case '+':
-            if (peek() == '=') {
-                advance();
-                tokens.emplace_back(TokenType::PLUS_ASSIGN, "+=", startLine, startColumn);
-            } else {
-                tokens.emplace_back(TokenType::PLUS, "+", startLine, startColumn);
-            }
-            break;
+    if (length == 0) {
+        utf8::DecodedChar decoded = peekCodepoint();
+        if (decoded.len <= 1) {
+            error("未知符号: " + std::string(1, source[current]), start);
+        }
+        std::string c(source.substr(current, decoded.len));
+        if (utf8::isFullWidthSymbol(decoded.cp)) {
+            error("未知的Unicode字符: " + c, start);
+        }
+        error("不支持的Unicode字符: " + c, start);
+    }
 
-        // 单字符符号
-        case '@': tokens.emplace_back(TokenType::STRUCT_DEF, "@", startLine, startColumn); break;
-        case '%': tokens.emplace_back(TokenType::INTERFACE, "%", startLine, startColumn); break;
-        case '#': tokens.emplace_back(TokenType::ENUM, "#", startLine, startColumn); break;
-        case '^': tokens.emplace_back(TokenType::LOOP, "^", startLine, startColumn); break;
-        case '$': tokens.emplace_back(TokenType::VARIABLE_PREFIX, "$", startLine, startColumn); break;
-        case '_': tokens.emplace_back(TokenType::SELF_REF, "_", startLine, startColumn); break;
-        case '*': tokens.emplace_back(TokenType::CONSTANT, "*", startLine, startColumn); break;
-        case '?': tokens.emplace_back(TokenType::QUESTION, "?", startLine, startColumn); break;
-        case '/': tokens.emplace_back(TokenType::SLASH, "/", startLine, startColumn); break;
-        case '(': tokens.emplace_back(TokenType::LEFT_PAREN, "(", startLine, startColumn); break;
-        case ')': tokens.emplace_back(TokenType::RIGHT_PAREN, ")", startLine, startColumn); break;
-        case '{': tokens.emplace_back(TokenType::LEFT_BRACE, "{", startLine, startColumn); break;
-        case '}': tokens.emplace_back(TokenType::RIGHT_BRACE, "}", startLine, startColumn); break;
-        case '[': tokens.emplace_back(TokenType::LEFT_BRACKET, "[", startLine, startColumn); break;
-        case ']': tokens.emplace_back(TokenType::RIGHT_BRACKET, "]", startLine, startColumn); break;
-        case ',': tokens.emplace_back(TokenType::COMMA, ",", startLine, startColumn); break;
-        case ';': tokens.emplace_back(TokenType::SEMICOLON, ";", startLine, startColumn); break;
-        case '.': tokens.emplace_back(TokenType::DOT, ".", startLine, startColumn); break;
-        case '\n': tokens.emplace_back(TokenType::NEWLINE, "\\n", startLine, startColumn); break;
-
-        default:
-            throw LexerError("未知符号: " + std::string(1, c), startLine, startColumn);
+    bool fullWidth = false;
+    for (size_t i = 0; i < length; ++i) {
+        fullWidth |= static_cast<unsigned char>(source[current + i]) >= 0x80;
     }
+    current += length;
+    recordSymbol(type, fullWidth, start);
+    addToken(type, start);
 }
 
-std::vector<Token> Lexer::tokenize() {
-    // 跳过全角/半角混合检测（已移除该提示机制）
-
+// 扫描下一个Token（跳过空白与注释）；到达末尾时输出 EOF 并置 finished
+void Lexer::scanToken() {
     while (current < source.length()) {
         skipWhitespace();
 
         // 检查是否到达文件末尾
         if (current >= source.length()) break;
 
-        // 先尝试读取UTF-8字符
-        std::string nextChar = peekUTF8Char();
-        if (nextChar.empty()) break;
+        // 先解码当前位置的UTF-8字符（末尾不完整的多字节序列视为结束；纯 ASCII 源码直接取字节）
+        utf8::DecodedChar next = encoding == SourceBuffer::Encoding::Ascii
+                                     ? utf8::DecodedChar{static_cast<unsigned char>(source[current]), 1}
+                                     : peekCodepoint();
+        if (next.len == 0) break;
 
         // 跳过注释 (只检查ASCII注释)
-        if (nextChar.length() == 1) {
-            char c = nextChar[0];
+        if (next.len == 1) {
+            char c = source[current];
             if ((c == '/' && peekNext() == '/') || (c == '/' && peekNext() == '*')) {
                 skipComment();
                 continue;
@@ -410,21 +459,20 @@ std::vector<Token> Lexer::tokenize() {
         }
 
         // 处理Unicode字符（中文字符或全角符号）
-        if (nextChar.length() > 1) {
-            if (isChineseChar(nextChar) || nextChar == "＄") {
+        if (next.len > 1) {
+            if (sLocalized && utf8::isCurlyDoubleQuote(next.cp)) {
+                scanString();
+            } else if (utf8::isChinese(next.cp) || next.cp == utf8::kFullWidthDollar) {
                 // 中文标识符（包括以＄开头的变量）
                 scanChineseIdentifier();
-            } else if (isFullWidthSymbol(nextChar) || isUnicodeSymbol(nextChar)) {
-                // 全角符号
-                scanUnicodeSymbol();
             } else {
-                // 其他Unicode字符（目前不支持）
-                throw LexerError("不支持的Unicode字符: " + nextChar, line, column);
+                // 全角符号；其他无法识别的Unicode字符在 scanSymbol 中报错
+                scanSymbol();
             }
         }
         // 处理ASCII字符
         else {
-            char c = nextChar[0];
+            char c = source[current];
 
             // 字符串字面值
             if (c == '"') {
@@ -442,234 +490,341 @@ std::vector<Token> Lexer::tokenize() {
             else if (isAlpha(c) || c == '$') {
                 scanIdentifier();
             }
-            // 换行符处理
+            // 换行符处理（折叠模式下只记下标志，本次不输出Token）
             else if (c == '\n') {
+                size_t start = current;
                 advance();
-                tokens.emplace_back(TokenType::NEWLINE, "\\n", line-1, column);
+                if (foldNewlines) {
+                    pendingNewline = true;
+                } else {
+                    addToken(TokenType::NEWLINE, start);
+                }
             }
             // ASCII符号
             else {
                 scanSymbol();
             }
         }
+        return;
     }
 
     // 添加文件结束标记
-    tokens.emplace_back(TokenType::EOF_TOKEN, "", line, column);
-
-    return tokens;
+    emitToken(TokenType::EOF_TOKEN, current, 0);
+    finished = true;
 }
 
-// 静态：覆盖全局符号映射
-void Lexer::OverrideSymbolMap(const std::unordered_map<std::string, TokenType>& newMap) {
-    sExternalMap = newMap;
-    sUseExternalMap = true;
+TokenStore Lexer::scan() {
+    while (!finished) {
+        scanToken();
+    }
+    return std::move(store);
 }
 
-void Lexer::ClearOverride() {
-    sExternalMap.clear();
-    sUseExternalMap = false;
+std::vector<Token> Lexer::tokenize() {
+    return scan().toTokens();
 }
 
-// === Unicode和全角符号处理函数实现 ===
-
-int Lexer::getUTF8CharLength(char firstByte) {
-    if ((firstByte & 0x80) == 0) return 1;  // ASCII
-    if ((firstByte & 0xE0) == 0xC0) return 2;  // 110xxxxx
-    if ((firstByte & 0xF0) == 0xE0) return 3;  // 1110xxxx
-    if ((firstByte & 0xF8) == 0xF0) return 4;  // 11110xxx
-    return 1; // 错误情况，当作单字节处理
-}
+TokenStore Lexer::scanParallel(unsigned threads, size_t minChunk) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const size_t remaining = source.length() - current;
+    size_t chunkCount = std::min<size_t>(threads, remaining / std::max<size_t>(minChunk, 1));
+    if (streaming || finished || chunkCount < 2) {
+        return scan();
+    }
 
-std::string Lexer::peekUTF8Char() {
-    if (current >= source.length()) return "";
+    // 切分点取目标位置之后第一个换行的下一个字节，保证每块都从行首开始
+    std::vector<size_t> bounds{current};
+    for (size_t i = 1; i < chunkCount; ++i) {
+        size_t target = std::max(current + remaining / chunkCount * i, bounds.back() + 1);
+        size_t newline = source.find('\n', target);
+        if (newline == std::string_view::npos || newline + 1 >= source.length()) break;
+        if (newline + 1 > bounds.back()) bounds.push_back(newline + 1);
+    }
+    bounds.push_back(source.length());
+    chunkCount = bounds.size() - 1;
+
+    // 各块独立扫描；块内报错或提前停止（如结尾处截断的多字节序列）都视为“不可信”，交给后面的顺序扫描处理。
+    // 块内偏移相对块首，拼接时整体平移；行列号不随扫描维护，因此无需按行数修正。
+    struct Chunk {
+        TokenStore tokens;
+        SymbolStats stats;
+        bool clean = false;
+    };
+    std::vector<Chunk> chunks(chunkCount);
+    auto scanChunk = [&](size_t index) {
+        Lexer worker(source.substr(bounds[index], bounds[index + 1] - bounds[index]));
+        worker.foldNewlines = foldNewlines;
+        worker.encoding = encoding;  // 分块在换行处切开，仍是完整的合法序列
+        worker.pendingNewline = foldNewlines && (index > 0 || pendingNewline);  // 后续分块都紧跟在换行之后
+        try {
+            worker.store.reserve(worker.source.length() / 4);
+            chunks[index].tokens = worker.scan();
+        } catch (...) {
+            chunks[index].tokens = TokenStore();
+            return;
+        }
+        // 块末尾的换行必须作为换行被消耗（NEWLINE Token 或 EOF 上的折叠标志），被非法多字节序列吞掉时不算对齐
+        const TokenStore& tokens = chunks[index].tokens;
+        const size_t length = worker.source.length();
+        const bool endsWithNewline =
+            foldNewlines ? tokens.newlineBefore(tokens.size() - 1)
+                         : tokens.size() >= 2 && tokens.kind(tokens.size() - 2) == TokenType::NEWLINE &&
+                               tokens.offset(tokens.size() - 2) + 1 == length;
+        chunks[index].clean = worker.current == length && (index + 1 == bounds.size() - 1 || endsWithNewline);
+        chunks[index].stats = worker.stats;
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(chunkCount - 1);
+    for (size_t i = 1; i < chunkCount; ++i) {
+        workers.emplace_back(scanChunk, i);
+    }
+    scanChunk(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
 
-    int charLength = getUTF8CharLength(source[current]);
-    if (current + charLength > source.length()) return "";
+    // 按顺序拼接：可信分块平移偏移后直接采用；否则从块首顺序扫描，
+    // 直到某个 NEWLINE 之后恰好停在后续分块的起点（此时状态与该块独立扫描时相同）
+    size_t total = 0;
+    for (const auto& chunk : chunks) total += chunk.tokens.size();
+    store.reserve(store.size() + total);
+
+    size_t index = 0;
+    while (index < chunkCount) {
+        Chunk& chunk = chunks[index];
+        if (chunk.clean) {
+            const bool last = index + 1 == chunkCount;
+            store.append(chunk.tokens, chunk.tokens.size() - (last ? 0 : 1), bounds[index]);  // 只保留最后一块的 EOF
+            stats.merge(chunk.stats, bounds[index]);
+            current = bounds[index + 1];
+            finished = last;
+            pendingNewline = !last && foldNewlines;
+            chunk.tokens = TokenStore();
+            ++index;
+            continue;
+        }
 
-    return source.substr(current, charLength);
+        // 顺序扫描（真实的词法错误在这里按原顺序抛出）
+        current = bounds[index];
+        size_t next = index + 1;
+        while (!finished) {
+            scanToken();
+            // 只有换行分支会停在 '\n' 之后（字符串、注释都不会以换行结尾）
+            if (current == 0 || source[current - 1] != '\n') continue;
+            while (next < chunkCount && bounds[next] < current) ++next;
+            if (next < chunkCount && bounds[next] == current && chunks[next].clean) break;
+        }
+        index = finished ? chunkCount : next;
+    }
+    return std::move(store);
 }
 
-std::string Lexer::advanceUTF8Char() {
-    if (current >= source.length()) return "";
-
-    int charLength = getUTF8CharLength(source[current]);
-    if (current + charLength > source.length()) return "";
-
-    std::string utf8Char = source.substr(current, charLength);
-    current += charLength;
+std::vector<Token> Lexer::tokenizeParallel(unsigned threads, size_t minChunk) {
+    return scanParallel(threads, minChunk).toTokens();
+}
 
-    // 处理换行符
-    if (utf8Char == "\n") {
-        line++;
-        column = 1;
+void Lexer::addNumber(TokenType type, size_t start, NumberValue value) {
+    addToken(type, start);
+    if (streaming) {
+        ring[(ringHead + ringSize - 1) % kRingCapacity].number = value;
     } else {
-        column++;
+        store.pushNumber(value);
     }
-
-    return utf8Char;
 }
 
-bool Lexer::isChineseChar(const std::string& str) {
-    if (str.length() != 3) return false; // 中文字符通常是3字节UTF-8
+void Lexer::emitToken(TokenType type, size_t start, size_t length) {
+    const bool newlineBefore = pendingNewline;
+    pendingNewline = false;
+    if (!streaming) {
+        store.push(type, start, length, newlineBefore);
+        return;
+    }
+    SourcePosition position = cursor.advanceTo(start);
+    Token& slot = ring[(ringHead + ringSize) % kRingCapacity];
+    slot = Token(type, source.substr(start, length), position.line, position.column);
+    slot.newlineBefore = newlineBefore;
+    ringSize++;
+}
 
-    unsigned char first = str[0];
-    // 中文字符的UTF-8编码范围：0xE4-0xE9 (CJK统一汉字)
-    return (first >= 0xE4 && first <= 0xE9);
+const Token& Lexer::peek(size_t k) {
+    if (k > kMaxLookahead) {
+        throw std::out_of_range("Lexer::peek 超出最大前瞻距离");
+    }
+    if (!streaming) {
+        streaming = true;
+        cursor = PositionCursor(source);
+        ring.assign(kRingCapacity, Token(TokenType::EOF_TOKEN, source.substr(0, 0), 1, 1));
+    }
+    while (ringSize <= k && !finished) {
+        scanToken();
+    }
+    // 越过 EOF 的前瞻一律返回 EOF
+    size_t index = ringSize <= k ? ringSize - 1 : k;
+    return ring[(ringHead + index) % kRingCapacity];
 }
 
-bool Lexer::isFullWidthSymbol(const std::string& str) {
-    // 检查是否是全角符号（通常在全角标点符号区域）
-    if (str.length() != 3) return false;
+const Token& Lexer::next() {
+    const Token& token = peek(0);
+    if (token.type != TokenType::EOF_TOKEN) {
+        ringHead = (ringHead + 1) % kRingCapacity;
+        ringSize--;
+    }
+    return token;
+}
 
-    unsigned char first = str[0];
-    unsigned char second = str[1];
+// 静态：切换到本地化符号表
+void Lexer::OverrideSymbolMap(const std::unordered_map<std::string, TokenType>& newMap) {
+    sLocalized = true;
 
-    // 全角符号的UTF-8编码范围
-    // 0xEF 0xBC 0x80 - 0xEF 0xBF 0xBF (全角ASCII和标点符号)
-    if (first == 0xEF) {
-        return (second >= 0xBC && second <= 0xBF);
+    // 与构建期生成的表完全一致时直接使用完美哈希表
+    const auto& builtin = symbol_tables::kLocalizedSymbols;
+    bool matchesBuiltin = newMap.size() == builtin.count;
+    for (auto it = newMap.begin(); matchesBuiltin && it != newMap.end(); ++it) {
+        matchesBuiltin = builtin.find(it->first) == it->second;
     }
 
-    // 0xE3 0x80 0x80 - 0xE3 0x80 0xBF (部分中文标点符号)
-    if (first == 0xE3 && second == 0x80) {
-        return true;
+    if (matchesBuiltin) {
+        UseBuiltinLocalizedSymbols();
+    } else {
+        sExternalMap = newMap;
+        sUseExternalMap = true;
+        gExternalDfa.build(sExternalMap);
     }
+}
 
-    return false;
+void Lexer::UseBuiltinLocalizedSymbols() {
+    sExternalMap.clear();
+    sUseExternalMap = false;
+    sLocalized = true;
 }
 
-bool Lexer::isUnicodeSymbol(const std::string& str) {
-    return isFullWidthSymbol(str) || isChineseChar(str);
+void Lexer::ClearOverride() {
+    sExternalMap.clear();
+    sUseExternalMap = false;
+    sLocalized = false;
+}
+
+// === Unicode和全角符号处理函数实现 ===
+
+utf8::DecodedChar Lexer::peekCodepoint() const {
+    if (encoding != SourceBuffer::Encoding::Unchecked) {
+        return utf8::decodeUnchecked(source.data() + current, source.length() - current);
+    }
+    return utf8::decode(source.data() + current, source.length() - current);
+}
+
+bool Lexer::atCurlyDoubleQuote() const {
+    return utf8::startsWithCurlyDoubleQuote(source.data() + current, source.length() - current);
 }
 
 void Lexer::scanChineseIdentifier() {
-    int startLine = line;
-    int startColumn = column;
-    std::string identifier = "";
+    size_t start = current;
 
     // 检查是否以全角$开头（变量前缀）
     bool hasVariablePrefix = false;
-    std::string firstChar = peekUTF8Char();
-    if (firstChar == "＄") {
-        identifier += advanceUTF8Char();
+    utf8::DecodedChar first = peekCodepoint();
+    if (first.cp == utf8::kFullWidthDollar) {
+        current += first.len;
         hasVariablePrefix = true;
     }
 
     // 扫描中文标识符（可以包含中文字符、字母、数字）
     while (true) {
-        std::string nextChar = peekUTF8Char();
-        if (nextChar.empty()) break;
+        utf8::DecodedChar next = peekCodepoint();
+        if (next.len == 0) break;
 
         // 中文字符
-        if (isChineseChar(nextChar)) {
-            identifier += advanceUTF8Char();
+        if (utf8::isChinese(next.cp)) {
+            current += next.len;
         }
         // 英文字母或数字
-        else if (nextChar.length() == 1 && isAlphaNumeric(nextChar[0])) {
-            identifier += advance();
+        else if (next.len == 1 && isAlphaNumeric(source[current])) {
+            advance();
         }
         else {
             break;
         }
     }
 
+    std::string_view identifier = source.substr(start, current - start);
+
     // 如果只有＄符号，当作变量前缀Token处理
     if (identifier == "＄") {
-        tokens.emplace_back(TokenType::VARIABLE_PREFIX, identifier, startLine, startColumn);
+        addToken(TokenType::VARIABLE_PREFIX, start);
         return;
     }
 
     // 检查是否是中文关键字（不包含$前缀的标识符）
     if (!hasVariablePrefix) {
-        auto it = symbolMap.find(identifier);
-        if (it != symbolMap.end()) {
-            tokens.emplace_back(it->second, identifier, startLine, startColumn);
+        TokenType keyword = lookupKeyword(identifier);
+        if (keyword != TokenType::UNKNOWN) {
+            addToken(keyword, start);
             return;
         }
     }
 
     // 普通标识符（可能带有＄前缀）
-    tokens.emplace_back(TokenType::IDENTIFIER, identifier, startLine, startColumn);
+    addToken(TokenType::IDENTIFIER, start);
 }
 
-void Lexer::scanUnicodeSymbol() {
-    int startLine = line;
-    int startColumn = column;
-
-    // 尝试匹配最长的全角符号序列
-    std::string longestMatch = "";
-    TokenType matchedType = TokenType::UNKNOWN;
+SymbolStats::Mode SymbolStats::mode() const {
+    if (halfWidth > 0 && fullWidth > 0) return MIXED;
+    if (fullWidth > 0) return FULL_WIDTH;
+    return HALF_WIDTH;
+}
 
-    // 从长到短匹配符号（确保先匹配较长的符号如"》》"）
-    for (int maxLength = 6; maxLength >= 3; maxLength -= 3) { // 每个全角字符3字节
-        if (current + maxLength > source.length()) continue;
+size_t SymbolStats::firstOffending() const {
+    if (mode() != MIXED) return kNone;
+    return std::max(firstHalfOffset, firstFullOffset);
+}
 
-        std::string candidate = source.substr(current, maxLength);
-        auto it = symbolMap.find(candidate);
-        if (it != symbolMap.end()) {
-            longestMatch = candidate;
-            matchedType = it->second;
-            break;
-        }
+void SymbolStats::merge(const SymbolStats& other, size_t shift) {
+    if (firstHalfOffset == kNone && other.firstHalfOffset != kNone) {
+        firstHalfOffset = other.firstHalfOffset + shift;
     }
-
-    if (!longestMatch.empty()) {
-        // 找到匹配的符号
-        for (int i = 0; i < longestMatch.length(); i += 3) {
-            advanceUTF8Char();
-        }
-        tokens.emplace_back(matchedType, longestMatch, startLine, startColumn);
-    } else {
-        // 没有找到匹配的符号，按单个UTF-8字符处理
-        std::string singleChar = advanceUTF8Char();
-
-        // 对于未识别的Unicode字符，抛出错误
-        throw LexerError("未知的Unicode字符: " + singleChar, startLine, startColumn);
+    if (firstFullOffset == kNone && other.firstFullOffset != kNone) {
+        firstFullOffset = other.firstFullOffset + shift;
     }
+    halfWidth += other.halfWidth;
+    fullWidth += other.fullWidth;
+    neutral += other.neutral;
 }
 
-Lexer::SymbolMode Lexer::detectSymbolMode() {
-    bool hasHalfWidth = false;
-    bool hasFullWidth = false;
-
-    // 扫描整个源代码，检测符号类型
-    for (const auto& pair : symbolMap) {
-        if (source.find(pair.first) != std::string::npos) {
-            if (pair.first.length() == 1 ||
-                (pair.first.length() == 2 && pair.first[0] != 0xEF)) {
-                hasHalfWidth = true;
-            } else {
-                hasFullWidth = true;
-            }
-        }
+void Lexer::recordSymbol(TokenType type, bool fullWidth, size_t start) {
+    if (fullWidth) {
+        if (stats.fullWidth++ == 0) stats.firstFullOffset = start;
+    } else if (hasFullWidthSpelling(type)) {
+        if (stats.halfWidth++ == 0) stats.firstHalfOffset = start;
+    } else {
+        stats.neutral++;
     }
-
-    if (hasHalfWidth && hasFullWidth) return MIXED;
-    if (hasFullWidth) return FULL_WIDTH;
-    return HALF_WIDTH;
 }
 
-void Lexer::validateSymbolConsistency() {
-    SymbolMode mode = detectSymbolMode();
+void Lexer::reportSymbolMode() const {
+    SymbolStats::Mode mode = stats.mode();
 
-    if (mode == MIXED) {
-        std::cout << "⚠️  警告：检测到混合符号模式！" << std::endl;
+    if (mode == SymbolStats::MIXED) {
+        SourcePosition offending = locateOffset(source, stats.firstOffending());
+        std::cout << "⚠️  警告：检测到混合符号模式！（半角 " << stats.halfWidth << " 处，全角 " << stats.fullWidth
+                  << " 处，第一处不一致位于 行" << offending.line << ":列" << offending.column << "）" << std::endl;
         std::cout << "建议：在同一个文件中统一使用半角符号或全角符号" << std::endl;
         std::cout << "半角符号示例：>>、?、@、&" << std::endl;
         std::cout << "全角符号示例：》》、？、＠、＆" << std::endl;
-    } else if (mode == FULL_WIDTH) {
+    } else if (mode == SymbolStats::FULL_WIDTH) {
         std::cout << "✅ 检测到文达中文编程模式（全角符号）" << std::endl;
     } else {
         std::cout << "✅ 检测到polyglot英文编程模式（半角符号）" << std::endl;
     }
 }
 
-void Lexer::printTokens() const {
+void Lexer::printTokens(const std::vector<Token>& tokens) {
     std::cout << "\n=== Token列表 ===" << std::endl;
     for (const auto& token : tokens) {
         std::cout << "行" << token.line << ":列" << token.column
                   << " - Type: " << static_cast<int>(token.type)
-                  << ", Value: '" << token.value << "'" << std::endl;
+                  << ", Value: '" << (token.type == TokenType::NEWLINE ? std::string("\\n") : token.value())
+                  << "'" << std::endl;
     }
 }
@@ -27,41 +27,81 @@
 #endif
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
+#include <utility>
 #include "token_types.h"
+#include "source_buffer.h"
+#include "token_store.h"
+#include "utf8.h"
 
-// Token 结构体
-struct Token {
-    TokenType type;
-    std::string value;
-    int line;
-    int column;
+namespace symbol_tables { struct SymbolDfa; }
 
-    Token(TokenType t, const std::string& v, int l, int c)
-        : type(t), value(v), line(l), column(c) {}
+// 符号风格统计：扫描符号时顺带收集，不需要额外遍历源码
+struct SymbolStats {
+    enum Mode { HALF_WIDTH, FULL_WIDTH, MIXED };
+    static constexpr size_t kNone = static_cast<size_t>(-1);
+
+    size_t halfWidth = 0;   // 有全角写法却写成半角的符号，如 ( >>
+    size_t fullWidth = 0;   // 含非 ASCII 字符的符号，如 （ 》》 -》
+    size_t neutral = 0;     // 两种风格写法相同的符号，如 = + -，不参与判断
+    // 各风格第一个符号的源码偏移，未出现时为 kNone（行列号由 locateOffset 按需计算）
+    size_t firstHalfOffset = kNone;
+    size_t firstFullOffset = kNone;
+
+    Mode mode() const;
+    // 混合模式下第一处不一致：后出现的那种风格的第一个符号（非混合模式返回 kNone）
+    size_t firstOffending() const;
+    // 合并后续分块的统计，shift 为该块在源码中的起始偏移
+    void merge(const SymbolStats& other, size_t shift);
 };
 
 // 词法分析器类
 class Lexer {
 private:
-    std::string source;
+    std::string_view source;
     size_t current;
-    int line;
-    int column;
-    std::vector<Token> tokens;
+    TokenStore store;        // 批量模式的输出；行列号不在扫描时维护，需要时由偏移计算
+    bool finished = false;   // 已输出 EOF
+    // 折叠换行模式：换行不输出 NEWLINE Token，改为给下一个Token打上 newlineBefore 标志
+    bool foldNewlines = false;
+    bool pendingNewline = false;  // 上一个Token之后遇到过换行
+    // 源码经过加载期校验时不再逐字符检查编码：合法 UTF-8 按首字节直接解码，纯 ASCII 不解码
+    SourceBuffer::Encoding encoding = SourceBuffer::Encoding::Unchecked;
 
-    // 符号映射表（默认ASCII）；可被全局覆盖
-    std::unordered_map<std::string, TokenType> symbolMap;
+    // 拉取模式：next()/peek() 使用的环形缓冲区，只保留前瞻所需的少量 Token
+    static constexpr size_t kRingCapacity = 16;
+    std::vector<Token> ring;
+    size_t ringHead = 0;
+    size_t ringSize = 0;
+    bool streaming = false;
+    PositionCursor cursor;   // 拉取模式按顺序为Token补上行列号
 
-    // 全局外部符号映射，用于覆盖默认symbolMap（当检测到非英文文件名时启用）
+    // 关键字/符号表在构建期由 symbol_mapping.json 生成（见 symbol_tables.h），构造 Lexer 不再建表。
+    // 检测到非英文文件名时切换到本地化表；只有外部映射与内置表不一致时才退回运行时映射。
+    static bool sLocalized;
     static bool sUseExternalMap;
     static std::unordered_map<std::string, TokenType> sExternalMap;
 
-    void initSymbolMap();
-    char peek();
+    // 查不到时返回 UNKNOWN
+    TokenType lookupKeyword(std::string_view text) const;
+    // 当前模式下识别运算符（半角 + 全角）的 DFA
+    static const symbol_tables::SymbolDfa& activeDfa();
+    // 该类型的符号在本地化符号表中是否有全角写法
+    static bool hasFullWidthSpelling(TokenType type);
+    char peekChar();
     char peekNext();
     char advance();
+    // 以 [start, current) 为词素输出Token
+    void addToken(TokenType type, size_t start);
+    // 输出一个Token：批量模式追加到 store，拉取模式补上行列号后写入环形缓冲区
+    void emitToken(TokenType type, size_t start, size_t length);
+    // 输出数值字面值Token并附上解码结果
+    void addNumber(TokenType type, size_t start, NumberValue value);
+    // 在源码偏移 offset 处报告词法错误（行列号此时才计算）
+    [[noreturn]] void error(const std::string& message, size_t offset) const;
+    void scanToken();
     void skipWhitespace();
     void skipComment();
     bool isAlpha(char c);
@@ -69,36 +109,66 @@ private:
     bool isAlphaNumeric(char c);
 
     void scanString();
-    void scanFullWidthString(const std::string& startQuote);
     void scanChar();
     void scanNumber();
+    // 扫描一串 base 进制数字（允许数字之间的 _ 分隔），返回去掉分隔符后的数字
+    std::string_view scanDigits(int base, std::string& scratch);
+    NumberValue decodeInteger(std::string_view digits, int base, size_t start);
     void scanIdentifier();
     void scanSymbol();
 
-    // Unicode和全角符号处理函数
-    std::string peekUTF8Char();
-    std::string advanceUTF8Char();
-    bool isUnicodeSymbol(const std::string& str);
-    bool isChineseChar(const std::string& str);
-    bool isFullWidthSymbol(const std::string& str);
-    bool isFullWidthQuote(const std::string& str);
-    void scanUnicodeSymbol();
+    // Unicode处理：按码点解码当前位置的字符（不分配内存）
+    utf8::DecodedChar peekCodepoint() const;
+    bool atCurlyDoubleQuote() const;
     void scanChineseIdentifier();
-    int getUTF8CharLength(char firstByte);
 
-    // 符号模式检测
-    enum SymbolMode { HALF_WIDTH, FULL_WIDTH, MIXED };
-    SymbolMode detectSymbolMode();
-    void validateSymbolConsistency();
+    // 符号风格统计
+    SymbolStats stats;
+    void recordSymbol(TokenType type, bool fullWidth, size_t start);
+
+    // 分块扫描：在子视图上从行首开始扫描（偏移相对子视图），origin 为块首在整个源码中的位置（报错时换算行号）。
+    // 用于并行扫描与增量重新扫描
+    SourcePosition origin;
+    explicit Lexer(std::string_view chunk, SourcePosition origin = {});
+    friend class IncrementalLexer;
 
 public:
-    Lexer(const std::string& sourceCode);
+    explicit Lexer(const SourceBuffer& buffer);
+    // Token 引用源码缓冲区，禁止绑定临时对象
+    explicit Lexer(SourceBuffer&&) = delete;
 
-    // 覆盖全局符号映射（进程级别，一次设置全局生效）
+    // 切换到本地化符号表（进程级别，一次设置全局生效）；newMap 与内置表一致时不保留运行时副本
     static void OverrideSymbolMap(const std::unordered_map<std::string, TokenType>& newMap);
-    // 清除外部映射（恢复默认ASCII映射）
+    // 直接启用构建期生成的本地化符号表
+    static void UseBuiltinLocalizedSymbols();
+    // 清除外部映射（恢复默认ASCII表）
     static void ClearOverride();
 
+    // 开启/关闭折叠换行模式（须在扫描开始前设置；IncrementalLexer 不支持此模式）
+    void setFoldNewlines(bool fold) { foldNewlines = fold; }
+
+    // 扫描整个源码，输出紧凑的Token序列（源码不超过 4GB）
+    TokenStore scan();
+    // 同 scan()，但物化为带行列号的 Token 列表；返回的 Token 视图指向构造时传入的 SourceBuffer
     std::vector<Token> tokenize();
-    void printTokens() const;
+
+    // 多线程扫描：在换行处切块并行扫描，结果（含报错）与 scan() 完全一致。
+    // 跨块的多行注释等无法在块内确定的情况，从上一个可信的行首顺序重新扫描，直到与后续分块重新对齐。
+    // threads 为 0 时取硬件线程数；每块不足 minChunk 字节时减少块数，源码较小时直接退回 scan()
+    static constexpr size_t kMinParallelChunk = 256 * 1024;
+    TokenStore scanParallel(unsigned threads = 0, size_t minChunk = kMinParallelChunk);
+    std::vector<Token> tokenizeParallel(unsigned threads = 0, size_t minChunk = kMinParallelChunk);
+
+    // 拉取模式（与 tokenize() 二选一）：按需扫描，内存占用只与前瞻距离有关。
+    // 到达末尾后反复返回 EOF。返回的引用在再拉取约 kRingCapacity - kMaxLookahead 个Token之前保持有效。
+    static constexpr size_t kMaxLookahead = 4;
+    const Token& next();
+    const Token& peek(size_t k = 0);
+
+    // 已扫描部分的符号风格统计（扫描到 EOF 后即为整个文件的统计）
+    const SymbolStats& symbolStats() const { return stats; }
+    // 输出符号风格提示（混合模式时给出第一处不一致的位置）
+    void reportSymbolMode() const;
+
+    static void printTokens(const std::vector<Token>& tokens);
 };
@@ -0,0 +1,566 @@
+#include "lexer_simd.h"
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LEXER_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang 需要为 SIMD 函数单独开启目标特性（32 位默认不含 SSE2）；MSVC 可以直接使用内建函数
+#if defined(LEXER_SIMD_X86) && (defined(__GNUC__) || defined(__clang__))
+#define LEXER_TARGET_SSE2 __attribute__((target("sse2")))
+#define LEXER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LEXER_TARGET_SSE2
+#define LEXER_TARGET_AVX2
+#endif
+
+namespace lexer_simd {
+
+namespace {
+
+inline unsigned lowestBit(uint32_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+inline size_t popcount(uint32_t mask) {
+#if defined(_MSC_VER)
+    return std::bitset<32>(mask).count();
+#else
+    return static_cast<size_t>(__builtin_popcount(mask));
+#endif
+}
+
+inline bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// === 标量实现（同时负责 SIMD 版本的尾部） ===
+
+size_t skipBlanksScalar(const char* p, size_t n, size_t i = 0) {
+    while (i < n && isBlank(p[i])) ++i;
+    return i;
+}
+
+size_t findAnyScalar(const char* p, size_t n, const char (&set)[4], size_t i = 0) {
+    for (; i < n; ++i) {
+        char c = p[i];
+        if (c == set[0] || c == set[1] || c == set[2] || c == set[3]) return i;
+    }
+    return n;
+}
+
+size_t findCommentEndScalar(const char* p, size_t n, size_t i = 0) {
+    for (; i < n; ++i) {
+        if (p[i] == '\0') return i;
+        if (p[i] == '*' && i + 1 < n && p[i + 1] == '/') return i;
+    }
+    return n;
+}
+
+size_t countByteScalar(const char* p, size_t n, char c, size_t i = 0) {
+    size_t count = 0;
+    for (; i < n; ++i) count += (p[i] == c);
+    return count;
+}
+
+// UTF-8 后续字节（10xxxxxx）按有符号数解释恰好落在 [-128, -65]
+size_t countContinuationScalar(const char* p, size_t n, size_t i = 0) {
+    size_t count = 0;
+    for (; i < n; ++i) count += (static_cast<unsigned char>(p[i]) & 0xC0) == 0x80;
+    return count;
+}
+
+
+size_t findNonAsciiScalar(const char* p, size_t n, size_t i = 0) {
+    while (i < n && static_cast<unsigned char>(p[i]) < 0x80) ++i;
+    return i;
+}
+
+// 逐字符校验（按 Unicode 标准表 3-7 的合法字节序列），从字符边界 i 开始，返回第一个非法序列的偏移或 n
+size_t validateUtf8Scalar(const char* text, size_t n, bool& ascii, size_t i = 0) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text);
+    auto isContinuation = [](unsigned char b) { return (b & 0xC0) == 0x80; };
+    while (i < n) {
+        const unsigned char lead = p[i];
+        if (lead < 0x80) {
+            ++i;
+            continue;
+        }
+        ascii = false;
+        if (lead < 0xC2 || lead > 0xF4) return i;  // 孤立的后续字节、过长的两字节序列、超出范围的首字节
+        if (lead < 0xE0) {
+            if (i + 1 >= n || !isContinuation(p[i + 1])) return i;
+            i += 2;
+        } else if (lead < 0xF0) {
+            // E0 后须 >= A0（过长编码），ED 后须 <= 9F（代理区）
+            const unsigned char low = lead == 0xE0 ? 0xA0 : 0x80;
+            const unsigned char high = lead == 0xED ? 0x9F : 0xBF;
+            if (i + 2 >= n || p[i + 1] < low || p[i + 1] > high || !isContinuation(p[i + 2])) return i;
+            i += 3;
+        } else {
+            // F0 后须 >= 90（过长编码），F4 后须 <= 8F（不超过 U+10FFFF）
+            const unsigned char low = lead == 0xF0 ? 0x90 : 0x80;
+            const unsigned char high = lead == 0xF4 ? 0x8F : 0xBF;
+            if (i + 3 >= n || p[i + 1] < low || p[i + 1] > high || !isContinuation(p[i + 2]) ||
+                !isContinuation(p[i + 3])) {
+                return i;
+            }
+            i += 4;
+        }
+    }
+    return n;
+}
+
+// 从 i 往回找到字符边界（最多退 3 个后续字节），向量实现发现错误后由标量实现从这里定位
+size_t characterStart(const char* p, size_t i) {
+    for (int k = 0; k < 3 && i > 0 && (static_cast<unsigned char>(p[i]) & 0xC0) == 0x80; ++k) --i;
+    return i;
+}
+
+#ifdef LEXER_SIMD_X86
+
+// === SSE2（x86-64 基线指令集） ===
+
+LEXER_TARGET_SSE2 size_t skipBlanksSSE2(const char* p, size_t n) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i blank = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                                     _mm_cmpeq_epi8(v, cr));
+        uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_epi8(blank)) & 0xFFFFu;
+        if (mask) return i + lowestBit(mask);
+    }
+    return skipBlanksScalar(p, n, i);
+}
+
+LEXER_TARGET_SSE2 size_t findAnySSE2(const char* p, size_t n, const char (&set)[4]) {
+    const __m128i s0 = _mm_set1_epi8(set[0]);
+    const __m128i s1 = _mm_set1_epi8(set[1]);
+    const __m128i s2 = _mm_set1_epi8(set[2]);
+    const __m128i s3 = _mm_set1_epi8(set[3]);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, s0), _mm_cmpeq_epi8(v, s1)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(v, s2), _mm_cmpeq_epi8(v, s3)));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        if (mask) return i + lowestBit(mask);
+    }
+    return findAnyScalar(p, n, set, i);
+}
+
+LEXER_TARGET_SSE2 size_t findCommentEndSSE2(const char* p, size_t n) {
+    const __m128i star = _mm_set1_epi8('*');
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    // 第二次加载错开一个字节，因此需要多留一个字节
+    for (; i + 17 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i + 1));
+        __m128i hit = _mm_or_si128(_mm_and_si128(_mm_cmpeq_epi8(v, star), _mm_cmpeq_epi8(next, slash)),
+                                   _mm_cmpeq_epi8(v, zero));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        if (mask) return i + lowestBit(mask);
+    }
+    return findCommentEndScalar(p, n, i);
+}
+
+LEXER_TARGET_SSE2 size_t countByteSSE2(const char* p, size_t n, char c) {
+    const __m128i target = _mm_set1_epi8(c);
+    size_t i = 0;
+    size_t count = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        count += popcount(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, target))));
+    }
+    return count + countByteScalar(p, n, c, i);
+}
+
+LEXER_TARGET_SSE2 size_t countContinuationSSE2(const char* p, size_t n) {
+    const __m128i limit = _mm_set1_epi8(-64);
+    size_t i = 0;
+    size_t count = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        count += popcount(static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(limit, v))));
+    }
+    return count + countContinuationScalar(p, n, i);
+}
+
+LEXER_TARGET_SSE2 size_t findNonAsciiSSE2(const char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(v));
+        if (mask) return i + lowestBit(mask);
+    }
+    return findNonAsciiScalar(p, n, i);
+}
+
+// 校验从字符边界 i 开始的一个字符，返回下一个字符的偏移；非法时返回 n + 1
+size_t validateOneScalar(const char* p, size_t n, size_t i, bool& ascii) {
+    const unsigned char lead = static_cast<unsigned char>(p[i]);
+    const size_t length = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+    const size_t end = std::min(n, i + length);
+    return validateUtf8Scalar(p, end, ascii, i) == end && end == i + length ? end : n + 1;
+}
+
+// SSE2 没有字节查表指令：整块 ASCII 直接跳过，遇到非 ASCII 字节时逐字符校验到块尾之后
+LEXER_TARGET_SSE2 size_t validateUtf8SSE2(const char* p, size_t n, bool& ascii) {
+    size_t i = 0;
+    while (i + 16 <= n) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        if (_mm_movemask_epi8(v) == 0) {
+            i += 16;
+            continue;
+        }
+        const size_t blockEnd = i + 16;
+        while (i < blockEnd) {
+            size_t next = validateOneScalar(p, n, i, ascii);
+            if (next > n) return i;
+            i = next;
+        }
+    }
+    return validateUtf8Scalar(p, n, ascii, i);
+}
+
+// === AVX2 ===
+
+LEXER_TARGET_AVX2 size_t skipBlanksAVX2(const char* p, size_t n) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i blank = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+                                        _mm256_cmpeq_epi8(v, cr));
+        uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(blank));
+        if (mask) return i + lowestBit(mask);
+    }
+    return skipBlanksScalar(p, n, i);
+}
+
+LEXER_TARGET_AVX2 size_t findAnyAVX2(const char* p, size_t n, const char (&set)[4]) {
+    const __m256i s0 = _mm256_set1_epi8(set[0]);
+    const __m256i s1 = _mm256_set1_epi8(set[1]);
+    const __m256i s2 = _mm256_set1_epi8(set[2]);
+    const __m256i s3 = _mm256_set1_epi8(set[3]);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, s0), _mm256_cmpeq_epi8(v, s1)),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(v, s2), _mm256_cmpeq_epi8(v, s3)));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (mask) return i + lowestBit(mask);
+    }
+    return findAnyScalar(p, n, set, i);
+}
+
+LEXER_TARGET_AVX2 size_t findCommentEndAVX2(const char* p, size_t n) {
+    const __m256i star = _mm256_set1_epi8('*');
+    const __m256i slash = _mm256_set1_epi8('/');
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 33 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i + 1));
+        __m256i hit = _mm256_or_si256(_mm256_and_si256(_mm256_cmpeq_epi8(v, star), _mm256_cmpeq_epi8(next, slash)),
+                                      _mm256_cmpeq_epi8(v, zero));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        if (mask) return i + lowestBit(mask);
+    }
+    return findCommentEndScalar(p, n, i);
+}
+
+LEXER_TARGET_AVX2 size_t countByteAVX2(const char* p, size_t n, char c) {
+    const __m256i target = _mm256_set1_epi8(c);
+    size_t i = 0;
+    size_t count = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        count += popcount(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, target))));
+    }
+    return count + countByteScalar(p, n, c, i);
+}
+
+LEXER_TARGET_AVX2 size_t countContinuationAVX2(const char* p, size_t n) {
+    const __m256i limit = _mm256_set1_epi8(-64);
+    size_t i = 0;
+    size_t count = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        count += popcount(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(limit, v))));
+    }
+    return count + countContinuationScalar(p, n, i);
+}
+
+LEXER_TARGET_AVX2 size_t findNonAsciiAVX2(const char* p, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(v));
+        if (mask) return i + lowestBit(mask);
+    }
+    return findNonAsciiScalar(p, n, i);
+}
+
+// AVX2 查表校验（Keiser & Lemire, "Validating UTF-8 In Less Than One Instruction Per Byte"）：
+// 按相邻两个字节的高/低半字节查三张表，三者按位与非零即为非法的两字节组合；
+// 再用前 2、3 个字节是否为三、四字节首字节检查后续字节个数。只判断是否出错，出错时由标量实现定位。
+namespace utf8_lookup {
+constexpr uint8_t kTooShort = 1 << 0;    // 11______ 0_______ / 11______ 11______
+constexpr uint8_t kTooLong = 1 << 1;     // 0_______ 10______
+constexpr uint8_t kOverlong3 = 1 << 2;   // 11100000 100_____
+constexpr uint8_t kTooLarge = 1 << 3;    // 11110100 1001____ 等（超出 U+10FFFF）
+constexpr uint8_t kSurrogate = 1 << 4;   // 11101101 101_____
+constexpr uint8_t kOverlong2 = 1 << 5;   // 1100000_ 10______
+constexpr uint8_t kTooLarge1000 = 1 << 6;  // 11110101 1000____ 等
+constexpr uint8_t kOverlong4 = 1 << 6;   // 11110000 1000____
+constexpr uint8_t kTwoConts = 1 << 7;    // 10______ 10______
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+} // namespace utf8_lookup
+
+LEXER_TARGET_AVX2 inline __m256i lookup16(__m256i index, const int8_t (&table)[16]) {
+    __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table));
+    return _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(half), index);
+}
+
+// 把 prev 的最后 k 个字节拼到 input 前面：结果的第 j 个字节是输入流中 input[j] 之前第 k 个字节
+template <int k>
+LEXER_TARGET_AVX2 inline __m256i previousBytes(__m256i input, __m256i prev) {
+    return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - k);
+}
+
+LEXER_TARGET_AVX2 inline __m256i utf8BlockErrors(__m256i input, __m256i prev) {
+    using namespace utf8_lookup;
+    static const int8_t kByte1High[16] = {
+        kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+        static_cast<int8_t>(kTwoConts), static_cast<int8_t>(kTwoConts),
+        static_cast<int8_t>(kTwoConts), static_cast<int8_t>(kTwoConts),
+        kTooShort | kOverlong2,
+        kTooShort,
+        kTooShort | kOverlong3 | kSurrogate,
+        kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+    };
+    static const int8_t kByte1Low[16] = {
+        static_cast<int8_t>(kCarry | kOverlong3 | kOverlong2 | kOverlong4),
+        static_cast<int8_t>(kCarry | kOverlong2),
+        static_cast<int8_t>(kCarry),
+        static_cast<int8_t>(kCarry),
+        static_cast<int8_t>(kCarry | kTooLarge),
+        static_cast<int8_t>(kCarry | kTooLarge | kTooLarge1000),
+        static_cast<int8_t>(kCarry | kTooLarge | kTooLarge1000),
+        static_cast<int8_t>(kCarry | kTooLarge | kTooLarge1000),
+        static_cast<int8_t>(kCarry | kTooLarge | kTooLarge1000),
+        static_cast<int8_t>(kCarry | kTooLarge | kTooLarge1000),
+        static_cast<int8_t>(kCarry | kTooLarge | kTooLarge1000),
+        static_cast<int8_t>(kCarry | kTooLarge | kTooLarge1000),
+        static_cast<int8_t>(kCarry | kTooLarge | kTooLarge1000),
+        static_cast<int8_t>(kCarry | kTooLarge | kTooLarge1000 | kSurrogate),
+        static_cast<int8_t>(kCarry | kTooLarge | kTooLarge1000),
+        static_cast<int8_t>(kCarry | kTooLarge | kTooLarge1000),
+    };
+    static const int8_t kByte2High[16] = {
+        kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+        static_cast<int8_t>(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4),
+        static_cast<int8_t>(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge),
+        static_cast<int8_t>(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge),
+        static_cast<int8_t>(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge),
+        kTooShort, kTooShort, kTooShort, kTooShort,
+    };
+
+    const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+    const __m256i prev1 = previousBytes<1>(input, prev);
+    const __m256i byte1High = lookup16(_mm256_and_si256(_mm256_srli_epi16(prev1, 4), lowNibble), kByte1High);
+    const __m256i byte1Low = lookup16(_mm256_and_si256(prev1, lowNibble), kByte1Low);
+    const __m256i byte2High = lookup16(_mm256_and_si256(_mm256_srli_epi16(input, 4), lowNibble), kByte2High);
+    const __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+    // 三、四字节序列的第 3、4 个字节必须是后续字节（上面的查表只会把它们标成 kTwoConts）
+    const __m256i prev2 = previousBytes<2>(input, prev);
+    const __m256i prev3 = previousBytes<3>(input, prev);
+    const __m256i isThird = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    const __m256i isFourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    const __m256i must23 = _mm256_and_si256(_mm256_or_si256(isThird, isFourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+    return _mm256_xor_si256(must23, special);
+}
+
+// 块尾是否有尚未结束的多字节序列（下一块必须从后续字节开始）
+LEXER_TARGET_AVX2 inline __m256i utf8Incomplete(__m256i input) {
+    const __m256i maxValue = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+    return _mm256_subs_epu8(input, maxValue);
+}
+
+LEXER_TARGET_AVX2 size_t validateUtf8AVX2(const char* p, size_t n, bool& ascii) {
+    __m256i prev = _mm256_setzero_si256();
+    __m256i prevIncomplete = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        __m256i error = prevIncomplete;
+        if (_mm256_movemask_epi8(input) == 0) {
+            prevIncomplete = _mm256_setzero_si256();
+        } else {
+            ascii = false;
+            error = utf8BlockErrors(input, prev);
+            prevIncomplete = utf8Incomplete(input);
+        }
+        if (!_mm256_testz_si256(error, error)) {
+            // 错误可能出在上一块末尾开始的序列上，从其首字节起逐字符定位
+            return validateUtf8Scalar(p, n, ascii, characterStart(p, i > 0 ? i - 1 : 0));
+        }
+        prev = input;
+    }
+    // 尾部不足一块：从跨越块边界的那个字符起标量校验（同时检查上一块末尾未结束的序列）
+    return validateUtf8Scalar(p, n, ascii, characterStart(p, i > 0 ? i - 1 : 0));
+}
+
+bool cpuHasAVX2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx) return false;
+    // 操作系统需要保存 YMM 寄存器状态
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // LEXER_SIMD_X86
+
+Level detectLevel() {
+#ifdef LEXER_SIMD_X86
+#if defined(__x86_64__) || defined(_M_X64)
+    return cpuHasAVX2() ? Level::AVX2 : Level::SSE2;
+#else
+    // 32 位 x86 不保证有 SSE2
+    if (cpuHasAVX2()) return Level::AVX2;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) ? Level::SSE2 : Level::Scalar;
+#else
+    return __builtin_cpu_supports("sse2") ? Level::SSE2 : Level::Scalar;
+#endif
+#endif
+#else
+    return Level::Scalar;
+#endif
+}
+
+const Level kDetectedLevel = detectLevel();
+Level gLevel = kDetectedLevel;
+
+} // namespace
+
+size_t skipBlanks(const char* p, size_t n) {
+#ifdef LEXER_SIMD_X86
+    if (gLevel == Level::AVX2) return skipBlanksAVX2(p, n);
+    if (gLevel == Level::SSE2) return skipBlanksSSE2(p, n);
+#endif
+    return skipBlanksScalar(p, n);
+}
+
+size_t findAny(const char* p, size_t n, const char (&set)[4]) {
+#ifdef LEXER_SIMD_X86
+    if (gLevel == Level::AVX2) return findAnyAVX2(p, n, set);
+    if (gLevel == Level::SSE2) return findAnySSE2(p, n, set);
+#endif
+    return findAnyScalar(p, n, set);
+}
+
+size_t findCommentEnd(const char* p, size_t n) {
+#ifdef LEXER_SIMD_X86
+    if (gLevel == Level::AVX2) return findCommentEndAVX2(p, n);
+    if (gLevel == Level::SSE2) return findCommentEndSSE2(p, n);
+#endif
+    return findCommentEndScalar(p, n);
+}
+
+size_t countByte(const char* p, size_t n, char c) {
+#ifdef LEXER_SIMD_X86
+    if (gLevel == Level::AVX2) return countByteAVX2(p, n, c);
+    if (gLevel == Level::SSE2) return countByteSSE2(p, n, c);
+#endif
+    return countByteScalar(p, n, c);
+}
+
+size_t countCodepoints(const char* p, size_t n) {
+#ifdef LEXER_SIMD_X86
+    if (gLevel == Level::AVX2) return n - countContinuationAVX2(p, n);
+    if (gLevel == Level::SSE2) return n - countContinuationSSE2(p, n);
+#endif
+    return n - countContinuationScalar(p, n);
+}
+
+size_t findNonAscii(const char* p, size_t n) {
+#ifdef LEXER_SIMD_X86
+    if (gLevel == Level::AVX2) return findNonAsciiAVX2(p, n);
+    if (gLevel == Level::SSE2) return findNonAsciiSSE2(p, n);
+#endif
+    return findNonAsciiScalar(p, n);
+}
+
+Utf8Validation validateUtf8(const char* p, size_t n) {
+    bool ascii = true;
+    size_t error;
+#ifdef LEXER_SIMD_X86
+    if (gLevel == Level::AVX2) {
+        error = validateUtf8AVX2(p, n, ascii);
+    } else if (gLevel == Level::SSE2) {
+        error = validateUtf8SSE2(p, n, ascii);
+    } else {
+        error = validateUtf8Scalar(p, n, ascii);
+    }
+#else
+    error = validateUtf8Scalar(p, n, ascii);
+#endif
+    return {error, ascii && error == n};
+}
+
+Level activeLevel() {
+    return gLevel;
+}
+
+void forceLevel(Level level) {
+    gLevel = static_cast<int>(level) < static_cast<int>(kDetectedLevel) ? level : kDetectedLevel;
+}
+
+const char* levelName(Level level) {
+    switch (level) {
+        case Level::AVX2: return "avx2";
+        case Level::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+} // namespace lexer_simd
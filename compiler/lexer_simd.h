@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+
+// 词法分析器的批量扫描内核
+// 一次检查 16（SSE2）或 32（AVX2）个字节，定位下一个“有意义”的字节；
+// 运行时按 CPU 能力选择实现，非 x86 平台或不支持时退回逐字节的标量实现。
+// 所有函数返回相对 p 的偏移，找不到时返回 n。
+namespace lexer_simd {
+
+enum class Level { Scalar, SSE2, AVX2 };
+
+// 跳过空白（' '、'\t'、'\r'，不含换行），返回第一个非空白字节的偏移
+size_t skipBlanks(const char* p, size_t n);
+
+// 查找 set 中任一字节第一次出现的位置（set 固定 4 个字节，可重复）
+size_t findAny(const char* p, size_t n, const char (&set)[4]);
+
+// 查找多行注释的结束位置：第一个 "*/" 或 '\0'
+size_t findCommentEnd(const char* p, size_t n);
+
+// 统计 c 出现的次数（用于批量更新行号）
+size_t countByte(const char* p, size_t n, char c);
+
+// 统计字符数（非 10xxxxxx 的字节数，用于按需计算列号）
+size_t countCodepoints(const char* p, size_t n);
+
+// 查找第一个非 ASCII 字节（>= 0x80），转码时整段复制之前的 ASCII 字节
+size_t findNonAscii(const char* p, size_t n);
+
+// UTF-8 校验结果：errorOffset 为第一个非法序列首字节的偏移（合法时为 n），ascii 表示所有字节都小于 0x80
+struct Utf8Validation {
+    size_t errorOffset;
+    bool ascii;
+};
+
+// 严格校验 UTF-8（拒绝过长编码、代理区码点、超出 U+10FFFF 的序列以及结尾被截断的序列），顺带判断是否纯 ASCII
+Utf8Validation validateUtf8(const char* p, size_t n);
+
+// 当前使用的实现；forceLevel 只能降级（基准测试对比标量实现时使用）
+Level activeLevel();
+void forceLevel(Level level);
+const char* levelName(Level level);
+
+} // namespace lexer_simd
@@ -5,6 +5,7 @@
 #include "error.h"
 #include "ast_interpreter.h"
 #include "symbol_config.h"
+#include "source_encoding.h"
 
 // 然后包含标准库
 #include <iostream>
@@ -85,6 +86,9 @@ void printUsage() {
     std::cout << "  --no-deps          跳过依赖解析（仅编译本地代码）" << std::endl;
     std::cout << "  --deps-info        显示依赖信息" << std::endl;
     std::cout << "  -v, --verbose       详细输出模式" << std::endl;
+    std::cout << "  --symbol-map <文件> 用指定的 JSON 覆盖内置的本地化符号表（英文文件名也按它识别本地化符号）" << std::endl;
+    std::cout << "  --tree-walk         直接遍历指针树解释执行（默认先转换为扁平 AST，输出相同，用于对照）" << std::endl;
+    std::cout << "  --skeleton          骨架模式：只解析从入口函数用到的函数体，其余函数体中的错误不报告" << std::endl;
     std::cout << std::endl;
     std::cout << "示例:" << std::endl;
     std::cout << "  polyglot main.pg                编译程序" << std::endl;
@@ -92,59 +96,6 @@ void printUsage() {
     std::cout << "  polyglot --clean-cache          清理依赖缓存" << std::endl;
 }
 
-std::string readFile(const std::string& filename) {
-#ifdef _WIN32
-    // 使用宽字符接口读取UTF-8路径的文件
-    int wlen = MultiByteToWideChar(CP_UTF8, 0, filename.c_str(), -1, nullptr, 0);
-    if (wlen <= 0) {
-        throw CompilerError("路径转码失败: " + filename);
-    }
-    std::wstring wpath;
-    wpath.resize(wlen - 1);
-    MultiByteToWideChar(CP_UTF8, 0, filename.c_str(), -1, &wpath[0], wlen);
-
-    FILE* fp = _wfopen(wpath.c_str(), L"rb");
-    if (!fp) {
-        throw CompilerError("无法打开文件: " + filename);
-    }
-    std::string content;
-    char buf[4096];
-    size_t n;
-    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
-        content.append(buf, n);
-    }
-    fclose(fp);
-    // 规范换行到\n
-    std::string normalized;
-    normalized.reserve(content.size());
-    for (size_t i = 0; i < content.size(); ++i) {
-        if (content[i] == '\r') {
-            if (i + 1 < content.size() && content[i + 1] == '\n') {
-                // skip, handled by next char
-            } else {
-                normalized.push_back('\n');
-            }
-        } else {
-            normalized.push_back(content[i]);
-        }
-    }
-    return normalized;
-#else
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        throw CompilerError("无法打开文件: " + filename);
-    }
-
-    std::string content;
-    std::string line;
-    while (std::getline(file, line)) {
-        content += line + "\n";
-    }
-
-    return content;
-#endif
-}
-
 // 判断文件名（不含扩展名）是否纯英文（ASCII 字母/数字/下划线/连字符）
 bool isEnglishFilename(const std::string& filepath) {
     // 仅依据“完整文件名”（含扩展名）判断是否为英文；任意非 ASCII 即视为中文/本地化
@@ -161,135 +112,6 @@ bool isEnglishFilename(const std::string& filepath) {
     return true;
 }
 
-// 判断源码是否纯 ASCII（忽略常见空白字符）
-bool isAsciiContent(const std::string& content) {
-    // 跳过 UTF-8 BOM
-    size_t i = 0;
-    if (content.size() >= 3 && (unsigned char)content[0] == 0xEF && (unsigned char)content[1] == 0xBB && (unsigned char)content[2] == 0xBF) {
-        i = 3;
-    }
-    for (; i < content.size(); ++i) {
-        unsigned char ch = static_cast<unsigned char>(content[i]);
-        if (ch <= 127) continue; // ASCII
-        return false;            // 出现非 ASCII
-    }
-    return true;
-}
-
-// 简单解析 JSON，提取 string_delimiters.double_quote 列表（不依赖第三方库）
-static std::vector<std::string> parseDoubleQuoteVariants(const std::string& json) {
-    std::vector<std::string> variants;
-    const std::string key = "\"double_quote\"";
-    size_t pos = json.find(key);
-    if (pos == std::string::npos) return variants;
-    size_t lb = json.find('[', pos);
-    size_t rb = json.find(']', lb);
-    if (lb == std::string::npos || rb == std::string::npos) return variants;
-    std::string arr = json.substr(lb + 1, rb - lb - 1);
-    size_t cur = 0;
-    while (true) {
-        size_t q1 = arr.find('"', cur);
-        if (q1 == std::string::npos) break;
-        size_t q2 = arr.find('"', q1 + 1);
-        if (q2 == std::string::npos) break;
-        variants.push_back(arr.substr(q1 + 1, q2 - q1 - 1));
-        cur = q2 + 1;
-    }
-    return variants;
-}
-
-// 将源码中的非英文符号替换为 ASCII 规范符号（依据 symbol_mapping.json 和类型同类映射）
-std::string normalizeSourceBySymbols(const std::string& source, const std::string& jsonPath) {
-    std::string normalized = source;
-
-    // 1) 加载 JSON 配置
-    SymbolConfigLoader loader(jsonPath);
-    loader.loadConfig();
-    const auto& allMap = loader.getAllSymbolTokenTypes();
-
-    // 2) 先收集 ASCII 代表符号
-    std::unordered_map<int, std::string> asciiCanonical;
-    for (const auto& kv : allMap) {
-        const std::string& sym = kv.first;
-        auto tt = kv.second;
-        bool isAscii = std::all_of(sym.begin(), sym.end(), [](unsigned char c){ return c <= 127; });
-        if (isAscii) {
-            int key = static_cast<int>(tt);
-            if (!asciiCanonical.count(key)) asciiCanonical[key] = sym;
-        }
-    }
-
-    // 3) 获取所有引号变体，并首先统一为 ASCII 双引号
-    std::string asciiQuote = "\""; // 默认
-    try {
-        std::string json = readFile(jsonPath);
-        auto dq = parseDoubleQuoteVariants(json);
-        if (!dq.empty()) asciiQuote = dq.front();
-        for (const auto& v : parseDoubleQuoteVariants(readFile(jsonPath))) {
-            if (v != asciiQuote) {
-                size_t pos = 0;
-                while ((pos = normalized.find(v, pos)) != std::string::npos) {
-                    normalized.replace(pos, v.size(), asciiQuote);
-                    pos += asciiQuote.size();
-                }
-            }
-        }
-    } catch (...) {
-        // 忽略
-    }
-
-    // 4) 构造除引号以外的替换表
-    std::vector<std::pair<std::string,std::string>> replaces;
-    for (const auto& kv : allMap) {
-        const std::string& sym = kv.first;
-        auto tt = kv.second;
-        bool isAscii = std::all_of(sym.begin(), sym.end(), [](unsigned char c){ return c <= 127; });
-        if (!isAscii) {
-            int key = static_cast<int>(tt);
-            auto it = asciiCanonical.find(key);
-            if (it != asciiCanonical.end() && it->second != sym) {
-                // 跳过将引号变体替换为 ASCII 的项（已在前一步处理）
-                if (!(sym == asciiQuote || it->second == asciiQuote)) {
-                    replaces.emplace_back(sym, it->second);
-                }
-            }
-        }
-    }
-
-    // 5) 仅在字符串字面量之外执行符号替换
-    std::sort(replaces.begin(), replaces.end(), [](const auto& a, const auto& b){ return a.first.size() > b.first.size(); });
-    std::string out;
-    out.reserve(normalized.size());
-    bool inString = false;
-    for (size_t i = 0; i < normalized.size();) {
-        if (normalized.compare(i, asciiQuote.size(), asciiQuote) == 0) {
-            // 切换字符串状态并复制引号本身
-            inString = !inString;
-            out.append(asciiQuote);
-            i += asciiQuote.size();
-            continue;
-        }
-        if (!inString) {
-            bool replaced = false;
-            for (const auto& rp : replaces) {
-                const auto& from = rp.first;
-                const auto& to = rp.second;
-                if (normalized.compare(i, from.size(), from) == 0) {
-                    out.append(to);
-                    i += from.size();
-                    replaced = true;
-                    break;
-                }
-            }
-            if (replaced) continue;
-        }
-        out.push_back(normalized[i]);
-        ++i;
-    }
-
-    return out;
-}
-
 // 构建并运行生成的C++代码
 bool runGeneratedCppCode(const std::string& cppCode, const std::string& baseName) {
     // 生成输出文件名
@@ -375,8 +197,9 @@ bool runGeneratedCppCode(const std::string& cppCode, const std::string& baseName
 }
 
 // 带选项的编译函数
-void compileWithOptions(const std::string& sourceCode, const std::string& filename,
-                       bool updateDeps, bool noDeps, bool verbose, polyglot::IntegratedPackageManager& packageManager) {
+void compileWithOptions(const SourceBuffer& sourceCode, const std::string& filename,
+                       bool updateDeps, bool noDeps, bool verbose, bool treeWalk, bool skeleton,
+                       polyglot::IntegratedPackageManager& packageManager) {
     std::cout << "🚀 开始解释执行 polyglot 程序: " << filename << std::endl;
 
     try {
@@ -413,25 +236,41 @@ void compileWithOptions(const std::string& sourceCode, const std::string& filena
         }
 
         // 1. 词法分析 (Lexical Analysis)
-        std::cout << "📝 步骤 1: 词法分析..." << std::endl;
+        // 非 verbose 模式下词法分析与语法分析交替进行（流式），不物化整个Token序列；
+        // 大文件与骨架模式例外：先并行扫描出完整的Token序列，再按顶层项并行解析
+        // 换行折叠为 Token 上的标志，语法分析不再逐个跳过 NEWLINE
         Lexer lexer(sourceCode);
-        std::vector<Token> tokens = lexer.tokenize();
-        std::cout << "   🔤 词法分析完成" << std::endl;
-
-        // 调试：打印前20个Token用于分析
+        lexer.setFoldNewlines(true);
+        TokenStore tokens;
+        const bool batch = verbose || skeleton || sourceCode.size() >= 2 * Lexer::kMinParallelChunk;
+        if (batch) {
+            std::cout << "📝 步骤 1: 词法分析..." << std::endl;
+            tokens = lexer.scanParallel();
+            std::cout << "   🔤 词法分析完成" << std::endl;
+        }
         if (verbose) {
+            lexer.reportSymbolMode();
+
+            // 调试：打印前20个Token用于分析
             std::cout << "   🔍 前20个Token:" << std::endl;
             size_t maxTokens = tokens.size() < 20 ? tokens.size() : 20;
             for (size_t i = 0; i < maxTokens; ++i) {
-                std::cout << "     [" << i << "] 类型=" << static_cast<int>(tokens[i].type)
-                          << ", 值='" << tokens[i].value << "'" << std::endl;
+                std::cout << "     [" << i << "] 类型=" << static_cast<int>(tokens.kind(i))
+                          << ", 值='" << tokens.token(i).value() << "'" << std::endl;
             }
+        } else if (!batch) {
+            std::cout << "📝 步骤 1: 词法分析（流式，与语法分析交替进行）..." << std::endl;
         }
 
         // 2. 语法分析 (Syntax Analysis)
+        // 默认完整解析全部函数体，报告的错误与是否 verbose、文件大小无关。
+        // --skeleton 时函数体先只记下Token区间，语义分析从入口函数出发只解析用到的函数体
+        // （它要求Token序列在整个编译期间有效，因此总是走批量路径）
         std::cout << "🔍 步骤 2: 语法分析..." << std::endl;
-        Parser parser(tokens);
-        auto ast = parser.parse();
+        std::unique_ptr<Parser> parser = batch ? std::make_unique<Parser>(tokens)
+                                               : std::make_unique<Parser>(lexer);
+        parser->setSkeleton(skeleton);
+        auto ast = batch ? parser->parseParallel() : parser->parse();
         std::cout << "   ✅ 生成了抽象语法树" << std::endl;
 
         // 3. 语义分析 (Semantic Analysis)
@@ -439,10 +278,20 @@ void compileWithOptions(const std::string& sourceCode, const std::string& filena
         SemanticAnalyzer semanticAnalyzer;
         bool semanticSuccess = semanticAnalyzer.analyze(ast);
         if (!semanticSuccess) {
-            std::cerr << "❌ 语义分析失败，停止编译" << std::endl;
-            return;
+            // 错误列表已打印到标准输出；以第一条错误结束（--quiet 时它是唯一可见的诊断，退出码非零）
+            const SemanticErrorInfo& first = semanticAnalyzer.getErrors().front();
+            throw SemanticError(first.message, first.line, first.column);
         }
         std::cout << "   ✅ 语义检查通过" << std::endl;
+        // 没有解析的函数体中的错误不会报告，明确告诉用户是哪些函数（--quiet 时也提示）
+        const std::vector<const FunctionDecl*>& unparsed = semanticAnalyzer.getUnparsedBodies();
+        if (!unparsed.empty()) {
+            std::cerr << "⚠️ 骨架模式：" << unparsed.size() << " 个函数体未解析，其中的错误不会报告:";
+            for (const FunctionDecl* function : unparsed) {
+                std::cerr << " " << function->name;
+            }
+            std::cerr << std::endl;
+        }
 
         // 4. AST可视化（如果需要）
         if (verbose) {
@@ -452,13 +301,20 @@ void compileWithOptions(const std::string& sourceCode, const std::string& filena
 
         // 5. AST分析
         std::cout << "🔍 步骤 5: AST分析..." << std::endl;
-        auto analysis = polyglot::ASTAnalyzer::analyze(dynamic_cast<Program*>(ast.get()));
+        auto analysis = polyglot::ASTAnalyzer::analyze(ast.get());
         std::cout << "   ✅ AST分析完成" << std::endl;
 
-        // 6. AST解释执行
+        // 6. AST解释执行：先转换为扁平 AST（节点按种类连续存放，遍历不再追指针）；--tree-walk 保留树遍历作对照
         std::cout << "🚀 步骤 7: AST解释执行..." << std::endl;
         polyglot::ASTInterpreter interpreter;
-        auto result = interpreter.interpret(ast);
+        if (treeWalk) {
+            interpreter.interpret(ast);
+        } else {
+            const flat_ast::Ast flat = flat_ast::Ast::fromProgram(*ast);
+            std::cout << "   🧱 扁平 AST: " << flat.nodeCount() << " 个节点，" << flat.bytesUsed()
+                      << " 字节（指针树 " << ast->arena.bytesUsed() << " 字节）" << std::endl;
+            interpreter.interpret(flat);
+        }
 
         std::cout << "\n🎉 polyglot程序解释执行完成！" << std::endl;
         std::cout << "   📊 程序统计:" << std::endl;
@@ -491,7 +347,8 @@ void compile(const std::string& sourceCode, const std::string& filename) {
     polyglot::IntegratedPackageManager packageManager(project_root);
 
     // 使用默认选项调用带选项的编译函数
-    compileWithOptions(sourceCode, filename, false, false, false, packageManager);
+    SourceBuffer buffer(sourceCode);
+    compileWithOptions(buffer, filename, false, false, false, false, false, packageManager);
 }
 
 
@@ -537,6 +394,9 @@ int main(int argc, char* argv[]) {
     bool showDepsInfo = false;
     bool verbose = false;
     bool quiet = false;
+    bool treeWalk = false;
+    bool skeleton = false;
+    std::string symbolMapFile;
     std::string sourceFile;
 
     // 处理选项
@@ -558,6 +418,17 @@ int main(int argc, char* argv[]) {
             verbose = true;
         } else if (arg == "--quiet") {
             quiet = true;
+        } else if (arg == "--tree-walk") {
+            treeWalk = true;
+        } else if (arg == "--skeleton") {
+            skeleton = true;
+        } else if (arg == "--symbol-map") {
+            if (i + 1 >= args.size()) {
+                std::cerr << "❌ --symbol-map 需要指定 JSON 文件" << std::endl;
+                printUsage();
+                return 1;
+            }
+            symbolMapFile = args[++i];
         } else if (arg.find("--") == 0) {
             std::cerr << "❌ 未知选项: " << arg << std::endl;
             printUsage();
@@ -618,31 +489,50 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
-        // 读取源代码
-        std::string sourceCode = readFile(sourceFile);
+        // 映射源文件并统一为 UTF-8（GBK/GB18030 文件在这里转码），后续各阶段只持有视图；
+        // UTF-8 源码直接在映射上分析，CRLF 与 BOM 由词法分析器处理，不再复制规范化。
+        // 加载时一次性校验编码：非法字节在这里报告，词法分析之后不再逐字符检查，纯 ASCII 源码只按字节扫描
+        source_encoding::Charset charset = source_encoding::Charset::Utf8;
+        SourceBuffer sourceBuffer = source_encoding::loadSource(SourceBuffer(SourceFile::open(sourceFile)), &charset);
+        if (!quiet && charset != source_encoding::Charset::Utf8) {
+            std::cout << "🈶 检测到 " << source_encoding::charsetName(charset) << " 编码的源码，已转为 UTF-8" << std::endl;
+        }
 
-        // 语种检测：英文文件名 -> 使用默认符号；非英文文件名 -> 加载 JSON 并进行源码规范化
+        // 语种检测：英文文件名 -> 使用默认符号；非英文文件名 -> 使用本地化符号表
         if (!isEnglishFilename(sourceFile)) {
             // 新规则：中文/本地化文件名，但源码为英文/ASCII，直接报错提示开发者
-            if (isAsciiContent(sourceCode)) {
+            // 纯 ASCII 判断沿用加载期校验的结论（UTF-8 BOM 不算作非 ASCII 内容）
+            std::string_view content = utf8::stripBom(sourceBuffer.text());
+            bool asciiContent = sourceBuffer.encoding() == SourceBuffer::Encoding::Ascii ||
+                                (content.size() < sourceBuffer.size() &&
+                                 lexer_simd::validateUtf8(content.data(), content.size()).ascii);
+            if (asciiContent) {
                 throw CompilerError("检测到中文/本地化文件名，但源码为英文/ASCII。请将文件名改为英文，或将代码改为中文/全角风格（例如使用书名号“”、返回箭头《- 等）。");
             }
 
-            if (!quiet) std::cout << "🌐 检测到非英文文件名，按本地化符号配置进行规范化处理..." << std::endl;
-            // 1) 预处理：将源代码中的本地化符号规范化为ASCII（避免在编译器内部处理全角）
-            sourceCode = normalizeSourceBySymbols(sourceCode, "symbol_mapping.json");
-            // 2) 替换内存中的符号映射（如需在后续阶段基于JSON的符号集做进一步处理）
-            SymbolConfigLoader loader("symbol_mapping.json");
-            if (loader.loadConfig()) {
-                Lexer::OverrideSymbolMap(loader.getAllSymbolTokenTypes());
-            }
-        } else {
+            if (!quiet) std::cout << "🌐 检测到非英文文件名，按本地化符号配置进行词法分析..." << std::endl;
+            // 词法分析器直接识别全角/本地化符号与中文引号，不再预先改写源码（诊断位置即原文位置）。
+            // 本地化符号表在构建期由 symbol_mapping.json 生成，与工作目录无关；只有用户指定覆盖时才解析 JSON
+            Lexer::UseBuiltinLocalizedSymbols();
+        } else if (symbolMapFile.empty()) {
             if (!quiet) std::cout << "🔤 检测到英文文件名，使用默认符号映射（不加载JSON）" << std::endl;
             Lexer::ClearOverride();
+        } else {
+            if (!quiet) std::cout << "🔤 检测到英文文件名，按 --symbol-map 指定的符号映射进行词法分析" << std::endl;
+        }
+
+        // 用户指定的符号映射无论文件名是否为英文都生效
+        if (!symbolMapFile.empty()) {
+            SymbolConfigLoader loader(symbolMapFile);
+            // 文件缺失或为空时 loadConfig 也返回 true，但得到的是空表
+            if (!loader.loadConfig() || loader.getAllSymbolTokenTypes().empty()) {
+                throw CompilerError("无法加载符号映射文件: " + symbolMapFile);
+            }
+            Lexer::OverrideSymbolMap(loader.getAllSymbolTokenTypes());
         }
 
         // 使用AST解释器模式进行编译执行
-        compileWithOptions(sourceCode, sourceFile, updateDeps, noDeps, verbose, packageManager);
+        compileWithOptions(sourceBuffer, sourceFile, updateDeps, noDeps, verbose, treeWalk, skeleton, packageManager);
 
         // 恢复输出
         if (quiet && oldBuf) {
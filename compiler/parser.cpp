@@ -3,26 +3,117 @@
 #include <iostream>
 #include <algorithm>
 #include <unordered_set>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <thread>
 
-Parser::Parser(const std::vector<Token>& tokens) : tokens(tokens), current(0) {
+static const Token eofToken(TokenType::EOF_TOKEN, std::string_view(), 0, 0);
+
+Parser::Parser(const std::vector<Token>& tokens) : tokens(&tokens), previous(eofToken) {
     std::cout << "🚀 Parser初始化完成，准备解析 " << tokens.size() << " 个Token" << std::endl;
 }
 
-Token& Parser::peek() {
-    if (current >= tokens.size()) {
-        static Token eofToken = {TokenType::EOF_TOKEN, "", 0, 0};
+Parser::Parser(Lexer& lexer) : lexer(&lexer), previous(eofToken) {
+    std::cout << "🚀 Parser初始化完成（流式模式）" << std::endl;
+}
+
+Parser::Parser(const TokenStore& store)
+    : previous(eofToken), store(&store), window(kWindowSize, eofToken), windowIndex(kWindowSize, SIZE_MAX) {
+    std::cout << "🚀 Parser初始化完成，准备解析 " << store.size() << " 个Token" << std::endl;
+}
+
+// 补解析函数体的解析器：与原解析器共用Token序列，节点分配在 Program 的 arena 中
+class Parser::LazyBodies : public BodySource {
+private:
+    Parser parser;
+
+public:
+    LazyBodies(const std::vector<Token>* tokens, const TokenStore* store, AstArena& arena)
+        : parser(tokens, store, std::cout) {
+        parser.arena = &arena;
+    }
+
+    Block* parseBody(size_t begin, size_t end) override {
+        parser.current = begin;
+        Block* body = parser.parseBlock();
+        if (parser.current != end) {
+            throw parser.errorAt(parser.peek(), "函数体的范围与花括号配对不一致");
+        }
+        return body;
+    }
+};
+
+Parser::Parser(const std::vector<Token>* tokens, const TokenStore* store, std::ostream& log)
+    : tokens(tokens), previous(eofToken), store(store), log(&log) {
+    if (store) {
+        window.assign(kWindowSize, eofToken);
+        windowIndex.assign(kWindowSize, SIZE_MAX);
+    }
+}
+
+// 紧凑模式下的Token按下标轮换存放在小窗口里：前瞻与刚消费的Token同时有效
+const Token& Parser::storeToken(size_t index) {
+    if (index >= store->size()) {
         return eofToken;
     }
-    return tokens[current];
+    size_t slot = index % kWindowSize;
+    if (windowIndex[slot] != index) {
+        window[slot] = Token(store->kind(index), store->text(index), 0, 0);
+        window[slot].newlineBefore = store->newlineBefore(index);
+        TokenType kind = store->kind(index);
+        if (kind == TokenType::INTEGER_LITERAL || kind == TokenType::FLOAT_LITERAL) {
+            window[slot].number = store->number(index);
+        }
+        windowIndex[slot] = index;
+    }
+    return window[slot];
+}
+
+const Token& Parser::peek() {
+    return peekAt(0);
 }
 
-Token& Parser::advance() {
+const Token& Parser::peekAt(size_t offset) {
+    if (lexer) {
+        return lexer->peek(offset);
+    }
+    if (store) {
+        return storeToken(current + offset);
+    }
+    if (current + offset >= tokens->size()) {
+        return eofToken;
+    }
+    return (*tokens)[current + offset];
+}
+
+const Token& Parser::advance() {
+    if (lexer) {
+        if (!isAtEnd()) previous = lexer->next();
+        return previous;
+    }
     if (!isAtEnd()) current++;
-    return tokens[current - 1];
+    if (store) {
+        return storeToken(current - 1);
+    }
+    return (*tokens)[current - 1];
 }
 
 bool Parser::isAtEnd() {
-    return current >= tokens.size() || peek().type == TokenType::EOF_TOKEN;
+    if (lexer) {
+        return peek().type == TokenType::EOF_TOKEN;
+    }
+    if (store) {
+        return current >= store->size() || peek().type == TokenType::EOF_TOKEN;
+    }
+    return current >= tokens->size() || peek().type == TokenType::EOF_TOKEN;
+}
+
+bool Parser::checkSameLine(TokenType type) {
+    const Token& token = peek();
+    return token.type == type && !token.newlineBefore;
 }
 
 bool Parser::match(TokenType type) {
@@ -39,20 +130,181 @@ void Parser::consume(TokenType type, const std::string& message) {
         return;
     }
 
-    Token& token = peek();
-    throw ParserError(message, token.line, token.column);
+    throw errorAt(peek(), message);
+}
+
+SymbolId Parser::identifierName(std::string_view& name) {
+    std::string_view text = advance().text;
+    auto it = symbolCache.find(text);
+    if (it == symbolCache.end()) {
+        SymbolId id = Interner::global().intern(text);
+        it = symbolCache.emplace(Interner::global().name(id), id).first;
+    }
+    name = it->first;
+    return it->second;
+}
+
+ParserError Parser::errorAt(const Token& token, const std::string& message) const {
+    if (store && token.text.data() != nullptr) {
+        SourcePosition position = store->locate(static_cast<size_t>(token.text.data() - store->sourceText().data()));
+        return ParserError(message, position.line, position.column);
+    }
+    return ParserError(message, token.line, token.column);
 }
 
 std::unique_ptr<Program> Parser::parse() {
     auto program = std::make_unique<Program>();
+    arena = &program->arena;
+    if (skeleton && !lexer) {
+        program->bodySource = std::make_unique<LazyBodies>(tokens, store, program->arena);
+        bodySource = program->bodySource.get();
+    }
+
+    std::cout << "   📋 开始解析polyglot代码..." << std::endl;
+    if (tokens) {
+        std::cout << "   📋 Token数量: " << tokens->size() << std::endl;
+    } else if (store) {
+        std::cout << "   📋 Token数量: " << store->size() << std::endl;
+    }
+
+    try {
+        while (!isAtEnd()) {
+            if (auto stmt = parseTopLevelStatement()) {
+                program->statements.push_back(stmt);
+            }
+        }
+
+        std::cout << "   ✅ 解析完成，生成了 " << program->statements.size() << " 个顶级语句" << std::endl;
+    } catch (const ParserError& e) {
+        // 流式模式下词法错误优先：先把剩余源码扫完，若存在词法错误则由它抛出（与批量模式一致）
+        if (lexer) {
+            while (lexer->next().type != TokenType::EOF_TOKEN) {
+            }
+        }
+        std::cout << "   ❌ 解析错误: " << e.what() << std::endl;
+        throw;
+    }
+
+    return program;
+}
+
+size_t Parser::tokenCount() const {
+    return store ? store->size() : tokens->size();
+}
+
+TokenType Parser::kindAt(size_t index) const {
+    return store ? store->kind(index) : (*tokens)[index].type;
+}
+
+std::string_view Parser::textAt(size_t index) const {
+    return store ? store->text(index) : (*tokens)[index].text;
+}
+
+bool Parser::newlineAt(size_t index) const {
+    return store ? store->newlineBefore(index) : (*tokens)[index].newlineBefore;
+}
+
+std::vector<size_t> Parser::splitTopLevelItems(size_t chunkCount) const {
+    const size_t count = tokenCount();
+    const size_t target = (count - current) / chunkCount;
+    std::vector<size_t> bounds{current};
+    size_t depth = 0;
+    for (size_t i = current; i < count && bounds.size() < chunkCount; ++i) {
+        TokenType kind = kindAt(i);
+        if (kind == TokenType::LEFT_BRACE) {
+            ++depth;
+        } else if (kind == TokenType::RIGHT_BRACE && depth > 0 && --depth == 0) {
+            // 函数、@结构体、&实现块都以配对的 '}' 结束
+            if (i + 1 - bounds.back() >= target && i + 1 < count) bounds.push_back(i + 1);
+        }
+    }
+    bounds.push_back(count);
+    return bounds;
+}
+
+std::unique_ptr<Program> Parser::parseParallel(unsigned threads, size_t minChunk) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (lexer) {
+        return parse();
+    }
+    size_t chunkCount = std::min<size_t>(threads, (tokenCount() - current) / std::max<size_t>(minChunk, 1));
+    if (chunkCount < 2) {
+        return parse();
+    }
+    std::vector<size_t> bounds = splitTopLevelItems(chunkCount);
+    chunkCount = bounds.size() - 1;
+    if (chunkCount < 2) {
+        return parse();
+    }
+
+    auto program = std::make_unique<Program>();
+    arena = &program->arena;
+    if (skeleton) {
+        program->bodySource = std::make_unique<LazyBodies>(tokens, store, program->arena);
+        bodySource = program->bodySource.get();
+    }
 
     std::cout << "   📋 开始解析polyglot代码..." << std::endl;
-    std::cout << "   📋 Token数量: " << tokens.size() << std::endl;
+    std::cout << "   📋 Token数量: " << tokenCount() << std::endl;
+
+    // 各块由独立的解析器从块首解析到块尾，节点分配在各自的 arena 中；
+    // 解析器在顶层项之间不保留状态，因此从同一位置开始时与顺序解析的结果相同
+    struct Chunk {
+        AstArena arena;
+        std::vector<ASTNode*> statements;
+        std::ostringstream log;
+        size_t stop = 0;
+        std::exception_ptr error;
+    };
+    std::vector<Chunk> chunks(chunkCount);
+    auto parseChunk = [&](size_t index) {
+        Chunk& chunk = chunks[index];
+        Parser worker(tokens, store, chunk.log);
+        worker.current = bounds[index];
+        worker.arena = &chunk.arena;
+        worker.bodySource = bodySource;
+        try {
+            while (worker.current < bounds[index + 1] && !worker.isAtEnd()) {
+                if (auto stmt = worker.parseTopLevelStatement()) {
+                    chunk.statements.push_back(stmt);
+                }
+            }
+        } catch (...) {
+            chunk.error = std::current_exception();
+        }
+        chunk.stop = worker.current;
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(chunkCount - 1);
+    for (size_t i = 1; i < chunkCount; ++i) {
+        workers.emplace_back(parseChunk, i);
+    }
+    parseChunk(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
 
     try {
+        // 按顺序拼接；块内的报错就是顺序解析会遇到的第一个错误。
+        // 块没有恰好停在下一块的起点时，后面的块作废，从它停下的位置顺序解析
+        for (size_t index = 0; index < chunkCount; ++index) {
+            Chunk& chunk = chunks[index];
+            *log << chunk.log.str();
+            program->arena.adopt(std::move(chunk.arena));
+            program->statements.insert(program->statements.end(), chunk.statements.begin(), chunk.statements.end());
+            if (chunk.error) {
+                std::rethrow_exception(chunk.error);
+            }
+            current = chunk.stop;
+            if (chunk.stop != bounds[index + 1]) {
+                break;
+            }
+        }
         while (!isAtEnd()) {
             if (auto stmt = parseTopLevelStatement()) {
-                program->statements.push_back(std::move(stmt));
+                program->statements.push_back(stmt);
             }
         }
 
@@ -65,8 +317,197 @@ std::unique_ptr<Program> Parser::parse() {
     return program;
 }
 
+uint64_t Parser::hashTokens(size_t begin, size_t end) const {
+    // FNV 式的逐字（8 字节）混合；每个Token先计入种类、换行标志与文本长度，避免相邻Token拼接后相同
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint64_t value) {
+        hash ^= value;
+        hash *= 1099511628211ull;
+        hash ^= hash >> 29;
+    };
+    for (size_t i = begin; i < end; ++i) {
+        const bool newline = i > begin && newlineAt(i);
+        std::string_view text = textAt(i);
+        mix(static_cast<uint64_t>(text.size()) << 9 | static_cast<uint64_t>(kindAt(i)) << 1 | (newline ? 1 : 0));
+        size_t offset = 0;
+        for (; offset + 8 <= text.size(); offset += 8) {
+            uint64_t word;
+            std::memcpy(&word, text.data() + offset, 8);
+            mix(word);
+        }
+        if (offset < text.size()) {
+            uint64_t word = 0;
+            std::memcpy(&word, text.data() + offset, text.size() - offset);
+            mix(word);
+        }
+    }
+    mix(end - begin);
+    return hash ? hash : 1;  // 0 留给“未记录”
+}
+
+bool Parser::sameTokens(size_t begin, size_t end, const Parser& other, size_t otherBegin) const {
+    if (otherBegin + (end - begin) > other.tokenCount()) {
+        return false;
+    }
+    for (size_t i = begin, j = otherBegin; i < end; ++i, ++j) {
+        if (kindAt(i) != other.kindAt(j) || textAt(i) != other.textAt(j) ||
+            (i > begin && newlineAt(i) != other.newlineAt(j))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t Parser::matchItemEnd(size_t begin) const {
+    const size_t count = tokenCount();
+    size_t depth = 0;
+    for (size_t i = begin; i < count; ++i) {
+        TokenType kind = kindAt(i);
+        if (kind == TokenType::LEFT_BRACE) {
+            ++depth;
+        } else if (kind == TokenType::RIGHT_BRACE && depth > 0 && --depth == 0) {
+            return i + 1;
+        }
+    }
+    return SIZE_MAX;
+}
+
+void Parser::rebaseLazyBodies(ASTNode* item, size_t newBegin, BodySource* source) {
+    auto rebase = [&](FunctionDecl* function, size_t oldBegin) {
+        if (LazyBody* lazy = function->lazyBody) {
+            lazy->begin = lazy->begin - oldBegin + newBegin;
+            lazy->end = lazy->end - oldBegin + newBegin;
+            lazy->source = source;
+        }
+    };
+    if (auto function = nodeCast<FunctionDecl>(item)) {
+        rebase(function, function->span.begin);
+    } else if (auto impl = nodeCast<ImplBlock>(item)) {
+        for (FunctionDecl* method : impl->methods) {
+            rebase(method, impl->span.begin);
+        }
+    }
+}
+
+Parser::Reparse Parser::reparse(std::unique_ptr<Program> previous, const std::vector<Token>& previousTokens) {
+    return reparse(std::move(previous), Parser(&previousTokens, nullptr, *log));
+}
+
+Parser::Reparse Parser::reparse(std::unique_ptr<Program> previous, const TokenStore& previousTokens) {
+    return reparse(std::move(previous), Parser(nullptr, &previousTokens, *log));
+}
+
+Parser::Reparse Parser::reparse(std::unique_ptr<Program> previous, const Parser& previousTokens) {
+    Reparse result;
+
+    // 旧的顶层项名字（报告未被复用的项用）
+    auto itemName = [](ASTNode* item) -> std::string {
+        if (auto function = nodeCast<FunctionDecl>(item)) return std::string(function->name);
+        if (auto structDecl = nodeCast<StructDecl>(item)) return "@" + std::string(structDecl->name);
+        if (auto impl = nodeCast<ImplBlock>(item)) return "&" + std::string(impl->structName);
+        return std::string();
+    };
+    auto spanOf = [](ASTNode* item) -> TokenSpan* {
+        if (auto function = nodeCast<FunctionDecl>(item)) return &function->span;
+        if (auto structDecl = nodeCast<StructDecl>(item)) return &structDecl->span;
+        if (auto impl = nodeCast<ImplBlock>(item)) return &impl->span;
+        return nullptr;
+    };
+
+    // 流式模式下没有Token下标可比；增量重解析累积到上限后也做一次完整解析，丢弃旧 arena
+    if (lexer || previous->reparses >= kMaxReparses) {
+        result.program = parse();
+        for (ASTNode* item : previous->statements) {
+            if (spanOf(item)) result.removed.push_back(itemName(item));
+        }
+        for (ASTNode* item : result.program->statements) {
+            if (spanOf(item)) result.changed.push_back(item);
+        }
+        return result;
+    }
+
+    // 可复用的旧项按内容哈希分组；同一哈希的多个项按源码顺序依次取用
+    std::unordered_map<uint64_t, std::vector<ASTNode*>> candidates;
+    for (auto it = previous->statements.rbegin(); it != previous->statements.rend(); ++it) {
+        TokenSpan* span = spanOf(*it);
+        if (span && span->hash != 0) {
+            candidates[span->hash].push_back(*it);
+        }
+    }
+    std::unordered_set<ASTNode*> reusedItems;
+
+    auto program = std::make_unique<Program>();
+    program->arena.adopt(std::move(previous->arena));
+    arena = &program->arena;
+    program->bodySource = std::make_unique<LazyBodies>(tokens, store, program->arena);
+    bodySource = skeleton ? program->bodySource.get() : nullptr;
+
+    std::cout << "   📋 开始增量解析polyglot代码..." << std::endl;
+
+    try {
+        while (!isAtEnd()) {
+            while (peek().type == TokenType::NEWLINE && !isAtEnd()) {
+                advance();
+            }
+            if (isAtEnd()) break;
+
+            // 以 '}' 结尾的顶层项：内容与某个旧项相同时直接复用（解析只依赖这段Token，结果必然相同）
+            const size_t begin = current;
+            TokenType kind = peek().type;
+            if (kind == TokenType::IDENTIFIER || kind == TokenType::STRUCT_DEF || kind == TokenType::IMPL_DEF) {
+                size_t end = matchItemEnd(begin);
+                if (end != SIZE_MAX) {
+                    uint64_t hash = hashTokens(begin, end);
+                    auto found = candidates.find(hash);
+                    ASTNode* item = nullptr;
+                    if (found != candidates.end()) {
+                        // 哈希相同还须逐个Token相同（同一哈希的旧项按源码顺序依次比对）
+                        std::vector<ASTNode*>& items = found->second;
+                        for (size_t i = items.size(); i-- > 0;) {
+                            if (sameTokens(begin, end, previousTokens, spanOf(items[i])->begin)) {
+                                item = items[i];
+                                items.erase(items.begin() + static_cast<std::ptrdiff_t>(i));
+                                break;
+                            }
+                        }
+                    }
+                    if (item) {
+                        rebaseLazyBodies(item, begin, program->bodySource.get());
+                        *spanOf(item) = TokenSpan{begin, end, hash};
+                        program->statements.push_back(item);
+                        reusedItems.insert(item);
+                        current = end;
+                        continue;
+                    }
+                }
+            }
+
+            if (auto stmt = parseTopLevelStatement()) {
+                program->statements.push_back(stmt);
+                if (spanOf(stmt)) result.changed.push_back(stmt);
+            }
+        }
+
+        std::cout << "   ✅ 增量解析完成：复用 " << reusedItems.size() << " 个顶层项，重新解析 " << result.changed.size()
+                  << " 个" << std::endl;
+    } catch (const ParserError& e) {
+        std::cout << "   ❌ 解析错误: " << e.what() << std::endl;
+        throw;
+    }
+
+    for (ASTNode* item : previous->statements) {
+        if (spanOf(item) && !reusedItems.count(item)) {
+            result.removed.push_back(itemName(item));
+        }
+    }
+    result.reused = reusedItems.size();
+    program->reparses = previous->reparses + 1;
+    result.program = std::move(program);
+    return result;
+}
+
 // 解析顶级语句（模块导入、函数定义、结构体定义等）
-std::unique_ptr<ASTNode> Parser::parseTopLevelStatement() {
+ASTNode* Parser::parseTopLevelStatement() {
     // 跳过换行符和空白符
     while (peek().type == TokenType::NEWLINE && !isAtEnd()) {
         advance();
@@ -76,17 +517,18 @@ std::unique_ptr<ASTNode> Parser::parseTopLevelStatement() {
         return nullptr;
     }
 
-    Token& current = peek();
+    const size_t begin = this->current;
+    const Token& current = peek();
 
     switch (current.type) {
         case TokenType::IMPORT:        // >>导入
             return parseImport();
         case TokenType::STRUCT_DEF:    // @结构体定义
-            return parseStructDef();
+            return tagged(parseStructDef(), begin);
         case TokenType::IMPL_DEF:      // &实现块
-            return parseImplBlock();
+            return tagged(parseImplBlock(), begin);
         case TokenType::IDENTIFIER:    // 函数定义
-            return parseFunctionDef();
+            return tagged(parseFunctionDef(), begin);
         default:
             // 跳过未知token
             advance();
@@ -95,43 +537,59 @@ std::unique_ptr<ASTNode> Parser::parseTopLevelStatement() {
 }
 
 // 解析导入语句: >> "module_name"
-std::unique_ptr<ASTNode> Parser::parseImport() {
+ASTNode* Parser::parseImport() {
     advance(); // 跳过 >>
 
     if (peek().type != TokenType::STRING_LITERAL) {
-        throw ParserError("期望字符串字面值", peek().line, peek().column);
+        throw errorAt(peek(), "期望字符串字面值");
     }
 
-    std::string moduleName = advance().value;
+    std::string moduleName = advance().value();
 
     // 移除引号
     if (moduleName.length() >= 2 && moduleName[0] == '"' && moduleName.back() == '"') {
         moduleName = moduleName.substr(1, moduleName.length() - 2);
     }
 
-    std::cout << "   📦 解析导入模块: " << moduleName << std::endl;
+    *log << "   📦 解析导入模块: " << moduleName << std::endl;
+
+    return make<ImportDecl>(arena->copy(moduleName));
+}
 
-    return std::make_unique<ImportDecl>(moduleName);
+LazyBody* Parser::skipBody() {
+    const size_t begin = current;
+    const size_t count = tokenCount();
+    size_t depth = 0;
+    for (size_t i = begin; i < count; ++i) {
+        TokenType kind = kindAt(i);
+        if (kind == TokenType::LEFT_BRACE) {
+            ++depth;
+        } else if (kind == TokenType::RIGHT_BRACE && --depth == 0) {
+            current = i + 1;
+            return make<LazyBody>(LazyBody{bodySource, begin, i + 1});
+        }
+    }
+    return nullptr;
 }
 
 // 解析结构体定义: @ StructName { field1: type, field2: type }
-std::unique_ptr<StructDecl> Parser::parseStructDef() {
+StructDecl* Parser::parseStructDef() {
     advance(); // 跳过 @
 
     if (peek().type != TokenType::IDENTIFIER) {
-        throw ParserError("期望结构体名称", peek().line, peek().column);
+        throw errorAt(peek(), "期望结构体名称");
     }
 
-    auto structDecl = std::make_unique<StructDecl>();
-    structDecl->name = advance().value;
+    auto structDecl = make<StructDecl>();
+    structDecl->symbol = identifierName(structDecl->name);
 
     consume(TokenType::LEFT_BRACE, "期望 '{'");
 
     // 解析字段
+    size_t base = pending.size();
     while (peek().type != TokenType::RIGHT_BRACE && !isAtEnd()) {
-        auto field = parseVariableDecl();
-        if (field) {
-            structDecl->fields.push_back(std::move(field));
+        if (auto field = parseVariableDecl()) {
+            pending.push_back(field);
         }
 
         if (peek().type == TokenType::COMMA) {
@@ -139,20 +597,21 @@ std::unique_ptr<StructDecl> Parser::parseStructDef() {
         }
     }
 
+    structDecl->fields = takePending<VariableDecl>(base);
     consume(TokenType::RIGHT_BRACE, "期望 '}'");
 
     return structDecl;
 }
 
 // 解析变量声明: name: type 或 name: ? = value
-std::unique_ptr<VariableDecl> Parser::parseVariableDecl() {
-    auto varDecl = std::make_unique<VariableDecl>();
+VariableDecl* Parser::parseVariableDecl() {
+    auto varDecl = make<VariableDecl>();
 
     if (peek().type != TokenType::IDENTIFIER) {
-        throw ParserError("期望变量名", peek().line, peek().column);
+        throw errorAt(peek(), "期望变量名");
     }
 
-    varDecl->name = advance().value;
+    varDecl->symbol = identifierName(varDecl->name);
 
     consume(TokenType::COLON, "期望 ':'");
 
@@ -164,9 +623,9 @@ std::unique_ptr<VariableDecl> Parser::parseVariableDecl() {
         // 不设置 varDecl->type，让语义分析器推导类型
     } else {
         // 允许内置类型或标识符类型
-        std::string typeName;
+        std::string_view typeName;
         if (tt == TokenType::IDENTIFIER) {
-            typeName = advance().value;
+            typeName = arena->copy(advance().text);
         } else {
             switch (tt) {
                 case TokenType::TYPE_I8: typeName = "i8"; break;
@@ -179,11 +638,11 @@ std::unique_ptr<VariableDecl> Parser::parseVariableDecl() {
                 case TokenType::TYPE_STRING: typeName = "string"; break;
                 case TokenType::TYPE_CHAR: typeName = "char"; break;
                 default:
-                    throw ParserError("期望类型名或 '?' 进行类型推导", peek().line, peek().column);
+                    throw errorAt(peek(), "期望类型名或 '?' 进行类型推导");
             }
             advance();
         }
-        varDecl->type = std::make_unique<TypeNode>(typeName);
+        varDecl->type = make<TypeNode>(typeName);
     }
 
     // 支持 = 赋值
@@ -196,29 +655,30 @@ std::unique_ptr<VariableDecl> Parser::parseVariableDecl() {
 }
 
 // 解析函数定义: function_name(param1: type, param2: type) { body }
-std::unique_ptr<FunctionDecl> Parser::parseFunctionDef() {
-    auto funcDecl = std::make_unique<FunctionDecl>();
+FunctionDecl* Parser::parseFunctionDef() {
+    auto funcDecl = make<FunctionDecl>();
 
     if (peek().type != TokenType::IDENTIFIER) {
-        throw ParserError("期望函数名", peek().line, peek().column);
+        throw errorAt(peek(), "期望函数名");
     }
 
-    funcDecl->name = advance().value;
-    std::cout << "   🔧 解析函数定义: " << funcDecl->name << std::endl;
+    funcDecl->symbol = identifierName(funcDecl->name);
+    *log << "   🔧 解析函数定义: " << funcDecl->name << std::endl;
 
     consume(TokenType::LEFT_PAREN, "期望 '('");
 
     // 解析参数列表
+    size_t base = pending.size();
     while (peek().type != TokenType::RIGHT_PAREN && !isAtEnd()) {
-        auto param = parseVariableDecl();
-        if (param) {
-            funcDecl->parameters.push_back(std::move(param));
+        if (auto param = parseVariableDecl()) {
+            pending.push_back(param);
         }
 
         if (peek().type == TokenType::COMMA) {
             advance(); // 跳过逗号
         }
     }
+    funcDecl->parameters = takePending<VariableDecl>(base);
 
     consume(TokenType::RIGHT_PAREN, "期望 ')'");
 
@@ -226,42 +686,48 @@ std::unique_ptr<FunctionDecl> Parser::parseFunctionDef() {
     if (peek().type == TokenType::ARROW) {
         advance(); // 跳过 ->
         if (peek().type == TokenType::IDENTIFIER) {
-            funcDecl->returnType = std::make_unique<TypeNode>(advance().value);
+            funcDecl->returnType = make<TypeNode>(arena->copy(advance().text));
         }
     }
 
-    // 解析函数体
+    // 解析函数体（骨架模式下只记下范围）
     if (peek().type == TokenType::LEFT_BRACE) {
-        funcDecl->body = parseBlock();
+        if (bodySource) {
+            funcDecl->lazyBody = skipBody();
+        }
+        if (!funcDecl->lazyBody) {
+            funcDecl->body = parseBlock();
+        }
     }
 
     return funcDecl;
 }
 
 // 解析实现块: & StructName { methods... }
-std::unique_ptr<ImplBlock> Parser::parseImplBlock() {
+ImplBlock* Parser::parseImplBlock() {
     advance(); // 跳过 &
 
     if (peek().type != TokenType::IDENTIFIER) {
-        throw ParserError("期望结构体名称", peek().line, peek().column);
+        throw errorAt(peek(), "期望结构体名称");
     }
 
-    auto implBlock = std::make_unique<ImplBlock>();
-    implBlock->structName = advance().value;
+    auto implBlock = make<ImplBlock>();
+    implBlock->structName = arena->copy(advance().text);
 
     consume(TokenType::LEFT_BRACE, "期望 '{'");
 
     // 解析方法
+    size_t base = pending.size();
     while (peek().type != TokenType::RIGHT_BRACE && !isAtEnd()) {
         if (peek().type == TokenType::IDENTIFIER) {
-            auto method = parseFunctionDef();
-            if (method) {
-                implBlock->methods.push_back(std::move(method));
+            if (auto method = parseFunctionDef()) {
+                pending.push_back(method);
             }
         } else {
             advance(); // 跳过未知token
         }
     }
+    implBlock->methods = takePending<FunctionDecl>(base);
 
     consume(TokenType::RIGHT_BRACE, "期望 '}'");
 
@@ -269,16 +735,18 @@ std::unique_ptr<ImplBlock> Parser::parseImplBlock() {
 }
 
 // 解析代码块: { statements... }
-std::unique_ptr<Block> Parser::parseBlock() {
-    auto block = std::make_unique<Block>();
+Block* Parser::parseBlock() {
+    auto block = make<Block>();
 
     consume(TokenType::LEFT_BRACE, "期望 '{'");
 
+    size_t base = pending.size();
     while (peek().type != TokenType::RIGHT_BRACE && !isAtEnd()) {
         if (auto stmt = parseStatement()) {
-            block->statements.push_back(std::move(stmt));
+            pending.push_back(stmt);
         }
     }
+    block->statements = takePending<Statement>(base);
 
     consume(TokenType::RIGHT_BRACE, "期望 '}'");
 
@@ -286,7 +754,7 @@ std::unique_ptr<Block> Parser::parseBlock() {
 }
 
 // 解析语句
-std::unique_ptr<Statement> Parser::parseStatement() {
+Statement* Parser::parseStatement() {
     // 跳过换行符
     while (peek().type == TokenType::NEWLINE && !isAtEnd()) {
         advance();
@@ -296,9 +764,9 @@ std::unique_ptr<Statement> Parser::parseStatement() {
         return nullptr;
     }
 
-    Token& current = peek();
-    std::cout << "   🔄 parseStatement: Token类型=" << static_cast<int>(current.type)
-              << ", 值='" << current.value << "'" << std::endl;
+    const Token& current = peek();
+    *log << "   🔄 parseStatement: Token类型=" << static_cast<int>(current.type)
+              << ", 值='" << current.value() << "'" << std::endl;
 
     switch (current.type) {
         case TokenType::QUESTION: {    // ? 变量声明语句
@@ -306,20 +774,20 @@ std::unique_ptr<Statement> Parser::parseStatement() {
         }
         case TokenType::IDENTIFIER: {
             // 检查是否为变量声明 (identifier: type 或 identifier: ?)
-            if ((this->current + 1) < tokens.size()) {
-                auto nextType = tokens[this->current + 1].type;
-                if (nextType == TokenType::COLON) {
-                    return parseVariableDeclStmt();
-                }
-                // 支持海象声明 identifier := expr（中文全角：= 已在预处理阶段规范为 :=）
-                if (nextType == TokenType::CONDITIONAL_ASSIGN) {
-                    // 构造一个变量声明（类型推导）
-                    auto varDecl = std::make_unique<VariableDecl>();
-                    varDecl->name = advance().value; // 标识符
-                    advance(); // 跳过 :=
-                    varDecl->initializer = parseExpression();
-                    return varDecl;
-                }
+            // 下一行开头的 : 或 := 不属于本语句
+            const Token& next = peekAt(1);
+            auto nextType = next.newlineBefore ? TokenType::NEWLINE : next.type;
+            if (nextType == TokenType::COLON) {
+                return parseVariableDeclStmt();
+            }
+            // 支持海象声明 identifier := expr（中文全角：= 已在预处理阶段规范为 :=）
+            if (nextType == TokenType::CONDITIONAL_ASSIGN) {
+                // 构造一个变量声明（类型推导）
+                auto varDecl = make<VariableDecl>();
+                varDecl->symbol = identifierName(varDecl->name); // 标识符
+                advance(); // 跳过 :=
+                varDecl->initializer = parseExpression();
+                return varDecl;
             }
             // 其他标识符语句（表达式语句等）
             return parseExpressionStmt();
@@ -333,25 +801,24 @@ std::unique_ptr<Statement> Parser::parseStatement() {
         default:
             // 对于不能处理的token，跳过以避免死循环
             advance();
-            std::cout << "   ⚠️  跳过未识别的token: " << current.value << std::endl;
+            *log << "   ⚠️  跳过未识别的token: " << current.value() << std::endl;
             return nullptr;
     }
 }
 
 // 解析变量声明语句
-std::unique_ptr<Statement> Parser::parseVariableDeclStmt() {
-    auto varDecl = parseVariableDecl();
-    return std::move(varDecl);  // VariableDecl现在继承自Statement，可以直接move
+Statement* Parser::parseVariableDeclStmt() {
+    return parseVariableDecl();  // VariableDecl 继承自 Statement
 }
 
 
 // 解析返回语句: <- expression
-std::unique_ptr<ReturnStmt> Parser::parseReturnStmt() {
-    auto returnStmt = std::make_unique<ReturnStmt>();
+ReturnStmt* Parser::parseReturnStmt() {
+    auto returnStmt = make<ReturnStmt>();
 
     advance(); // 跳过 <-
 
-    if (peek().type != TokenType::RIGHT_BRACE && !isAtEnd()) {
+    if (peek().type != TokenType::RIGHT_BRACE && !isAtEnd() && !peek().newlineBefore) {
         returnStmt->value = parseExpression();
     }
 
@@ -359,16 +826,16 @@ std::unique_ptr<ReturnStmt> Parser::parseReturnStmt() {
 }
 
 // 解析 ? variable = value 形式的变量声明
-std::unique_ptr<Statement> Parser::parseQuestionVariableDeclStmt() {
-    auto varDecl = std::make_unique<VariableDecl>();
+Statement* Parser::parseQuestionVariableDeclStmt() {
+    auto varDecl = make<VariableDecl>();
 
     advance(); // 跳过 ?
 
     if (peek().type != TokenType::IDENTIFIER) {
-        throw ParserError("期望变量名", peek().line, peek().column);
+        throw errorAt(peek(), "期望变量名");
     }
 
-    varDecl->name = advance().value;
+    varDecl->symbol = identifierName(varDecl->name);
 
     // ? variable = value 形式，没有显式类型
     // 不设置 varDecl->type，让语义分析器推导类型
@@ -380,140 +847,159 @@ std::unique_ptr<Statement> Parser::parseQuestionVariableDeclStmt() {
 }
 
 // 解析表达式语句
-std::unique_ptr<ExpressionStmt> Parser::parseExpressionStmt() {
-    auto exprStmt = std::make_unique<ExpressionStmt>();
+ExpressionStmt* Parser::parseExpressionStmt() {
+    auto exprStmt = make<ExpressionStmt>();
     exprStmt->expression = parseExpression();
     return exprStmt;
 }
 
-// 解析表达式
-std::unique_ptr<Expression> Parser::parseExpression() {
-    return parseAssignmentExpression();
-}
-
-// 解析赋值表达式
-std::unique_ptr<Expression> Parser::parseAssignmentExpression() {
-    auto expr = parseLogicalOrExpression();
-
-    if (peek().type == TokenType::ASSIGN) {
-        advance(); // 跳过 =
-        auto right = parseAssignmentExpression();
-
-        auto binaryOp = std::make_unique<BinaryOp>();
-        binaryOp->left = std::move(expr);
-        binaryOp->operator_ = "=";
-        binaryOp->right = std::move(right);
-
-        return binaryOp;
+// 运算符表：按 TokenType 下标查中缀/前缀绑定力（0 表示不是该位置的运算符），优先级只在这里定义。
+// 同一运算符的全角写法（如 《=）统一记为半角写法。* 与 % 在 ASCII 模式下分别扫描为 CONSTANT/INTERFACE，
+// 出现在操作数之后时按乘法/取模处理。
+namespace {
+
+struct OperatorInfo {
+    uint8_t infix = 0;              // 中缀绑定力，越大结合越紧
+    uint8_t prefix = 0;             // 前缀绑定力
+    bool rightAssociative = false;
+    const char* spelling = nullptr; // 写入 AST 的规范写法
+};
+
+constexpr uint8_t kAssignPower = 1;
+constexpr uint8_t kPrefixPower = 8;
+
+constexpr std::array<OperatorInfo, TokenType::UNKNOWN + 1> kOperators = [] {
+    std::array<OperatorInfo, TokenType::UNKNOWN + 1> table{};
+    auto infix = [&](TokenType type, uint8_t power, const char* spelling, bool right = false) {
+        table[type].infix = power;
+        table[type].rightAssociative = right;
+        table[type].spelling = spelling;
+    };
+    infix(TokenType::ASSIGN, kAssignPower, "=", true);
+    infix(TokenType::PLUS_ASSIGN, kAssignPower, "+=", true);
+    infix(TokenType::MINUS_ASSIGN, kAssignPower, "-=", true);
+    infix(TokenType::LOGICAL_OR, 2, "||");
+    infix(TokenType::LOGICAL_AND, 3, "&&");
+    infix(TokenType::EQUAL, 4, "==");
+    infix(TokenType::NOT_EQUAL, 4, "!=");
+    infix(TokenType::LESS_THAN, 5, "<");
+    infix(TokenType::GREATER_THAN, 5, ">");
+    infix(TokenType::LESS_EQUAL, 5, "<=");
+    infix(TokenType::GREATER_EQUAL, 5, ">=");
+    infix(TokenType::PLUS, 6, "+");
+    infix(TokenType::MINUS, 6, "-");
+    infix(TokenType::STAR, 7, "*");
+    infix(TokenType::CONSTANT, 7, "*");
+    infix(TokenType::SLASH, 7, "/");
+    infix(TokenType::MODULO, 7, "%");
+    infix(TokenType::INTERFACE, 7, "%");
+    table[TokenType::MINUS].prefix = kPrefixPower;
+    table[TokenType::LOGICAL_NOT] = {0, kPrefixPower, false, "!"};
+    return table;
+}();
+
+} // namespace
+
+// 解析表达式：优先级爬升。左结合的同级运算符在循环内连成左深树，只有更高优先级的右操作数才递归，
+// 每个操作数只经过本函数与 parsePrimaryExpression 两层调用。运算符须与左操作数在同一行。
+Expression* Parser::parseExpression(int minPower) {
+    Expression* expr;
+    const OperatorInfo& prefix = kOperators[peek().type];
+    if (prefix.prefix) {
+        advance();
+        auto unaryOp = make<UnaryOp>();
+        unaryOp->operator_ = prefix.spelling;
+        unaryOp->operand = parseExpression(prefix.prefix);
+        expr = foldNegativeLiteral(unaryOp);
+    } else {
+        expr = parsePrimaryExpression();
     }
 
-    return expr;
-}
-
-// 解析逻辑或表达式
-std::unique_ptr<Expression> Parser::parseLogicalOrExpression() {
-    return parseLogicalAndExpression(); // 简化实现
-}
-
-// 解析逻辑与表达式
-std::unique_ptr<Expression> Parser::parseLogicalAndExpression() {
-    return parseEqualityExpression(); // 简化实现
-}
-
-// 解析相等性表达式
-std::unique_ptr<Expression> Parser::parseEqualityExpression() {
-    return parseRelationalExpression(); // 简化实现
-}
-
-// 解析关系表达式
-std::unique_ptr<Expression> Parser::parseRelationalExpression() {
-    return parseAdditiveExpression(); // 简化实现
-}
-
-// 解析加减表达式
-std::unique_ptr<Expression> Parser::parseAdditiveExpression() {
-    auto expr = parseMultiplicativeExpression();
-
-    while (peek().type == TokenType::PLUS || peek().type == TokenType::MINUS) {
-        std::string op = advance().value;
-        auto right = parseMultiplicativeExpression();
-
-        auto binaryOp = std::make_unique<BinaryOp>();
-        binaryOp->left = std::move(expr);
-        binaryOp->operator_ = op;
-        binaryOp->right = std::move(right);
+    for (;;) {
+        const Token& token = peek();
+        const OperatorInfo& op = kOperators[token.type];
+        if (op.infix < minPower || op.infix == 0 || token.newlineBefore) break;
+        advance();
 
-        expr = std::move(binaryOp);
+        auto binaryOp = make<BinaryOp>();
+        binaryOp->left = expr;
+        binaryOp->operator_ = op.spelling;
+        binaryOp->right = parseExpression(op.rightAssociative ? op.infix : op.infix + 1);
+        expr = binaryOp;
     }
 
     return expr;
 }
 
-// 解析乘除表达式
-std::unique_ptr<Expression> Parser::parseMultiplicativeExpression() {
-    auto expr = parseUnaryExpression();
-
-    while (peek().type == TokenType::STAR || peek().type == TokenType::SLASH) {
-        std::string op = advance().value;
-        auto right = parseUnaryExpression();
-
-        auto binaryOp = std::make_unique<BinaryOp>();
-        binaryOp->left = std::move(expr);
-        binaryOp->operator_ = op;
-        binaryOp->right = std::move(right);
-
-        expr = std::move(binaryOp);
+Expression* Parser::foldNegativeLiteral(UnaryOp* unaryOp) {
+    auto literal = nodeCast<Literal>(unaryOp->operand);
+    // 只合并一次：--5 仍是对 -5 取负，否则 --9223372036854775808 会被当作 i64 的最小值
+    if (unaryOp->operator_ != "-" || !literal || literal->value.empty() || literal->value[0] == '-' ||
+        (literal->type != "int" && literal->type != "float")) {
+        return unaryOp;
     }
-
-    return expr;
-}
-
-// 解析一元表达式
-std::unique_ptr<Expression> Parser::parseUnaryExpression() {
-    return parsePrimaryExpression(); // 简化实现
+    literal->value = arena->copy("-" + std::string(literal->value));
+    // 字面值 2^63 以 INT64_MIN 存放，按无符号取负后仍是 INT64_MIN，即 -2^63
+    literal->intValue = static_cast<int64_t>(0 - static_cast<uint64_t>(literal->intValue));
+    literal->floatValue = -literal->floatValue;
+    literal->line = unaryOp->line;
+    literal->column = unaryOp->column;
+    return literal;
 }
 
 // 解析基础表达式
-std::unique_ptr<Expression> Parser::parsePrimaryExpression() {
-    Token& current = peek();
+Expression* Parser::parsePrimaryExpression() {
+    const Token& current = peek();
 
     switch (current.type) {
         case TokenType::IDENTIFIER: {
-            std::string name = advance().value;
+            std::string_view name;
+            SymbolId symbol = identifierName(name);
 
-            // 检查是否是函数调用 (后面跟着左括号)
-            if (peek().type == TokenType::LEFT_PAREN) {
+            // 检查是否是函数调用 (同一行紧跟着左括号)
+            if (checkSameLine(TokenType::LEFT_PAREN)) {
                 advance(); // 跳过 (
 
-                auto funcCall = std::make_unique<FunctionCall>(name);
+                auto funcCall = make<FunctionCall>(name, symbol);
 
                 // 解析参数列表
+                size_t base = pending.size();
                 if (peek().type != TokenType::RIGHT_PAREN) {
                     do {
-                        funcCall->arguments.push_back(parseExpression());
+                        pending.push_back(parseExpression());
                     } while (peek().type == TokenType::COMMA && advance().type == TokenType::COMMA);
                 }
+                funcCall->arguments = takePending<Expression>(base);
 
                 consume(TokenType::RIGHT_PAREN, "期望 ')'");
-                return std::move(funcCall);
+                return funcCall;
             } else {
                 // 普通标识符
-                return std::make_unique<Identifier>(name);
+                return make<Identifier>(name, symbol);
             }
         }
 
-        case TokenType::INTEGER_LITERAL:
-            return std::make_unique<Literal>(advance().value, "int");
+        case TokenType::INTEGER_LITERAL: {
+            const Token& token = advance();
+            auto literal = make<Literal>(arena->copy(token.text), "int");
+            literal->intValue = token.number.integer;
+            return literal;
+        }
 
-        case TokenType::FLOAT_LITERAL:
-            return std::make_unique<Literal>(advance().value, "float");
+        case TokenType::FLOAT_LITERAL: {
+            const Token& token = advance();
+            auto literal = make<Literal>(arena->copy(token.text), "float");
+            literal->floatValue = token.number.real;
+            return literal;
+        }
 
         case TokenType::STRING_LITERAL:
-            return std::make_unique<Literal>(advance().value, "string");
+            return make<Literal>(arena->copy(advance().value()), "string");
 
+        // 本地化关键字（真/假）统一成规范写法
         case TokenType::TRUE:
         case TokenType::FALSE:
-            return std::make_unique<Literal>(advance().value, "bool");
+            return make<Literal>(advance().type == TokenType::TRUE ? "true" : "false", "bool");
 
         case TokenType::LEFT_PAREN: {
             advance(); // 跳过 (
@@ -523,6 +1009,6 @@ std::unique_ptr<Expression> Parser::parsePrimaryExpression() {
         }
 
         default:
-            throw ParserError("期望表达式", current.line, current.column);
+            throw errorAt(current, "期望表达式");
     }
 }
@@ -2,47 +2,154 @@
 
 #include "lexer.h"
 #include "ast.h"
+#include "error.h"
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <iostream>
 
 class Parser {
 private:
-    std::vector<Token> tokens;
-    size_t current;
+    // 批量模式：直接消费词法分析器产出的Token缓冲区（不拷贝），调用方保证其生命周期
+    const std::vector<Token>* tokens = nullptr;
+    size_t current = 0;
+    // 流式模式：边解析边从词法分析器拉取Token
+    Lexer* lexer = nullptr;
+    Token previous;  // 流式模式下最近消费的Token
+    // 紧凑模式：按下标从 TokenStore 物化Token（不带行列号，报错时再按偏移定位）
+    const TokenStore* store = nullptr;
+    static constexpr size_t kWindowSize = 8;
+    std::vector<Token> window;
+    std::vector<size_t> windowIndex;
+    const Token& storeToken(size_t index);
 
-    Token& peek();
-    Token& advance();
+    const Token& peek();
+    const Token& peekAt(size_t offset);
+    const Token& advance();
     bool isAtEnd();
     bool match(TokenType type);
+    // 下一个Token是 type 且与上一个Token在同一行（折叠换行模式下换行结束语句）
+    bool checkSameLine(TokenType type);
     void consume(TokenType type, const std::string& message);
+    // 消费一个标识符Token，返回其名字的驻留编号并把名字（驻留表中的视图）写入 name
+    SymbolId identifierName(std::string_view& name);
+    // 本解析器驻留过的名字（键为驻留表中的视图）：重复出现的标识符不再进入驻留表的锁，并行解析时各工作者互不争用
+    std::unordered_map<std::string_view, SymbolId> symbolCache;
+    // 在 token 处构造语法错误（紧凑模式下此时才计算行列号）
+    ParserError errorAt(const Token& token, const std::string& message) const;
+
+    // 解析过程的日志；并行解析的工作者各自写入缓冲区，完成后按源码顺序输出
+    std::ostream* log = &std::cout;
+
+    // 并行解析的工作者：与 owner 共用只读的Token序列
+    Parser(const std::vector<Token>* tokens, const TokenStore* store, std::ostream& log);
+    size_t tokenCount() const;
+    TokenType kindAt(size_t index) const;
+    std::string_view textAt(size_t index) const;
+    bool newlineAt(size_t index) const;
+    // 按花括号深度找出顶层项的边界（深度回到 0 的 '}' 之后），把 Token 序列切成至多 chunkCount 段
+    std::vector<size_t> splitTopLevelItems(size_t chunkCount) const;
+
+    // 节点分配在当前 Program 的 arena 中
+    AstArena* arena = nullptr;
+    template <typename T, typename... Args>
+    T* make(Args&&... args) { return arena->make<T>(std::forward<Args>(args)...); }
+    // 子节点列表先压入 pending（各层解析按栈的方式共用），完成后从 base 起整段复制进 arena
+    std::vector<ASTNode*> pending;
+    template <typename T>
+    NodeList<T*> takePending(size_t base) {
+        size_t count = pending.size() - base;
+        T** items = arena->allocateArray<T*>(count);
+        for (size_t i = 0; i < count; ++i) {
+            items[i] = static_cast<T*>(pending[base + i]);
+        }
+        pending.resize(base);
+        return NodeList<T*>(items, static_cast<uint32_t>(count));
+    }
+
+    // 骨架模式：函数体只按花括号配对跳过并记下 Token 区间，首次使用时由 LazyBodies 补解析
+    class LazyBodies;
+    bool skeleton = false;
+    BodySource* bodySource = nullptr;
+    // 跳过从当前 '{' 起的函数体；花括号不配对时返回 nullptr（改为常规解析，报出同样的错误）
+    LazyBody* skipBody();
+
+    // 顶层项的内容哈希：依次计入各Token的种类、文本与换行标志（首个Token的换行标志除外）
+    uint64_t hashTokens(size_t begin, size_t end) const;
+    // [begin, end) 与 other 中从 otherBegin 起的等长区间逐个Token相同（比较的内容与哈希相同）；哈希命中后用它确认
+    bool sameTokens(size_t begin, size_t end, const Parser& other, size_t otherBegin) const;
+    // 从 begin 处的顶层项起找到第一个 '{' 及与之配对的 '}'，返回其后的位置；找不到时返回 SIZE_MAX
+    size_t matchItemEnd(size_t begin) const;
+    // 记录顶层项的 Token 区间与哈希（流式模式下没有下标，不记录）
+    template <typename T>
+    T* tagged(T* decl, size_t begin) {
+        if (!lexer) {
+            decl->span = TokenSpan{begin, current, hashTokens(begin, current)};
+        }
+        return decl;
+    }
+    // 复用的顶层项移到 newBegin 处：尚未解析的函数体随之平移，并改由 bodySource 解析
+    void rebaseLazyBodies(ASTNode* item, size_t newBegin, BodySource* source);
 
     // 解析函数
-    std::unique_ptr<ASTNode> parseTopLevelStatement();
-    std::unique_ptr<ASTNode> parseImport();
-    std::unique_ptr<StructDecl> parseStructDef();
-    std::unique_ptr<ImplBlock> parseImplBlock();
-    std::unique_ptr<FunctionDecl> parseFunctionDef();
-    std::unique_ptr<VariableDecl> parseVariableDecl();
-
-    std::unique_ptr<Block> parseBlock();
+    ASTNode* parseTopLevelStatement();
+    ASTNode* parseImport();
+    StructDecl* parseStructDef();
+    ImplBlock* parseImplBlock();
+    FunctionDecl* parseFunctionDef();
+    VariableDecl* parseVariableDecl();
+
+    Block* parseBlock();
     // 解析各种语句类型
-    std::unique_ptr<Statement> parseStatement();
-    std::unique_ptr<Statement> parseVariableDeclStmt();
-    std::unique_ptr<Statement> parseQuestionVariableDeclStmt();
-    std::unique_ptr<ReturnStmt> parseReturnStmt();
-    std::unique_ptr<ExpressionStmt> parseExpressionStmt();
-
-    std::unique_ptr<Expression> parseExpression();
-    std::unique_ptr<Expression> parseAssignmentExpression();
-    std::unique_ptr<Expression> parseLogicalOrExpression();
-    std::unique_ptr<Expression> parseLogicalAndExpression();
-    std::unique_ptr<Expression> parseEqualityExpression();
-    std::unique_ptr<Expression> parseRelationalExpression();
-    std::unique_ptr<Expression> parseAdditiveExpression();
-    std::unique_ptr<Expression> parseMultiplicativeExpression();
-    std::unique_ptr<Expression> parseUnaryExpression();
-    std::unique_ptr<Expression> parsePrimaryExpression();
+    Statement* parseStatement();
+    Statement* parseVariableDeclStmt();
+    Statement* parseQuestionVariableDeclStmt();
+    ReturnStmt* parseReturnStmt();
+    ExpressionStmt* parseExpressionStmt();
+
+    // 解析 minPower 及以上绑定力的表达式（运算符与绑定力见 parser.cpp 的运算符表）
+    Expression* parseExpression(int minPower = 1);
+    Expression* parsePrimaryExpression();
+    // 负号直接作用于数值字面值时合并成一个带符号的字面值（-128、-2^63 的范围检查因此看到的是最终值）
+    Expression* foldNegativeLiteral(UnaryOp* unaryOp);
 
 public:
-    Parser(const std::vector<Token>& tokens);
+    explicit Parser(const std::vector<Token>& tokens);
+    explicit Parser(std::vector<Token>&&) = delete;
+    // 流式模式：词法分析与语法分析交替进行，不物化整个Token序列
+    explicit Parser(Lexer& lexer);
+    // 紧凑模式：直接消费 Lexer::scan() 的结果，调用方保证其生命周期
+    explicit Parser(const TokenStore& store);
+    explicit Parser(TokenStore&&) = delete;
     std::unique_ptr<Program> parse();
+
+    // 增量重解析的结果
+    struct Reparse {
+        std::unique_ptr<Program> program;
+        std::vector<ASTNode*> changed;     // 重新解析出的顶层函数、@结构体与 &实现块（新增或改动过的）
+        std::vector<std::string> removed;  // 旧 Program 中没有被复用的上述顶层项（删除或改动前的版本）
+        size_t reused = 0;
+    };
+    // 增量重解析：Token 内容与 previous 中某个顶层函数、@结构体或 &实现块相同的项直接移入新 Program，
+    // 其余部分重新解析，结果与 parse() 相同。previousTokens 是解析出 previous 的Token序列，哈希相同的项
+    // 再逐个Token比对后才复用。previous 的 arena 整体并入新 Program，此后 previous 不再可用；
+    // 被替换的旧节点留在 arena 中，连续 kMaxReparses 次增量重解析后的下一次改做完整解析以释放它们。
+    // 流式模式下退化为完整解析
+    static constexpr uint32_t kMaxReparses = 16;
+    Reparse reparse(std::unique_ptr<Program> previous, const std::vector<Token>& previousTokens);
+    Reparse reparse(std::unique_ptr<Program> previous, const TokenStore& previousTokens);
+
+    // 骨架模式（仅批量与紧凑模式）：解析出的函数只有签名，函数体在 FunctionDecl::getBody() 首次调用时解析。
+    // Token 序列须在 Program 使用期间保持有效
+    void setSkeleton(bool enabled) { skeleton = enabled; }
+
+    // 多线程解析：按顶层项切块，各块由独立的解析器并行解析，结果（含报错与日志）与 parse() 完全一致。
+    // 块的实际结束位置与切分点不符时（花括号不配对等），从该处起顺序解析剩余部分。
+    // 仅用于批量与紧凑模式；threads 为 0 时取硬件线程数，每块不足 minChunk 个Token时减少块数，Token 较少时直接退回 parse()
+    static constexpr size_t kMinParallelChunk = 64 * 1024;
+    std::unique_ptr<Program> parseParallel(unsigned threads = 0, size_t minChunk = kMinParallelChunk);
+
+private:
+    // 增量重解析的实现：previousTokens 只用来读取旧Token序列
+    Reparse reparse(std::unique_ptr<Program> previous, const Parser& previousTokens);
 };
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "semantic.h"
 #include <iostream>
 #include <typeinfo>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
 
 // ========== SymbolTable 实现 ==========
 
@@ -19,7 +22,7 @@ void SymbolTable::exitScope() {
     }
 }
 
-bool SymbolTable::declareSymbol(const std::string& name, std::unique_ptr<Symbol> symbol) {
+bool SymbolTable::declareSymbol(SymbolId name, std::unique_ptr<Symbol> symbol) {
     if (scopes.empty()) {
         return false;
     }
@@ -30,13 +33,11 @@ bool SymbolTable::declareSymbol(const std::string& name, std::unique_ptr<Symbol>
         return false; // 重复声明
     }
 
-    // 记录符号位置信息
-    symbol->name = name;
     currentScope[name] = std::move(symbol);
     return true;
 }
 
-Symbol* SymbolTable::lookupSymbol(const std::string& name) {
+Symbol* SymbolTable::lookupSymbol(SymbolId name) {
     // 从内层作用域到外层作用域查找
     for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
         auto found = it->find(name);
@@ -47,7 +48,7 @@ Symbol* SymbolTable::lookupSymbol(const std::string& name) {
     return nullptr;
 }
 
-bool SymbolTable::isSymbolInCurrentScope(const std::string& name) {
+bool SymbolTable::isSymbolInCurrentScope(SymbolId name) {
     if (scopes.empty()) {
         return false;
     }
@@ -65,7 +66,7 @@ void SymbolTable::printCurrentScope() {
     auto& currentScope = scopes.back();
     std::cout << "   📋 当前作用域符号数量: " << currentScope.size() << std::endl;
     for (const auto& pair : currentScope) {
-        std::cout << "     - " << pair.first << " : " << pair.second->type << std::endl;
+        std::cout << "     - " << pair.second->name << " : " << pair.second->type << std::endl;
     }
 }
 
@@ -81,11 +82,11 @@ void SemanticAnalyzer::initializeBuiltinFunctions() {
     // print(string) -> void
     std::vector<std::string> printParams = {"string"};
     auto printFunc = std::make_unique<FunctionSymbol>("print", printParams, "void");
-    symbolTable.declareSymbol("print", std::move(printFunc));
+    symbolTable.declareSymbol(Interner::kPrint, std::move(printFunc));
 
     // 添加内置的 打印 函数 (中文版本)
     auto printChineseFunc = std::make_unique<FunctionSymbol>("打印", printParams, "void");
-    symbolTable.declareSymbol("打印", std::move(printChineseFunc));
+    symbolTable.declareSymbol(Interner::kPrintChinese, std::move(printChineseFunc));
 
     // 添加重载版本，支持不同类型的参数
     // print(int) -> void
@@ -107,6 +108,9 @@ bool SemanticAnalyzer::analyze(const std::unique_ptr<Program>& program) {
 
     errors.clear();
     hasErrors = false;
+    deferredBodies.clear();
+    requiredBodies.clear();
+    unparsedBodies.clear();
 
     if (program) {
         visitProgram(program.get());
@@ -124,19 +128,43 @@ bool SemanticAnalyzer::analyze(const std::unique_ptr<Program>& program) {
 
 void SemanticAnalyzer::visitProgram(Program* program) {
     // 遍历所有顶级声明
-    for (const auto& stmt : program->statements) {
-        if (auto importDecl = dynamic_cast<ImportDecl*>(stmt.get())) {
-            visitImportDecl(importDecl);
-        } else if (auto funcDecl = dynamic_cast<FunctionDecl*>(stmt.get())) {
-            visitFunctionDecl(funcDecl);
-        } else if (auto structDecl = dynamic_cast<StructDecl*>(stmt.get())) {
-            visitStructDecl(structDecl);
-        } else if (auto implBlock = dynamic_cast<ImplBlock*>(stmt.get())) {
-            visitImplBlock(implBlock);
-        } else if (auto varDecl = dynamic_cast<VariableDecl*>(stmt.get())) {
-            visitVariableDecl(varDecl);
+    for (ASTNode* stmt : program->statements) {
+        visit(stmt, [this](auto* n) {
+            using T = std::remove_pointer_t<decltype(n)>;
+            if constexpr (std::is_same_v<T, ImportDecl>) {
+                visitImportDecl(n);
+            } else if constexpr (std::is_same_v<T, FunctionDecl>) {
+                visitFunctionDecl(n);
+            } else if constexpr (std::is_same_v<T, StructDecl>) {
+                visitStructDecl(n);
+            } else if constexpr (std::is_same_v<T, ImplBlock>) {
+                visitImplBlock(n);
+            } else if constexpr (std::is_same_v<T, VariableDecl>) {
+                visitVariableDecl(n);
+            }
+        });
+    }
+
+    // 从入口函数出发分析延后的函数体；分析中遇到的调用继续加入队列
+    requireBody(Interner::kMain);
+    requireBody(Interner::kMainChinese);
+    for (size_t i = 0; i < requiredBodies.size(); ++i) {
+        visitFunctionBody(requiredBodies[i]);
+    }
+
+    // 记下仍未解析的函数体：用不到的顶层函数，以及暂不分析的实现块中的方法
+    for (ASTNode* stmt : program->statements) {
+        if (auto function = nodeCast<FunctionDecl>(stmt)) {
+            if (function->lazyBody) unparsedBodies.push_back(function);
+        } else if (auto impl = nodeCast<ImplBlock>(stmt)) {
+            for (FunctionDecl* method : impl->methods) {
+                if (method->lazyBody) unparsedBodies.push_back(method);
+            }
         }
     }
+    if (!unparsedBodies.empty()) {
+        std::cout << "     ⏳ 骨架模式下未解析的函数体: " << unparsedBodies.size() << " 个" << std::endl;
+    }
 }
 
 void SemanticAnalyzer::visitImportDecl(ImportDecl* importDecl) {
@@ -157,8 +185,8 @@ void SemanticAnalyzer::visitFunctionDecl(FunctionDecl* funcDecl) {
     }
 
     // 检查是否重复声明
-    if (symbolTable.isSymbolInCurrentScope(funcDecl->name)) {
-        reportError("函数 '" + funcDecl->name + "' 重复声明", funcDecl);
+    if (symbolTable.isSymbolInCurrentScope(funcDecl->symbol)) {
+        reportError("函数 '" + std::string(funcDecl->name) + "' 重复声明", funcDecl);
         return;
     }
 
@@ -166,7 +194,7 @@ void SemanticAnalyzer::visitFunctionDecl(FunctionDecl* funcDecl) {
     std::vector<std::string> paramTypes;
     for (const auto& param : funcDecl->parameters) {
         if (param->type) {
-            paramTypes.push_back(param->type->name);
+            paramTypes.push_back(std::string(param->type->name));
         } else {
             paramTypes.push_back("auto"); // 类型推导
         }
@@ -185,34 +213,49 @@ void SemanticAnalyzer::visitFunctionDecl(FunctionDecl* funcDecl) {
 
     // 注册函数符号
     auto funcSymbol = std::make_unique<FunctionSymbol>(
-        funcDecl->name, paramTypes, returnType);
+        std::string(funcDecl->name), paramTypes, returnType);
     funcSymbol->line = funcDecl->line;
     funcSymbol->column = funcDecl->column;
 
-    if (!symbolTable.declareSymbol(funcDecl->name, std::move(funcSymbol))) {
-        reportError("无法声明函数: " + funcDecl->name, funcDecl);
+    if (!symbolTable.declareSymbol(funcDecl->symbol, std::move(funcSymbol))) {
+        reportError("无法声明函数: " + std::string(funcDecl->name), funcDecl);
         return;
     }
 
+    // 尚未解析的函数体等到确认会用到时再分析
+    if (funcDecl->lazyBody) {
+        deferredBodies[funcDecl->symbol] = funcDecl;
+    } else {
+        visitFunctionBody(funcDecl);
+    }
+
+    std::cout << "     函数声明: " << funcDecl->name
+              << "(" << paramTypes.size() << " 参数) -> " << returnType << std::endl;
+}
+
+void SemanticAnalyzer::visitFunctionBody(FunctionDecl* funcDecl) {
     // 进入函数作用域分析函数体
     symbolTable.enterScope();
 
     // 将参数加入函数作用域
     for (const auto& param : funcDecl->parameters) {
-        visitVariableDecl(param.get());
+        visitVariableDecl(param);
     }
 
-    // 分析函数体
-    if (funcDecl->body) {
-        if (auto block = dynamic_cast<Block*>(funcDecl->body.get())) {
-            visitBlock(block);
-        }
+    // 分析函数体（骨架模式下在此解析，函数体有语法错误时抛出 ParserError）
+    if (auto block = nodeCast<Block>(funcDecl->getBody())) {
+        visitBlock(block);
     }
 
     symbolTable.exitScope();
+}
 
-    std::cout << "     函数声明: " << funcDecl->name
-              << "(" << paramTypes.size() << " 参数) -> " << returnType << std::endl;
+void SemanticAnalyzer::requireBody(SymbolId function) {
+    auto it = deferredBodies.find(function);
+    if (it != deferredBodies.end()) {
+        requiredBodies.push_back(it->second);
+        deferredBodies.erase(it);
+    }
 }
 
 void SemanticAnalyzer::visitStructDecl(StructDecl* structDecl) {
@@ -231,8 +274,8 @@ void SemanticAnalyzer::visitVariableDecl(VariableDecl* varDecl) {
     }
 
     // 检查当前作用域重复声明
-    if (symbolTable.isSymbolInCurrentScope(varDecl->name)) {
-        reportError("变量 '" + varDecl->name + "' 重复声明", varDecl);
+    if (symbolTable.isSymbolInCurrentScope(varDecl->symbol)) {
+        reportError("变量 '" + std::string(varDecl->name) + "' 重复声明", varDecl);
         return;
     }
 
@@ -243,7 +286,7 @@ void SemanticAnalyzer::visitVariableDecl(VariableDecl* varDecl) {
         // 验证类型
         if (!isBuiltinType(varType)) {
             // 检查是否是用户定义类型
-            Symbol* typeSymbol = symbolTable.lookupSymbol(varType);
+            Symbol* typeSymbol = symbolTable.lookupSymbol(Interner::global().intern(varType));
             if (!typeSymbol || typeSymbol->type != "struct") {
                 reportError("未知类型: " + varType, varDecl);
                 return;
@@ -251,24 +294,26 @@ void SemanticAnalyzer::visitVariableDecl(VariableDecl* varDecl) {
         }
     } else if (varDecl->initializer) {
         // 从初始化表达式推导类型
-        varType = getExpressionType(dynamic_cast<Expression*>(varDecl->initializer.get()));
+        varType = getExpressionType(nodeCast<Expression>(varDecl->initializer));
     }
 
     // 类型检查：如果有显式类型和初始化表达式，检查兼容性
     if (varDecl->type && varDecl->initializer) {
-        std::string initType = getExpressionType(dynamic_cast<Expression*>(varDecl->initializer.get()));
+        std::string initType = getExpressionType(nodeCast<Expression>(varDecl->initializer));
         if (!isTypeCompatible(varType, initType)) {
             reportError("类型不匹配: 期望 " + varType + "，得到 " + initType, varDecl);
+        } else if (auto literal = nodeCast<Literal>(varDecl->initializer)) {
+            checkLiteralRange(varType, literal, varDecl);
         }
     }
 
     // 注册变量符号
-    auto varSymbol = std::make_unique<Symbol>(varDecl->name, varType, varDecl->isConst);
+    auto varSymbol = std::make_unique<Symbol>(std::string(varDecl->name), varType, varDecl->isConst);
     varSymbol->line = varDecl->line;
     varSymbol->column = varDecl->column;
 
-    if (!symbolTable.declareSymbol(varDecl->name, std::move(varSymbol))) {
-        reportError("无法声明变量: " + varDecl->name, varDecl);
+    if (!symbolTable.declareSymbol(varDecl->symbol, std::move(varSymbol))) {
+        reportError("无法声明变量: " + std::string(varDecl->name), varDecl);
         return;
     }
 
@@ -279,16 +324,19 @@ void SemanticAnalyzer::visitVariableDecl(VariableDecl* varDecl) {
 void SemanticAnalyzer::visitBlock(Block* block) {
     symbolTable.enterScope();
 
-    for (const auto& stmt : block->statements) {
-        if (auto varDecl = dynamic_cast<VariableDecl*>(stmt.get())) {
-            visitVariableDecl(varDecl);
-        } else if (auto returnStmt = dynamic_cast<ReturnStmt*>(stmt.get())) {
-            visitReturnStmt(returnStmt);
-        } else if (auto exprStmt = dynamic_cast<ExpressionStmt*>(stmt.get())) {
-            visitExpressionStmt(exprStmt);
-        } else if (auto nestedBlock = dynamic_cast<Block*>(stmt.get())) {
-            visitBlock(nestedBlock);
-        }
+    for (Statement* stmt : block->statements) {
+        visit(stmt, [this](auto* n) {
+            using T = std::remove_pointer_t<decltype(n)>;
+            if constexpr (std::is_same_v<T, VariableDecl>) {
+                visitVariableDecl(n);
+            } else if constexpr (std::is_same_v<T, ReturnStmt>) {
+                visitReturnStmt(n);
+            } else if constexpr (std::is_same_v<T, ExpressionStmt>) {
+                visitExpressionStmt(n);
+            } else if constexpr (std::is_same_v<T, Block>) {
+                visitBlock(n);
+            }
+        });
     }
 
     symbolTable.exitScope();
@@ -296,7 +344,7 @@ void SemanticAnalyzer::visitBlock(Block* block) {
 
 void SemanticAnalyzer::visitReturnStmt(ReturnStmt* returnStmt) {
     if (returnStmt->value) {
-        std::string returnType = visitExpression(dynamic_cast<Expression*>(returnStmt->value.get()));
+        std::string returnType = visitExpression(returnStmt->value);
         std::cout << "     返回语句: " << returnType << std::endl;
     } else {
         std::cout << "     返回语句: void" << std::endl;
@@ -305,7 +353,7 @@ void SemanticAnalyzer::visitReturnStmt(ReturnStmt* returnStmt) {
 
 void SemanticAnalyzer::visitExpressionStmt(ExpressionStmt* exprStmt) {
     if (exprStmt->expression) {
-        visitExpression(dynamic_cast<Expression*>(exprStmt->expression.get()));
+        visitExpression(exprStmt->expression);
     }
 }
 
@@ -314,51 +362,69 @@ std::string SemanticAnalyzer::visitExpression(Expression* expr) {
         return "void";
     }
 
-    if (auto identifier = dynamic_cast<Identifier*>(expr)) {
-        return visitIdentifier(identifier);
-    } else if (auto literal = dynamic_cast<Literal*>(expr)) {
-        return visitLiteral(literal);
-    } else if (auto binaryOp = dynamic_cast<BinaryOp*>(expr)) {
-        return visitBinaryOp(binaryOp);
-    } else if (auto funcCall = dynamic_cast<FunctionCall*>(expr)) {
-        // 函数调用：目前仅校验函数是否存在；参数类型暂放宽（print/打印 可接受任意参数）
-        Symbol* sym = symbolTable.lookupSymbol(funcCall->name);
-        if (!sym || sym->type != std::string("function")) {
-            // 允许内置函数未显式登记时继续，但给出提示
-            std::cout << "     ⚠️ 未登记的函数调用: " << funcCall->name << std::endl;
-            // 仍然尝试分析参数，确保子表达式被遍历
-            for (auto& arg : funcCall->arguments) {
-                visitExpression(arg.get());
-            }
-            return "void";
+    return visit(expr, [this](auto* n) -> std::string {
+        using T = std::remove_pointer_t<decltype(n)>;
+        if constexpr (std::is_same_v<T, Identifier>) {
+            return visitIdentifier(n);
+        } else if constexpr (std::is_same_v<T, Literal>) {
+            return visitLiteral(n);
+        } else if constexpr (std::is_same_v<T, BinaryOp>) {
+            return visitBinaryOp(n);
+        } else if constexpr (std::is_same_v<T, UnaryOp>) {
+            return visitUnaryOp(n);
+        } else if constexpr (std::is_same_v<T, FunctionCall>) {
+            return visitFunctionCall(n);
+        } else {
+            return "unknown";
         }
-        // 遍历参数表达式（触发类型检查/推导）
+    });
+}
+
+std::string SemanticAnalyzer::visitFunctionCall(FunctionCall* funcCall) {
+    // 函数调用：目前仅校验函数是否存在；参数类型暂放宽（print/打印 可接受任意参数）
+    Symbol* sym = symbolTable.lookupSymbol(funcCall->symbol);
+    if (!sym || sym->type != std::string("function")) {
+        // 允许内置函数未显式登记时继续，但给出提示
+        std::cout << "     ⚠️ 未登记的函数调用: " << funcCall->name << std::endl;
+        // 仍然尝试分析参数，确保子表达式被遍历
         for (auto& arg : funcCall->arguments) {
-            visitExpression(arg.get());
+            visitExpression(arg);
         }
         return "void";
     }
-
-    return "unknown";
+    requireBody(funcCall->symbol);
+    // 遍历参数表达式（触发类型检查/推导）
+    for (auto& arg : funcCall->arguments) {
+        visitExpression(arg);
+    }
+    return "void";
 }
 
 std::string SemanticAnalyzer::visitIdentifier(Identifier* identifier) {
-    Symbol* symbol = symbolTable.lookupSymbol(identifier->name);
+    Symbol* symbol = symbolTable.lookupSymbol(identifier->symbol);
     if (!symbol) {
-        reportError("未声明的标识符: " + identifier->name, identifier);
+        reportError("未声明的标识符: " + std::string(identifier->name), identifier);
         return "error";
     }
+    // 只被引用（未被直接调用）的函数同样要分析函数体
+    if (symbol->type == std::string("function")) {
+        requireBody(identifier->symbol);
+    }
 
     return symbol->type;
 }
 
 std::string SemanticAnalyzer::visitLiteral(Literal* literal) {
-    return literal->type;
+    // 词法阶段允许 2^63 只为写出 i64 的最小值；前面没有负号时它以 INT64_MIN 存放，超出任何整数类型
+    if (literal->type == "int" && literal->intValue < 0 && literal->value[0] != '-') {
+        reportError("整数字面值 " + std::string(literal->value) + " 超出 i64 的范围", literal);
+    }
+    return std::string(literal->type);
 }
 
 std::string SemanticAnalyzer::visitBinaryOp(BinaryOp* binaryOp) {
-    std::string leftType = visitExpression(binaryOp->left.get());
-    std::string rightType = visitExpression(binaryOp->right.get());
+    std::string leftType = visitExpression(binaryOp->left);
+    std::string rightType = visitExpression(binaryOp->right);
 
     // 简单的二元运算类型推导
     if (leftType == "error" || rightType == "error") {
@@ -367,17 +433,17 @@ std::string SemanticAnalyzer::visitBinaryOp(BinaryOp* binaryOp) {
 
     // 算术运算
     if (binaryOp->operator_ == "+" || binaryOp->operator_ == "-" ||
-        binaryOp->operator_ == "*" || binaryOp->operator_ == "/") {
+        binaryOp->operator_ == "*" || binaryOp->operator_ == "/" || binaryOp->operator_ == "%") {
 
         if (leftType == "int" && rightType == "int") {
             return "int";
         } else if ((leftType == "float" || leftType == "int") &&
-                   (rightType == "float" || rightType == "int")) {
+                   (rightType == "float" || rightType == "int") && binaryOp->operator_ != "%") {
             return "float";
         } else if (leftType == "string" && rightType == "string" && binaryOp->operator_ == "+") {
             return "string";
         } else {
-            reportError("类型不兼容的二元运算: " + leftType + " " + binaryOp->operator_ + " " + rightType, binaryOp);
+            reportError("类型不兼容的二元运算: " + leftType + " " + std::string(binaryOp->operator_) + " " + rightType, binaryOp);
             return "error";
         }
     }
@@ -390,7 +456,17 @@ std::string SemanticAnalyzer::visitBinaryOp(BinaryOp* binaryOp) {
         if (isTypeCompatible(leftType, rightType)) {
             return "bool";
         } else {
-            reportError("类型不兼容的比较运算: " + leftType + " " + binaryOp->operator_ + " " + rightType, binaryOp);
+            reportError("类型不兼容的比较运算: " + leftType + " " + std::string(binaryOp->operator_) + " " + rightType, binaryOp);
+            return "error";
+        }
+    }
+
+    // 逻辑运算
+    if (binaryOp->operator_ == "&&" || binaryOp->operator_ == "||") {
+        if (leftType == "bool" && rightType == "bool") {
+            return "bool";
+        } else {
+            reportError("逻辑运算的操作数须为 bool: " + leftType + " " + std::string(binaryOp->operator_) + " " + rightType, binaryOp);
             return "error";
         }
     }
@@ -398,12 +474,28 @@ std::string SemanticAnalyzer::visitBinaryOp(BinaryOp* binaryOp) {
     return "unknown";
 }
 
+std::string SemanticAnalyzer::visitUnaryOp(UnaryOp* unaryOp) {
+    std::string operandType = visitExpression(unaryOp->operand);
+    if (operandType == "error") {
+        return "error";
+    }
+
+    if (unaryOp->operator_ == "-" && (operandType == "int" || operandType == "float")) {
+        return operandType;
+    } else if (unaryOp->operator_ == "!" && operandType == "bool") {
+        return "bool";
+    }
+
+    reportError("类型不兼容的一元运算: " + std::string(unaryOp->operator_) + operandType, unaryOp);
+    return "error";
+}
+
 std::string SemanticAnalyzer::getExpressionType(Expression* expr) {
     return visitExpression(expr);
 }
 
 bool SemanticAnalyzer::isBuiltinType(const std::string& type) {
-    return type == "int" || type == "i32" || type == "i64" ||
+    return type == "int" || type == "i8" || type == "i16" || type == "i32" || type == "i64" ||
            type == "float" || type == "f32" || type == "f64" ||
            type == "string" || type == "bool" || type == "char" ||
            type == "void" || type == "auto";
@@ -431,6 +523,16 @@ bool SemanticAnalyzer::isTypeCompatible(const std::string& expected, const std::
         return true;
     }
 
+    // 整数字面值（int）可以赋给任意宽度的整数，是否越界由 checkLiteralRange 检查
+    if ((expected == "i8" || expected == "i16" || expected == "i64") && actual == "int") {
+        return true;
+    }
+
+    // 浮点字面值（float）同样可以赋给 f64
+    if (expected == "f64" && actual == "float") {
+        return true;
+    }
+
     // f32 和 float 别名
     if ((expected == "float" && actual == "f32") || (expected == "f32" && actual == "float")) {
         return true;
@@ -439,6 +541,24 @@ bool SemanticAnalyzer::isTypeCompatible(const std::string& expected, const std::
     return false;
 }
 
+void SemanticAnalyzer::checkLiteralRange(const std::string& type, Literal* literal, VariableDecl* varDecl) {
+    if (literal->type == "int") {
+        int64_t max = INT64_MAX;
+        if (type == "i8") max = INT8_MAX;
+        else if (type == "i16") max = INT16_MAX;
+        else if (type == "i32" || type == "int") max = INT32_MAX;
+        // 负号已在语法分析时并入字面值（-128 是一个字面值），这里看到的是带符号的最终值
+        if (literal->intValue < 0 && literal->value[0] != '-') return;  // 2^63，已在 visitLiteral 中报告
+        if (literal->intValue > max || literal->intValue < -max - 1) {
+            reportError("整数字面值 " + std::string(literal->value) + " 超出 " + type + " 的范围", varDecl);
+        }
+    } else if (literal->type == "float" && (type == "f32" || type == "float")) {
+        if (std::fabs(literal->floatValue) > FLT_MAX) {
+            reportError("浮点字面值 " + std::string(literal->value) + " 超出 " + type + " 的范围", varDecl);
+        }
+    }
+}
+
 void SemanticAnalyzer::reportError(const std::string& message, ASTNode* node) {
     SemanticErrorInfo error(message);
     if (node) {
@@ -33,7 +33,8 @@ struct FunctionSymbol : public Symbol {
 // 作用域管理
 class SymbolTable {
 private:
-    std::vector<std::unordered_map<std::string, std::unique_ptr<Symbol>>> scopes;
+    // 各作用域按名字的驻留编号索引
+    std::vector<std::unordered_map<SymbolId, std::unique_ptr<Symbol>>> scopes;
 
 public:
     SymbolTable();
@@ -44,9 +45,9 @@ public:
     void exitScope();
 
     // 符号操作
-    bool declareSymbol(const std::string& name, std::unique_ptr<Symbol> symbol);
-    Symbol* lookupSymbol(const std::string& name);
-    bool isSymbolInCurrentScope(const std::string& name);
+    bool declareSymbol(SymbolId name, std::unique_ptr<Symbol> symbol);
+    Symbol* lookupSymbol(SymbolId name);
+    bool isSymbolInCurrentScope(SymbolId name);
 
     // 调试输出
     void printCurrentScope();
@@ -68,6 +69,13 @@ private:
     std::vector<SemanticErrorInfo> errors;
     bool hasErrors = false;
 
+    // 骨架模式下尚未解析的函数体：声明时只登记签名，入口函数及（传递地）被它调用或引用的函数才解析并分析函数体，
+    // 用不到的函数体不解析，其中的语法错误也不报告；分析结束时仍未解析的函数体（含实现块的方法）记在 unparsedBodies
+    std::unordered_map<SymbolId, FunctionDecl*> deferredBodies;
+    std::vector<FunctionDecl*> requiredBodies;
+    std::vector<const FunctionDecl*> unparsedBodies;
+    void requireBody(SymbolId function);
+
     // 内置函数初始化
     void initializeBuiltinFunctions();
 
@@ -79,6 +87,7 @@ private:
     void visitProgram(Program* program);
     void visitImportDecl(ImportDecl* importDecl);
     void visitFunctionDecl(FunctionDecl* funcDecl);
+    void visitFunctionBody(FunctionDecl* funcDecl);
     void visitStructDecl(StructDecl* structDecl);
     void visitImplBlock(ImplBlock* implBlock);
     void visitVariableDecl(VariableDecl* varDecl);
@@ -91,10 +100,14 @@ private:
     std::string visitIdentifier(Identifier* identifier);
     std::string visitLiteral(Literal* literal);
     std::string visitBinaryOp(BinaryOp* binaryOp);
+    std::string visitUnaryOp(UnaryOp* unaryOp);
+    std::string visitFunctionCall(FunctionCall* funcCall);
 
     // 错误处理
     void reportError(const std::string& message, ASTNode* node = nullptr);
     bool isTypeCompatible(const std::string& expected, const std::string& actual);
+    // 数值字面值是否放得进声明的宽度（i8…i64、f32/f64）
+    void checkLiteralRange(const std::string& type, Literal* literal, VariableDecl* varDecl);
 
 public:
     SemanticAnalyzer();
@@ -106,6 +119,8 @@ public:
     // 错误信息获取
     const std::vector<SemanticErrorInfo>& getErrors() const { return errors; }
     bool hasSemanticErrors() const { return hasErrors; }
+    // 骨架模式下没有解析、因而没有检查的函数体，按源码顺序
+    const std::vector<const FunctionDecl*>& getUnparsedBodies() const { return unparsedBodies; }
 
     // 调试输出
     void printErrors();
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "lexer_simd.h"
+#include "source_file.h"
+
+// 源码缓冲区：持有整个编译流水线共享的源码文本
+// Token 只保存指向这里的 std::string_view，因此缓冲区必须比 Token/Parser 活得更久。
+// 文本放在独立的堆对象中（或直接是映射的源文件），移动 SourceBuffer 不会改变数据地址（已发出的视图保持有效）。
+class SourceBuffer {
+public:
+    // 加载期校验的结论：Unchecked 表示没有校验过（词法分析逐字符检查编码），
+    // Utf8 为合法 UTF-8（词法分析不再检查后续字节），Ascii 为纯 ASCII（词法分析不解码多字节字符）
+    enum class Encoding : uint8_t { Unchecked, Utf8, Ascii };
+
+private:
+    std::unique_ptr<std::string> storage;  // 自有文本（转码结果、编辑后的源码等）
+    std::unique_ptr<SourceFile> file;      // 或者映射的源文件
+    std::string_view view;
+    Encoding encodingState = Encoding::Unchecked;
+
+public:
+    SourceBuffer() : storage(std::make_unique<std::string>()), view(*storage) {}
+    explicit SourceBuffer(std::string text)
+        : storage(std::make_unique<std::string>(std::move(text))), view(*storage) {}
+    explicit SourceBuffer(SourceFile source)
+        : file(std::make_unique<SourceFile>(std::move(source))), view(file->text()) {}
+
+    SourceBuffer(SourceBuffer&&) noexcept = default;
+    SourceBuffer& operator=(SourceBuffer&&) noexcept = default;
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    std::string_view text() const { return view; }
+    const char* data() const { return view.data(); }
+    size_t size() const { return view.size(); }
+    bool empty() const { return view.empty(); }
+
+    // 一次向量化扫描校验 UTF-8 并判断是否纯 ASCII；返回第一个非法序列的偏移，合法时返回 size()
+    size_t validate() {
+        lexer_simd::Utf8Validation result = lexer_simd::validateUtf8(view.data(), view.size());
+        if (result.errorOffset == view.size()) {
+            encodingState = result.ascii ? Encoding::Ascii : Encoding::Utf8;
+        }
+        return result.errorOffset;
+    }
+    Encoding encoding() const { return encodingState; }
+};
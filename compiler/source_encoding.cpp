@@ -0,0 +1,171 @@
+#include "source_encoding.h"
+#include "error.h"
+#include "gb18030_table_gen.h"
+#include "lexer_simd.h"
+#include "token_store.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace source_encoding {
+
+namespace {
+
+// GB18030 四字节区的起点 81 30 81 30 与辅助平面起点 90 30 81 30 的线性序号
+constexpr uint32_t kSupplementaryLinear = (0x90 - 0x81) * 12600;
+
+void appendUtf8(std::string& out, char32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// 四字节 BMP 区：找到线性序号所在的连续段
+char32_t fourByteBmp(uint32_t linear) {
+    using gb18030_tables::kFourByteRanges;
+    auto it = std::upper_bound(std::begin(kFourByteRanges), std::end(kFourByteRanges), linear,
+                               [](uint32_t value, const gb18030_tables::FourByteRange& range) {
+                                   return value < range.linear;
+                               }) - 1;
+    return it->codepoint + (linear - it->linear);
+}
+
+bool startsWith(std::string_view text, std::string_view prefix) {
+    return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// 非 ASCII 字节中有多大比例能组成合法的 UTF-8 多字节序列（跳过非法字节后继续统计）。
+// UTF-8 文件即使损坏了个别字节，比例也接近 1；GBK 文本的双字节组合很少恰好是合法 UTF-8。
+double utf8Likelihood(std::string_view text) {
+    size_t highBytes = 0;
+    size_t validBytes = 0;
+    for (size_t i = 0; i < text.size();) {
+        i += lexer_simd::findNonAscii(text.data() + i, text.size() - i);
+        if (i >= text.size()) break;
+        // 按首字节取一个字符的长度，校验这一个字符是否合法
+        const unsigned char lead = static_cast<unsigned char>(text[i]);
+        const size_t expected = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : 2;
+        if (expected <= text.size() - i &&
+            lexer_simd::validateUtf8(text.data() + i, expected).errorOffset == expected) {
+            validBytes += expected;
+            highBytes += expected;
+            i += expected;
+        } else {
+            ++highBytes;
+            ++i;
+        }
+    }
+    return highBytes == 0 ? 1.0 : static_cast<double>(validBytes) / static_cast<double>(highBytes);
+}
+
+SourceBuffer validated(std::string text) {
+    SourceBuffer buffer(std::move(text));
+    buffer.validate();
+    return buffer;
+}
+
+} // namespace
+
+const char* charsetName(Charset charset) {
+    return charset == Charset::Gb18030 ? "GB18030" : "UTF-8";
+}
+
+bool transcodeGb18030(std::string_view input, std::string& out, size_t& errorOffset) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(input.data());
+    const size_t n = input.size();
+    out.clear();
+    out.reserve(n + n / 2);  // 双字节汉字转为三字节
+
+    size_t i = 0;
+    while (i < n) {
+        // ASCII 段整段复制
+        size_t ascii = lexer_simd::findNonAscii(input.data() + i, n - i);
+        out.append(input.data() + i, ascii);
+        i += ascii;
+        if (i >= n) break;
+
+        const unsigned char b1 = p[i];
+        if (b1 == 0x80 || b1 == 0xFF || i + 1 >= n) {
+            errorOffset = i;
+            return false;
+        }
+        const unsigned char b2 = p[i + 1];
+        char32_t cp;
+        if (b2 >= 0x40 && b2 <= 0xFE && b2 != 0x7F) {
+            cp = gb18030_tables::kTwoByte[(b1 - 0x81) * 190 + (b2 - 0x40) - (b2 > 0x7F ? 1 : 0)];
+            i += 2;
+        } else if (b2 >= 0x30 && b2 <= 0x39 && i + 3 < n && p[i + 2] >= 0x81 && p[i + 2] <= 0xFE &&
+                   p[i + 3] >= 0x30 && p[i + 3] <= 0x39) {
+            const uint32_t linear = (b1 - 0x81) * 12600u + (b2 - 0x30) * 1260u + (p[i + 2] - 0x81) * 10u +
+                                    (p[i + 3] - 0x30);
+            if (linear < gb18030_tables::kFourByteBmpCount) {
+                cp = fourByteBmp(linear);
+            } else if (linear >= kSupplementaryLinear && linear - kSupplementaryLinear <= 0x10FFFF - 0x10000) {
+                cp = 0x10000 + (linear - kSupplementaryLinear);
+            } else {
+                errorOffset = i;
+                return false;
+            }
+            i += 4;
+        } else {
+            errorOffset = i;
+            return false;
+        }
+        appendUtf8(out, cp);
+    }
+    return true;
+}
+
+SourceBuffer loadSource(SourceBuffer raw, Charset* detected) {
+    if (detected) *detected = Charset::Utf8;
+    std::string_view bytes = raw.text();
+
+    // BOM 明确给出编码
+    if (startsWith(bytes, "\xFF\xFE") || startsWith(bytes, "\xFE\xFF")) {
+        throw LexerError("不支持 UTF-16 编码的源码，请另存为 UTF-8", 1, 1);
+    }
+    if (startsWith(bytes, "\x84\x31\x95\x33")) {
+        std::string utf8;
+        size_t errorOffset = 0;
+        if (!transcodeGb18030(bytes.substr(4), utf8, errorOffset)) {
+            SourcePosition position = locateOffset(bytes, errorOffset + 4);
+            throw LexerError("源码带有 GB18030 BOM，但含有非法的 GB18030 字节序列", position.line, position.column);
+        }
+        if (detected) *detected = Charset::Gb18030;
+        return validated(std::move(utf8));
+    }
+
+    // 合法 UTF-8（包括带 UTF-8 BOM 的文件，BOM 由词法分析器跳过）原样返回，不复制
+    const size_t invalidOffset = raw.validate();
+    if (invalidOffset == raw.size()) {
+        return raw;
+    }
+
+    // 不是 UTF-8：大部分非 ASCII 字节都不成 UTF-8 序列、且整个文件能按 GB18030 解码时视为 GBK/GB18030
+    std::string utf8;
+    size_t gbErrorOffset = 0;
+    if (utf8Likelihood(bytes) < 0.9 && transcodeGb18030(bytes, utf8, gbErrorOffset)) {
+        if (detected) *detected = Charset::Gb18030;
+        return validated(std::move(utf8));
+    }
+
+    SourcePosition position = locateOffset(bytes, invalidOffset);
+    char byte[8];
+    std::snprintf(byte, sizeof(byte), "0x%02X", static_cast<unsigned char>(bytes[invalidOffset]));
+    throw LexerError("源码不是有效的 UTF-8 编码，也无法按 GB18030 解码（第" + std::to_string(position.line) + "行第" +
+                         std::to_string(position.column) + "列，字节 " + byte + "）",
+                     position.line, position.column);
+}
+
+} // namespace source_encoding
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "source_buffer.h"
+
+// 源文件编码检测与转码
+// 编译器内部只处理 UTF-8。加载源文件时按 BOM、UTF-8 合法性、GB18030 启发式判断原始编码，
+// GBK/GB18030 文件查表转为 UTF-8；已是 UTF-8 的文件原样移交，不再复制。
+namespace source_encoding {
+
+enum class Charset { Utf8, Gb18030 };
+
+const char* charsetName(Charset charset);
+
+// GB18030（含 GBK、GB2312）→ UTF-8。成功时把结果写入 out 并返回 true；
+// 遇到非法序列返回 false，errorOffset 为该序列首字节在输入中的偏移
+bool transcodeGb18030(std::string_view input, std::string& out, size_t& errorOffset);
+
+// 加载源码：检测编码并统一为已校验的 UTF-8（SourceBuffer::validate 已完成），detected 返回原始编码。
+// 已是 UTF-8 时原样返回 raw（映射的文件仍是映射）；既不是 UTF-8 也不是 GB18030 时抛出 LexerError，位置为第一个非法 UTF-8 字节
+SourceBuffer loadSource(SourceBuffer raw, Charset* detected = nullptr);
+
+} // namespace source_encoding
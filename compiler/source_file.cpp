@@ -0,0 +1,115 @@
+#include "source_file.h"
+#include "error.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceFile SourceFile::open(const std::string& path) {
+    SourceFile file;
+#ifdef _WIN32
+    // 使用宽字符接口打开UTF-8路径的文件
+    int wlen = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    if (wlen <= 0) {
+        throw CompilerError("路径转码失败: " + path);
+    }
+    std::wstring wpath(static_cast<size_t>(wlen - 1), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wpath[0], wlen);
+
+    HANDLE handle = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        throw CompilerError("无法打开文件: " + path);
+    }
+    LARGE_INTEGER size;
+    if (GetFileType(handle) == FILE_TYPE_DISK && GetFileSizeEx(handle, &size) && size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            // 视图独立于句柄存在，映射建立后即可关闭句柄
+            const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+            if (view) {
+                file.base = static_cast<const char*>(view);
+                file.length = static_cast<size_t>(size.QuadPart);
+            }
+        }
+    }
+    if (!file.base) {
+        char buffer[65536];
+        DWORD n = 0;
+        while (ReadFile(handle, buffer, sizeof(buffer), &n, nullptr) && n > 0) {
+            file.contents.append(buffer, n);
+        }
+    }
+    CloseHandle(handle);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw CompilerError("无法打开文件: " + path);
+    }
+    struct stat info {};
+    const bool regular = fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+    if (regular && info.st_size > 0) {
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view != MAP_FAILED) {
+            file.base = static_cast<const char*>(view);
+            file.length = static_cast<size_t>(info.st_size);
+        }
+    }
+    if (!file.base) {
+        // 管道/字符设备等：一次性读到末尾
+        if (regular) file.contents.reserve(static_cast<size_t>(info.st_size));
+        char buffer[65536];
+        ssize_t n;
+        while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+            file.contents.append(buffer, static_cast<size_t>(n));
+        }
+    }
+    ::close(fd);
+#endif
+    return file;
+}
+
+SourceFile::SourceFile(SourceFile&& other) noexcept
+    : base(other.base), length(other.length), contents(std::move(other.contents)) {
+    other.base = nullptr;
+    other.length = 0;
+}
+
+SourceFile& SourceFile::operator=(SourceFile&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        base = other.base;
+        length = other.length;
+        contents = std::move(other.contents);
+        other.base = nullptr;
+        other.length = 0;
+    }
+    return *this;
+}
+
+SourceFile::~SourceFile() {
+    unmap();
+}
+
+void SourceFile::unmap() {
+    if (!base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+#else
+    munmap(const_cast<char*>(base), length);
+#endif
+    base = nullptr;
+    length = 0;
+}
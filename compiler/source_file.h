@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// 只读打开的源文件
+// 普通文件直接映射到内存（POSIX 为 mmap，Windows 为 MapViewOfFile），词法分析与语种检测都在映射上进行，
+// 不再逐行复制；管道、空文件等无法映射的输入退回一次性读入内存。
+// 映射在对象销毁前保持有效；移动对象不会改变 text() 指向的地址（读入内存的情况除外，须先放进 SourceBuffer）。
+class SourceFile {
+private:
+    const char* base = nullptr;  // 映射的起始地址（未映射时为空）
+    size_t length = 0;
+    std::string contents;        // 无法映射时读入的内容
+
+    SourceFile() = default;
+    void unmap();
+
+public:
+    // 打开失败时抛出 CompilerError
+    static SourceFile open(const std::string& path);
+
+    SourceFile(SourceFile&& other) noexcept;
+    SourceFile& operator=(SourceFile&& other) noexcept;
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+    ~SourceFile();
+
+    std::string_view text() const { return base ? std::string_view(base, length) : std::string_view(contents); }
+    bool mapped() const { return base != nullptr; }
+};
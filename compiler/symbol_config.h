@@ -43,7 +43,7 @@ public:
         return (it != symbolToTokenType.end()) ? it->second : TokenType::UNKNOWN;
     }
 
-    // 提供整张符号映射表（用于覆盖Lexer内部symbolMap）
+    // 提供整张符号映射表（Lexer 据此判断是否需要覆盖构建期生成的符号表）
     const std::unordered_map<std::string, TokenType>& getAllSymbolTokenTypes() const {
         return symbolToTokenType;
     }
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include "token_types.h"
+
+// 关键字/符号查找表
+// 具体表项由 tools/gen/gen_symbol_tables.py 根据 symbol_mapping.json 在构建期生成（symbol_tables_gen.h），
+// 生成器为每张表挑选无冲突的哈希种子，查找时只需一次探测加一次比较，运行期不分配内存。
+// 运算符（半角与全角）由按字节工作的 DFA 以最长匹配识别。
+namespace symbol_tables {
+
+struct SymbolEntry {
+    std::string_view text;
+    TokenType type = TokenType::UNKNOWN;
+};
+
+// 只取长度、首尾各两个字节和中间一个字节参与混合；必须与生成器中的 hash_key 保持一致
+constexpr uint32_t hashKey(std::string_view s, uint32_t seed) {
+    const uint32_t n = static_cast<uint32_t>(s.size());
+    uint32_t h = n * 0x9E3779B9u;
+    if (n) {
+        auto at = [&](uint32_t i) { return static_cast<uint32_t>(static_cast<unsigned char>(s[i])); };
+        h ^= at(0) | (at(n > 1 ? 1 : 0) << 8) | (at(n - 1) << 16) | (at(n >= 2 ? n - 2 : 0) << 24);
+        h += at(n / 2) * 0x85EBCA6Bu;
+    }
+    h ^= h >> 15;
+    return h * seed;
+}
+
+struct PerfectHashTable {
+    const SymbolEntry* slots;  // 共 1 << bits 个槽位，空槽 text 为空
+    uint32_t bits;
+    uint32_t seed;
+    uint32_t count;
+
+    constexpr TokenType find(std::string_view s) const {
+        const SymbolEntry& e = slots[hashKey(s, seed) >> (32 - bits)];
+        return (!e.text.empty() && e.text == s) ? e.type : TokenType::UNKNOWN;
+    }
+
+    constexpr uint32_t capacity() const { return 1u << bits; }
+};
+
+// 运算符 DFA：状态 0 为死状态，1 为起始状态；字节先映射到字节类以压缩转移表
+struct SymbolDfa {
+    const uint8_t* byteClass;   // 256 项
+    const uint16_t* next;       // [状态 * classCount + 字节类]
+    const TokenType* accept;    // 每个状态接受的 Token 类型，非接受状态为 UNKNOWN
+    uint32_t classCount;
+
+    // 从 s 开头做最长匹配；length 为匹配的字节数，没有匹配时为 0 并返回 UNKNOWN
+    TokenType match(std::string_view s, size_t& length) const {
+        TokenType best = TokenType::UNKNOWN;
+        length = 0;
+        uint32_t state = 1;
+        for (size_t i = 0; i < s.size(); ++i) {
+            state = next[state * classCount + byteClass[static_cast<unsigned char>(s[i])]];
+            if (state == 0) break;
+            if (accept[state] != TokenType::UNKNOWN) {
+                best = accept[state];
+                length = i + 1;
+            }
+        }
+        return best;
+    }
+};
+
+} // namespace symbol_tables
+
+#include "symbol_tables_gen.h"
@@ -0,0 +1,166 @@
+#include "token_store.h"
+#include "lexer_simd.h"
+#include "utf8.h"
+#include <algorithm>
+#include <cstring>
+
+// 解码字面值主体中的转义序列（词法阶段已校验过合法性）
+static std::string decodeEscapes(std::string_view body) {
+    std::string value;
+    value.reserve(body.size());
+    for (size_t i = 0; i < body.size(); ++i) {
+        char c = body[i];
+        if (c == '\\' && utf8::startsWithCurlyDoubleQuote(body.data() + i + 1, body.size() - i - 1)) {
+            value += '"'; // 本地化模式下的 \“ \”
+            i += 3;
+        } else if (c == '\\' && i + 1 < body.size()) {
+            switch (body[++i]) {
+                case 'n': value += '\n'; break;
+                case 't': value += '\t'; break;
+                case 'r': value += '\r'; break;
+                default: value += body[i]; break; // \\ \" \'
+            }
+        } else {
+            value += c;
+        }
+    }
+    return value;
+}
+
+std::string Token::value() const {
+    if (type == TokenType::STRING_LITERAL) {
+        // 定界符可能是 ASCII 双引号（1 字节）或中文双引号（3 字节）
+        size_t open = text.empty() || text.front() == '"' ? 1 : 3;
+        size_t close = text.empty() || text.back() == '"' ? 1 : 3;
+        if (text.size() >= open + close) {
+            return decodeEscapes(text.substr(open, text.size() - open - close));
+        }
+    } else if (type == TokenType::CHAR_LITERAL && text.size() >= 2) {
+        return decodeEscapes(text.substr(1, text.size() - 2));
+    }
+    return std::string(text);
+}
+
+SourcePosition locateOffset(std::string_view source, size_t offset) {
+    offset = std::min(offset, source.size());
+    std::string_view before = source.substr(0, offset);
+    size_t lineStart = before.rfind('\n');
+    lineStart = lineStart == std::string_view::npos ? 0 : lineStart + 1;
+
+    SourcePosition position;
+    position.line = 1 + static_cast<int>(lexer_simd::countByte(before.data(), lineStart, '\n'));
+    position.column = 1 + static_cast<int>(lexer_simd::countCodepoints(before.data() + lineStart, offset - lineStart));
+    return position;
+}
+
+LineTable::LineTable(std::string_view source) : source(source) {
+    starts.reserve(lexer_simd::countByte(source.data(), source.size(), '\n') + 1);
+    starts.push_back(0);
+    const char* base = source.data();
+    const char* end = base + source.size();
+    for (const char* p = base; p < end;) {
+        const void* newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+        if (!newline) break;
+        p = static_cast<const char*>(newline) + 1;
+        starts.push_back(static_cast<uint32_t>(p - base));
+    }
+}
+
+SourcePosition LineTable::locate(size_t offset) const {
+    offset = std::min(offset, source.size());
+    // 最后一个不大于 offset 的行首
+    auto it = std::upper_bound(starts.begin(), starts.end(), static_cast<uint32_t>(offset)) - 1;
+    SourcePosition position;
+    position.line = static_cast<int>(it - starts.begin()) + 1;
+    position.column = 1 + static_cast<int>(lexer_simd::countCodepoints(source.data() + *it, offset - *it));
+    return position;
+}
+
+SourcePosition PositionCursor::advanceTo(size_t target) {
+    std::string_view skipped = source.substr(offset, target - offset);
+    size_t newlines = lexer_simd::countByte(skipped.data(), skipped.size(), '\n');
+    if (newlines > 0) {
+        size_t lineStart = skipped.rfind('\n') + 1;
+        position.line += static_cast<int>(newlines);
+        position.column = 1 + static_cast<int>(lexer_simd::countCodepoints(skipped.data() + lineStart,
+                                                                           skipped.size() - lineStart));
+    } else {
+        position.column += static_cast<int>(lexer_simd::countCodepoints(skipped.data(), skipped.size()));
+    }
+    offset = target;
+    return position;
+}
+
+TokenStore::TokenStore(TokenStore&& other) noexcept
+    : source(other.source),
+      kinds(std::move(other.kinds)),
+      offsets(std::move(other.offsets)),
+      lengths(std::move(other.lengths)),
+      numberTokens(std::move(other.numberTokens)),
+      numbers(std::move(other.numbers)) {
+}
+
+TokenStore& TokenStore::operator=(TokenStore&& other) noexcept {
+    if (this != &other) {
+        source = other.source;
+        kinds = std::move(other.kinds);
+        offsets = std::move(other.offsets);
+        lengths = std::move(other.lengths);
+        numberTokens = std::move(other.numberTokens);
+        numbers = std::move(other.numbers);
+    }
+    return *this;
+}
+
+void TokenStore::reserve(size_t count) {
+    kinds.reserve(count);
+    offsets.reserve(count);
+    lengths.reserve(count);
+}
+
+void TokenStore::append(const TokenStore& other, size_t count, size_t shift) {
+    kinds.insert(kinds.end(), other.kinds.begin(), other.kinds.begin() + static_cast<std::ptrdiff_t>(count));
+    lengths.insert(lengths.end(), other.lengths.begin(), other.lengths.begin() + static_cast<std::ptrdiff_t>(count));
+    const size_t base = offsets.size();
+    offsets.resize(base + count);
+    for (size_t i = 0; i < count; ++i) {
+        offsets[base + i] = other.offsets[i] + static_cast<uint32_t>(shift);
+    }
+    for (size_t i = 0; i < other.numberTokens.size() && other.numberTokens[i] < count; ++i) {
+        numberTokens.push_back(other.numberTokens[i] + static_cast<uint32_t>(base));
+        numbers.push_back(other.numbers[i]);
+    }
+}
+
+NumberValue TokenStore::number(size_t i) const {
+    auto it = std::lower_bound(numberTokens.begin(), numberTokens.end(), static_cast<uint32_t>(i));
+    if (it == numberTokens.end() || *it != i) return NumberValue{};
+    return numbers[static_cast<size_t>(it - numberTokens.begin())];
+}
+
+SourcePosition TokenStore::locate(size_t offset) const {
+    std::call_once(linesOnce, [this] { lines = LineTable(source); });
+    return lines.locate(offset);
+}
+
+Token TokenStore::token(size_t i) const {
+    SourcePosition position = this->position(i);
+    Token token(kind(i), text(i), position.line, position.column);
+    token.newlineBefore = newlineBefore(i);
+    token.number = number(i);
+    return token;
+}
+
+std::vector<Token> TokenStore::toTokens(PositionCursor cursor) const {
+    std::vector<Token> tokens;
+    tokens.reserve(size());
+    for (size_t i = 0; i < size(); ++i) {
+        SourcePosition position = cursor.advanceTo(offsets[i]);
+        tokens.emplace_back(kind(i), text(i), position.line, position.column);
+        tokens.back().newlineBefore = newlineBefore(i);
+    }
+    for (size_t i = 0; i < numberTokens.size(); ++i) {
+        tokens[numberTokens[i]].number = numbers[i];
+    }
+    return tokens;
+}
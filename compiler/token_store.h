@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "token_types.h"
+
+// 数值字面值的解码结果：INTEGER_LITERAL 用 integer，FLOAT_LITERAL 用 real
+union NumberValue {
+    int64_t integer;
+    double real;
+};
+
+// Token 结构体
+// text 是指向 SourceBuffer 的原始词素视图（不拷贝）；字符串/字符字面值保留两侧引号，
+// 转义序列在词法阶段只做校验，解码推迟到 value() 首次需要时。
+// 数值字面值在词法阶段解码一次，结果放在 number 中。
+struct Token {
+    TokenType type;
+    bool newlineBefore = false;  // 折叠换行模式下：与上一个Token之间有换行（文件开头为 false）
+    std::string_view text;
+    int line;
+    int column;
+    NumberValue number{};
+
+    Token(TokenType t, std::string_view s, int l, int c)
+        : type(t), text(s), line(l), column(c) {}
+
+    // 物化后的值：字面值解码转义并去掉引号，其余 Token 返回词素本身
+    std::string value() const;
+};
+
+// 源码位置：行、列均从 1 开始，列按字符计
+struct SourcePosition {
+    int line = 1;
+    int column = 1;
+};
+
+// 不建表的单次定位（只在报错等少数场合使用，代价与 offset 成正比）
+SourcePosition locateOffset(std::string_view source, size_t offset);
+
+// 行首偏移表：一次性找出所有换行，之后按偏移二分查找行号
+class LineTable {
+private:
+    std::string_view source;
+    std::vector<uint32_t> starts;  // 每行第一个字节的偏移，starts[0] == 0
+
+public:
+    LineTable() = default;
+    explicit LineTable(std::string_view source);
+
+    size_t lineCount() const { return starts.size(); }
+    SourcePosition locate(size_t offset) const;
+};
+
+// 顺序定位：对单调递增的一串偏移依次求行列号，总代价与跨过的源码长度成正比
+class PositionCursor {
+private:
+    std::string_view source;
+    size_t offset = 0;
+    SourcePosition position;
+
+public:
+    PositionCursor() = default;
+    explicit PositionCursor(std::string_view source, size_t offset = 0, SourcePosition position = {})
+        : source(source), offset(offset), position(position) {}
+
+    SourcePosition advanceTo(size_t target);
+};
+
+// 紧凑的Token序列（结构数组）：每个Token只存类型、偏移和长度共 9 字节，
+// 词素视图由源码与偏移重建，行列号首次需要时才建立行首偏移表。
+class TokenStore {
+private:
+    // kinds 的最高位是 newlineBefore 标志，低 7 位是 TokenType
+    static constexpr uint8_t kNewlineBit = 0x80;
+    static_assert(TokenType::UNKNOWN < kNewlineBit, "TokenType 须能放进 7 位");
+
+    std::string_view source;
+    std::vector<uint8_t> kinds;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> lengths;
+    // 数值字面值只占少数，解码结果另存：numberTokens 为其Token下标（递增），numbers 为对应的值
+    std::vector<uint32_t> numberTokens;
+    std::vector<NumberValue> numbers;
+
+    mutable std::once_flag linesOnce;
+    mutable LineTable lines;
+
+public:
+    explicit TokenStore(std::string_view source = {}) : source(source) {}
+    TokenStore(TokenStore&& other) noexcept;
+    TokenStore& operator=(TokenStore&& other) noexcept;
+
+    std::string_view sourceText() const { return source; }
+    size_t size() const { return kinds.size(); }
+    bool empty() const { return kinds.empty(); }
+    void reserve(size_t count);
+
+    void push(TokenType kind, size_t offset, size_t length, bool newlineBefore = false) {
+        kinds.push_back(static_cast<uint8_t>(kind | (newlineBefore ? kNewlineBit : 0)));
+        offsets.push_back(static_cast<uint32_t>(offset));
+        lengths.push_back(static_cast<uint32_t>(length));
+    }
+    // 为最后一个Token（数值字面值）记录解码结果
+    void pushNumber(NumberValue value) {
+        numberTokens.push_back(static_cast<uint32_t>(kinds.size() - 1));
+        numbers.push_back(value);
+    }
+    // 追加 other 的前 count 个Token，偏移整体加上 shift（other 扫描的是本源码从 shift 开始的子视图）
+    void append(const TokenStore& other, size_t count, size_t shift);
+
+    TokenType kind(size_t i) const { return static_cast<TokenType>(kinds[i] & ~kNewlineBit); }
+    bool newlineBefore(size_t i) const { return (kinds[i] & kNewlineBit) != 0; }
+    uint32_t offset(size_t i) const { return offsets[i]; }
+    uint32_t length(size_t i) const { return lengths[i]; }
+    std::string_view text(size_t i) const { return source.substr(offsets[i], lengths[i]); }
+    // 第 i 个Token的数值（非数值字面值返回 0）
+    NumberValue number(size_t i) const;
+
+    // 按偏移定位（二分查找行首偏移表）
+    SourcePosition position(size_t i) const { return locate(offsets[i]); }
+    SourcePosition locate(size_t offset) const;
+
+    // 物化单个Token（含行列号）
+    Token token(size_t i) const;
+    // 物化整个序列：按顺序推进位置，不建行首偏移表
+    std::vector<Token> toTokens() const { return toTokens(PositionCursor(source)); }
+    // 同上，位置从 cursor 继续推进（用于从某个行首开始的局部扫描结果）
+    std::vector<Token> toTokens(PositionCursor cursor) const;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// UTF-8 解码与按码点分类
+// 词法分析的热路径逐字符调用，解码结果直接放在寄存器里返回，不构造字符串。
+namespace utf8 {
+
+// 后续字节不合法时的码点（不与任何合法码点冲突）
+constexpr char32_t kInvalid = 0xFFFFFFFFu;
+
+// 全角美元符号 ＄（中文变量前缀）
+constexpr char32_t kFullWidthDollar = 0xFF04;
+
+// 中文双引号 “ ”（本地化模式下与 ASCII 双引号同为字符串定界符），UTF-8 编码均为 3 字节
+constexpr char32_t kLeftDoubleQuote = 0x201C;
+constexpr char32_t kRightDoubleQuote = 0x201D;
+
+struct DecodedChar {
+    char32_t cp;   // 码点；非法序列为 kInvalid
+    uint8_t len;   // 按首字节确定的字节数；剩余字节不足时为 0
+};
+
+// 按首字节判断序列长度，非法首字节（孤立的后续字节、0xF8 以上）当作单字节
+constexpr uint8_t sequenceLength(unsigned char lead) {
+    if (lead < 0x80) return 1;            // ASCII
+    if ((lead & 0xE0) == 0xC0) return 2;  // 110xxxxx
+    if ((lead & 0xF0) == 0xE0) return 3;  // 1110xxxx
+    if ((lead & 0xF8) == 0xF0) return 4;  // 11110xxx
+    return 1;
+}
+
+// 解码 p 开头的一个字符（n 为剩余字节数）
+inline DecodedChar decode(const char* p, size_t n) {
+    if (n == 0) return {kInvalid, 0};
+    const unsigned char lead = static_cast<unsigned char>(p[0]);
+    if (lead < 0x80) return {lead, 1};
+
+    const uint8_t len = sequenceLength(lead);
+    if (len == 1) return {kInvalid, 1};
+    if (n < len) return {kInvalid, 0};
+
+    char32_t cp = lead & (0x7Fu >> len);
+    for (uint8_t i = 1; i < len; ++i) {
+        const unsigned char b = static_cast<unsigned char>(p[i]);
+        if ((b & 0xC0) != 0x80) return {kInvalid, len};
+        cp = (cp << 6) | (b & 0x3Fu);
+    }
+    return {cp, len};
+}
+
+// 解码已校验过的 UTF-8（见 SourceBuffer::validate）：序列必定完整合法，只需判断剩余字节是否为 0
+inline DecodedChar decodeUnchecked(const char* p, size_t n) {
+    if (n == 0) return {kInvalid, 0};
+    const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+    if (b[0] < 0x80) return {b[0], 1};
+    if (b[0] < 0xE0) return {(char32_t(b[0] & 0x1F) << 6) | (b[1] & 0x3Fu), 2};
+    if (b[0] < 0xF0) return {(char32_t(b[0] & 0x0F) << 12) | (char32_t(b[1] & 0x3F) << 6) | (b[2] & 0x3Fu), 3};
+    return {(char32_t(b[0] & 0x07) << 18) | (char32_t(b[1] & 0x3F) << 12) | (char32_t(b[2] & 0x3F) << 6) |
+                (b[3] & 0x3Fu),
+            4};
+}
+
+// 去掉开头的 UTF-8 BOM（EF BB BF）；BOM 只是编码标记，不属于源码内容
+inline std::string_view stripBom(std::string_view text) {
+    if (text.size() >= 3 && text.compare(0, 3, "\xEF\xBB\xBF") == 0) text.remove_prefix(3);
+    return text;
+}
+
+// 中文字符：U+4000–U+9FFF（即首字节 0xE4–0xE9 的三字节序列，覆盖 CJK 统一汉字）
+constexpr bool isChinese(char32_t cp) {
+    return cp >= 0x4000 && cp <= 0x9FFF;
+}
+
+// 全角符号：全角 ASCII 与半角片假名区 U+FF00–U+FFFF，以及 CJK 标点 U+3000–U+303F
+constexpr bool isFullWidthSymbol(char32_t cp) {
+    return (cp >= 0xFF00 && cp <= 0xFFFF) || (cp >= 0x3000 && cp <= 0x303F);
+}
+
+constexpr bool isCurlyDoubleQuote(char32_t cp) {
+    return cp == kLeftDoubleQuote || cp == kRightDoubleQuote;
+}
+
+// p 开头是否为中文双引号（E2 80 9C / E2 80 9D）
+inline bool startsWithCurlyDoubleQuote(const char* p, size_t n) {
+    return n >= 3 && static_cast<unsigned char>(p[0]) == 0xE2 && static_cast<unsigned char>(p[1]) == 0x80 &&
+           (static_cast<unsigned char>(p[2]) == 0x9C || static_cast<unsigned char>(p[2]) == 0x9D);
+}
+
+} // namespace utf8
@@ -0,0 +1,264 @@
+// AST 表示的基准测试：对比指针树（arena 中的节点）与扁平 AST（按种类连续存放）的内存占用、
+// 转换耗时，以及遍历全部节点的耗时；另测改动一个函数后增量重解析（Parser::reparse）与完整解析的耗时
+// 用法: polyglot_ast_bench [函数个数=20000] [重复次数=5] [--json] [--seed=<种子>]
+// 词法基准的语料只为扫描设计，这里另行生成能通过语法分析的程序（每个函数若干声明、运算与调用）。
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ast.h"
+#include "corpus.h"
+#include "flat_ast.h"
+#include "lexer.h"
+#include "parser.h"
+
+struct Measurement {
+    std::string mode;
+    double seconds = 0;  // 最快一轮的耗时
+    uint64_t checksum = 0;
+};
+
+// 重复 repeats 轮取最快；run 返回校验值（防止遍历被优化掉，两种表示的结果须相同）
+static Measurement measure(std::string mode, int repeats, const std::function<uint64_t()>& run) {
+    Measurement m;
+    m.mode = std::move(mode);
+    m.seconds = 1e100;
+    for (int r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t checksum = run();
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (seconds < m.seconds) {
+            m.seconds = seconds;
+            m.checksum = checksum;
+        }
+    }
+    return m;
+}
+
+static std::string generateProgram(size_t functions, uint64_t seed) {
+    corpus_detail::Random random{seed};
+    static const char* const kOperators[] = {" + ", " - ", " * ", " == ", " < "};
+    std::string out;
+    for (size_t f = 0; f < functions; ++f) {
+        out += "compute_" + std::to_string(f) + "(a: i32, b: i32) {\n";
+        const size_t statements = 8 + random.below(16);
+        for (size_t i = 0; i < statements; ++i) {
+            const std::string name = "v" + std::to_string(i);
+            switch (random.below(4)) {
+                case 0:
+                    out += "    " + name + ": i32 = " + std::to_string(random.below(100000)) + "\n";
+                    break;
+                case 1:
+                    out += "    " + name + ": string = \"value " + std::to_string(random.below(1000)) + "\"\n";
+                    break;
+                case 2:
+                    out += "    print(a, -b, " + std::to_string(random.below(100)) + ")\n";
+                    break;
+                default: {
+                    out += "    " + name + " := a";
+                    for (size_t n = 1 + random.below(5); n-- > 0;) {
+                        out += kOperators[random.below(5)];
+                        out += random.below(2) ? "(b + " + std::to_string(random.below(1000)) + ")" : "a";
+                    }
+                    out += "\n";
+                }
+            }
+        }
+        out += "    <- a\n}\n\n";
+    }
+    return out;
+}
+
+// 指针树遍历：访问每个节点一次，累计节点数与整数字面值
+static void walkTree(ASTNode* node, uint64_t& sum) {
+    if (!node) return;
+    ++sum;
+    ::visit(node, [&sum](auto* n) {
+        using T = std::remove_pointer_t<decltype(n)>;
+        if constexpr (std::is_same_v<T, Program> || std::is_same_v<T, Block>) {
+            for (ASTNode* stmt : n->statements) walkTree(stmt, sum);
+        } else if constexpr (std::is_same_v<T, FunctionDecl>) {
+            for (ASTNode* param : n->parameters) walkTree(param, sum);
+            walkTree(n->body, sum);
+        } else if constexpr (std::is_same_v<T, StructDecl>) {
+            for (ASTNode* field : n->fields) walkTree(field, sum);
+        } else if constexpr (std::is_same_v<T, ImplBlock>) {
+            for (ASTNode* method : n->methods) walkTree(method, sum);
+        } else if constexpr (std::is_same_v<T, VariableDecl>) {
+            walkTree(n->initializer, sum);
+        } else if constexpr (std::is_same_v<T, ReturnStmt>) {
+            walkTree(n->value, sum);
+        } else if constexpr (std::is_same_v<T, ExpressionStmt>) {
+            walkTree(n->expression, sum);
+        } else if constexpr (std::is_same_v<T, Literal>) {
+            sum += static_cast<uint64_t>(n->intValue);
+        } else if constexpr (std::is_same_v<T, BinaryOp>) {
+            walkTree(n->left, sum);
+            walkTree(n->right, sum);
+        } else if constexpr (std::is_same_v<T, UnaryOp>) {
+            walkTree(n->operand, sum);
+        } else if constexpr (std::is_same_v<T, FunctionCall>) {
+            for (ASTNode* arg : n->arguments) walkTree(arg, sum);
+        }
+    });
+}
+
+// 扁平 AST 遍历：与 walkTree 访问同样的节点（TypeNode 已折叠，Program 不是节点，二者都不计数）
+static void walkFlat(const flat_ast::Ast& ast, flat_ast::Ref ref, uint64_t& sum) {
+    if (!ref) return;
+    ++sum;
+    ast.visit(ref, [&](const auto& n) {
+        using T = std::decay_t<decltype(n)>;
+        if constexpr (std::is_same_v<T, flat_ast::Block>) {
+            for (flat_ast::Ref stmt : ast.list(n.statements)) walkFlat(ast, stmt, sum);
+        } else if constexpr (std::is_same_v<T, flat_ast::FunctionDecl>) {
+            for (flat_ast::Ref param : ast.list(n.parameters)) walkFlat(ast, param, sum);
+            walkFlat(ast, n.body, sum);
+        } else if constexpr (std::is_same_v<T, flat_ast::StructDecl>) {
+            for (flat_ast::Ref field : ast.list(n.fields)) walkFlat(ast, field, sum);
+        } else if constexpr (std::is_same_v<T, flat_ast::ImplBlock>) {
+            for (flat_ast::Ref method : ast.list(n.methods)) walkFlat(ast, method, sum);
+        } else if constexpr (std::is_same_v<T, flat_ast::VariableDecl>) {
+            walkFlat(ast, n.initializer, sum);
+        } else if constexpr (std::is_same_v<T, flat_ast::ReturnStmt>) {
+            walkFlat(ast, n.value, sum);
+        } else if constexpr (std::is_same_v<T, flat_ast::ExpressionStmt>) {
+            walkFlat(ast, n.expression, sum);
+        } else if constexpr (std::is_same_v<T, flat_ast::Literal>) {
+            if (n.type != flat_ast::LiteralType::Float) sum += static_cast<uint64_t>(n.intValue);
+        } else if constexpr (std::is_same_v<T, flat_ast::BinaryOp>) {
+            walkFlat(ast, n.left, sum);
+            walkFlat(ast, n.right, sum);
+        } else if constexpr (std::is_same_v<T, flat_ast::UnaryOp>) {
+            walkFlat(ast, n.operand, sum);
+        } else if constexpr (std::is_same_v<T, flat_ast::FunctionCall>) {
+            for (flat_ast::Ref arg : ast.list(n.arguments)) walkFlat(ast, arg, sum);
+        }
+    });
+}
+
+int main(int argc, char* argv[]) {
+    size_t functions = 20000;
+    int repeats = 5;
+    bool json = false;
+    uint64_t seed = 1;
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            json = true;
+        } else if (arg.rfind("--seed=", 0) == 0) {
+            seed = std::strtoull(arg.c_str() + 7, nullptr, 10);
+        } else if (positional == 0) {
+            functions = static_cast<size_t>(std::atoi(arg.c_str()));
+            ++positional;
+        } else if (positional == 1) {
+            repeats = std::atoi(arg.c_str());
+            ++positional;
+        } else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (functions == 0) functions = 1;
+    if (repeats <= 0) repeats = 1;
+
+    const std::string source = generateProgram(functions, seed);
+    SourceBuffer buffer(source);
+    Lexer lexer(buffer);
+    lexer.setFoldNewlines(true);
+    const TokenStore tokens = lexer.scan();
+
+    // 编辑后的版本：中间那个函数的开头多一条语句
+    std::string editedSource = source;
+    const size_t editedFunction = editedSource.find("compute_" + std::to_string(functions / 2) + "(");
+    editedSource.insert(editedSource.find("{\n", editedFunction) + 2, "    extra := a\n");
+    SourceBuffer editedBuffer(editedSource);
+    Lexer editedLexer(editedBuffer);
+    editedLexer.setFoldNewlines(true);
+    const TokenStore editedTokens = editedLexer.scan();
+
+    // 语法分析逐条打印日志，计时与输出期间都不需要
+    std::ostringstream discarded;
+    std::streambuf* console = std::cout.rdbuf(discarded.rdbuf());
+    std::unique_ptr<Program> program = Parser(tokens).parse();
+    std::cout.rdbuf(console);
+
+    flat_ast::Ast flat;
+    const Measurement lower = measure("lower", repeats, [&] {
+        flat = flat_ast::Ast::fromProgram(*program);
+        return static_cast<uint64_t>(flat.nodeCount());
+    });
+    const Measurement tree = measure("walk-tree", repeats, [&] {
+        uint64_t sum = 0;
+        for (ASTNode* stmt : program->statements) walkTree(stmt, sum);
+        return sum;
+    });
+    const Measurement flatWalk = measure("walk-flat", repeats, [&] {
+        uint64_t sum = 0;
+        for (flat_ast::Ref stmt : flat.statements()) walkFlat(flat, stmt, sum);
+        return sum;
+    });
+    if (tree.checksum != flatWalk.checksum) {
+        std::cerr << "两种表示的遍历结果不一致: " << tree.checksum << " != " << flatWalk.checksum << std::endl;
+        return 1;
+    }
+
+    // 增量重解析每轮都要一个新的旧 Program（reparse 会接管它），只计 reparse 本身的耗时
+    std::cout.rdbuf(discarded.rdbuf());
+    const Measurement fullParse = measure("parse", repeats, [&] {
+        return static_cast<uint64_t>(Parser(editedTokens).parse()->statements.size());
+    });
+    Measurement reparse;
+    reparse.mode = "reparse";
+    reparse.seconds = 1e100;
+    size_t reused = 0;
+    for (int r = 0; r < repeats; ++r) {
+        std::unique_ptr<Program> previous = Parser(tokens).parse();
+        auto start = std::chrono::steady_clock::now();
+        Parser::Reparse result = Parser(editedTokens).reparse(std::move(previous), tokens);
+        auto end = std::chrono::steady_clock::now();
+        reparse.seconds = std::min(reparse.seconds, std::chrono::duration<double>(end - start).count());
+        reparse.checksum = result.program->statements.size();
+        reused = result.reused;
+    }
+    std::cout.rdbuf(console);
+    if (reparse.checksum != fullParse.checksum || reused + 1 != functions) {
+        std::cerr << "增量重解析的结果与完整解析不一致: " << reparse.checksum << " 个顶层项，复用 " << reused
+                  << " 个" << std::endl;
+        return 1;
+    }
+
+    const size_t treeBytes = program->arena.bytesUsed();
+    const size_t flatBytes = flat.bytesUsed();
+    if (json) {
+        std::cout << "{\n  \"source_bytes\": " << buffer.size() << ",\n  \"functions\": " << functions
+                  << ",\n  \"repeats\": " << repeats << ",\n  \"nodes\": " << flat.nodeCount()
+                  << ",\n  \"tree_bytes\": " << treeBytes << ",\n  \"flat_bytes\": " << flatBytes
+                  << ",\n  \"results\": [";
+        const Measurement* results[] = {&lower, &tree, &flatWalk, &fullParse, &reparse};
+        for (size_t i = 0; i < 5; ++i) {
+            std::cout << (i ? "," : "") << "\n    {\"mode\": \"" << results[i]->mode
+                      << "\", \"seconds\": " << results[i]->seconds << "}";
+        }
+        std::cout << "\n  ]\n}" << std::endl;
+    } else {
+        const double mb = 1024.0 * 1024.0;
+        std::printf("源码 %.1f MB，%zu 个函数，扁平 AST %zu 个节点\n", buffer.size() / mb, functions, flat.nodeCount());
+        std::printf("  内存: 指针树 arena %.1f MB，扁平 AST %.1f MB（%.2fx）\n", treeBytes / mb, flatBytes / mb,
+                    static_cast<double>(treeBytes) / flatBytes);
+        std::printf("  转换为扁平 AST: %.2f ms\n", lower.seconds * 1e3);
+        std::printf("  遍历全部节点: 指针树 %.2f ms，扁平 AST %.2f ms（%.2fx）\n", tree.seconds * 1e3,
+                    flatWalk.seconds * 1e3, tree.seconds / flatWalk.seconds);
+        std::printf("  改动一个函数后: 完整解析 %.2f ms，增量重解析 %.2f ms（%.1fx，复用 %zu 个函数）\n",
+                    fullParse.seconds * 1e3, reparse.seconds * 1e3, fullParse.seconds / reparse.seconds, reused);
+    }
+    return 0;
+}
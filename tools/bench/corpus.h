@@ -0,0 +1,125 @@
+#pragma once
+
+// 词法分析基准测试的合成语料生成器（lexer_bench 与 corpus_gen 共用）
+// 同样的参数总是生成逐字节相同的语料：随机数只用固定算法的 splitmix64，不依赖标准库分布的实现。
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct CorpusOptions {
+    size_t targetBytes = 16 * 1024 * 1024;
+    bool fullWidth = false;          // false: ASCII 语法（.pg）；true: 全角符号与中文标识符（.文达，本地化模式）
+    // 每行语句的种类按权重抽取：标识符运算、注释、字符串；余下的权重（至少 0.1）为纯数值语句
+    double identifierDensity = 0.4;
+    double commentDensity = 0.3;
+    double stringDensity = 0.3;
+    uint64_t seed = 1;
+};
+
+namespace corpus_detail {
+
+struct Random {
+    uint64_t state;
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    size_t below(size_t n) { return static_cast<size_t>(next() % n); }
+    double unit() { return static_cast<double>(next() >> 11) / 9007199254740992.0; }
+};
+
+inline const char* const kAsciiWords[] = {
+    "count", "total", "index", "buffer", "offset", "value", "result", "length", "node", "item",
+    "left", "right", "cursor", "limit", "state", "token", "scale", "width", "height", "depth",
+};
+inline const char* const kChineseWords[] = {
+    "计数", "总和", "下标", "缓冲", "偏移", "数值", "结果", "长度", "节点", "条目",
+    "左边", "右边", "游标", "上限", "状态", "记号", "比例", "宽度", "高度", "深度",
+};
+inline const char* const kAsciiOperators[] = {" + ", " - ", " * ", " / ", " == ", " >= ", " && "};
+inline const char* const kFullWidthOperators[] = {" + ", " - ", " * ", " / ", " == ", " 》= ", " && "};
+inline const char* const kSentences[] = {
+    "The quick brown fox jumps over the lazy dog",
+    "Lorem ipsum dolor sit amet, consectetur adipiscing elit",
+    "数据表字段说明：保存用户的显示名称",
+    "sed do eiusmod tempor incididunt ut labore et dolore",
+};
+
+inline std::string name(Random& random, bool fullWidth) {
+    const char* word = fullWidth ? kChineseWords[random.below(20)] : kAsciiWords[random.below(20)];
+    return word + std::to_string(random.below(100));
+}
+
+inline std::string expression(Random& random, bool fullWidth) {
+    std::string text = name(random, fullWidth);
+    const size_t terms = 1 + random.below(4);
+    for (size_t i = 0; i < terms; ++i) {
+        text += fullWidth ? kFullWidthOperators[random.below(7)] : kAsciiOperators[random.below(7)];
+        if (random.below(3) == 0) {
+            text += std::to_string(random.below(100000));
+        } else if (fullWidth && random.below(4) == 0) {
+            text += "（" + name(random, true) + " + 1）";
+        } else if (!fullWidth && random.below(4) == 0) {
+            text += "(" + name(random, false) + " + 1)";
+        } else {
+            text += name(random, fullWidth);
+        }
+    }
+    return text;
+}
+
+inline void statement(std::string& out, Random& random, const CorpusOptions& options) {
+    const bool fw = options.fullWidth;
+    const double numeric = 0.1;
+    const double total = options.identifierDensity + options.commentDensity + options.stringDensity + numeric;
+    double pick = random.unit() * total;
+    out += "    ";
+    if ((pick -= options.identifierDensity) < 0) {
+        out += name(random, fw) + (fw ? "：= " : " := ") + expression(random, fw) + "\n";
+    } else if ((pick -= options.commentDensity) < 0) {
+        if (random.below(4) == 0) {
+            out += "/* ";
+            out += kSentences[random.below(4)];
+            out += "\n     * ";
+            out += kSentences[random.below(4)];
+            out += " */\n";
+        } else {
+            out += "// ";
+            out += kSentences[random.below(4)];
+            out += "\n";
+        }
+    } else if ((pick -= options.stringDensity) < 0) {
+        const char* open = fw ? "“" : "\"";
+        const char* close = fw ? "”" : "\"";
+        out += name(random, fw) + (fw ? "：字符串 = " : ": string = ") + open + kSentences[random.below(4)] +
+               " \\t " + std::to_string(random.below(1000)) + close + "\n";
+    } else {
+        out += name(random, fw) + (fw ? "：整数 = " : ": i32 = ") + std::to_string(random.below(1000000)) + "\n";
+    }
+}
+
+} // namespace corpus_detail
+
+// 生成不小于 targetBytes 的语料（以完整的函数块结尾）
+inline std::string generateCorpus(const CorpusOptions& options) {
+    corpus_detail::Random random{options.seed};
+    std::string corpus;
+    corpus.reserve(options.targetBytes + 4096);
+    const bool fw = options.fullWidth;
+    for (size_t block = 0; corpus.size() < options.targetBytes; ++block) {
+        if (fw) {
+            corpus += "计算" + std::to_string(block) + "（甲：整数，乙：整数）-》整数 {\n";
+        } else {
+            corpus += "compute_" + std::to_string(block) + "(a: i32, b: i32) -> i32 {\n";
+        }
+        const size_t statements = 8 + random.below(16);
+        for (size_t i = 0; i < statements; ++i) {
+            corpus_detail::statement(corpus, random, options);
+        }
+        corpus += fw ? "    《- 甲\n}\n\n" : "    <- a\n}\n\n";
+    }
+    return corpus;
+}
@@ -0,0 +1,67 @@
+// 生成词法分析基准测试用的合成语料文件（内容由参数完全确定，可用于跨版本对比）
+// 用法: polyglot_corpus_gen <输出目录> [--sizes=1,10,100] [--identifiers=<权重>] [--comments=<权重>]
+//                           [--strings=<权重>] [--seed=<种子>]
+// 每个大小生成 corpus_<N>mb.pg（ASCII 语法）与 corpus_<N>mb.文达（全角符号与中文标识符）两个文件，
+// 之后可用 polyglot_lexer_bench --file=<路径> 测试。
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "corpus.h"
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: polyglot_corpus_gen <输出目录> [--sizes=1,10,100] [--identifiers=<权重>] "
+                     "[--comments=<权重>] [--strings=<权重>] [--seed=<种子>]"
+                  << std::endl;
+        return 1;
+    }
+    std::filesystem::path outputDir = std::filesystem::u8path(argv[1]);
+    std::vector<size_t> sizes = {1, 10, 100};
+    CorpusOptions options;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](const char* prefix) { return arg.substr(std::string(prefix).size()); };
+        if (arg.rfind("--sizes=", 0) == 0) {
+            sizes.clear();
+            std::stringstream list(value("--sizes="));
+            for (std::string item; std::getline(list, item, ',');) {
+                if (!item.empty()) sizes.push_back(static_cast<size_t>(std::atoi(item.c_str())));
+            }
+        } else if (arg.rfind("--identifiers=", 0) == 0) {
+            options.identifierDensity = std::atof(value("--identifiers=").c_str());
+        } else if (arg.rfind("--comments=", 0) == 0) {
+            options.commentDensity = std::atof(value("--comments=").c_str());
+        } else if (arg.rfind("--strings=", 0) == 0) {
+            options.stringDensity = std::atof(value("--strings=").c_str());
+        } else if (arg.rfind("--seed=", 0) == 0) {
+            options.seed = std::strtoull(value("--seed=").c_str(), nullptr, 10);
+        } else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    std::filesystem::create_directories(outputDir);
+    for (size_t megabytes : sizes) {
+        options.targetBytes = megabytes * 1024 * 1024;
+        for (bool fullWidth : {false, true}) {
+            options.fullWidth = fullWidth;
+            std::string name = "corpus_" + std::to_string(megabytes) + "mb" + (fullWidth ? ".文达" : ".pg");
+            std::filesystem::path path = outputDir / std::filesystem::u8path(name);
+            std::ofstream out(path, std::ios::binary);
+            std::string corpus = generateCorpus(options);
+            out.write(corpus.data(), static_cast<std::streamsize>(corpus.size()));
+            if (!out) {
+                std::cerr << "写入失败: " << path.u8string() << std::endl;
+                return 1;
+            }
+            std::cout << path.u8string() << " (" << corpus.size() << " 字节)" << std::endl;
+        }
+    }
+    return 0;
+}
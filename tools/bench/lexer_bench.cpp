@@ -0,0 +1,273 @@
+// 词法分析器基准测试：对比标量实现与 SIMD 批量扫描、多线程扫描的吞吐量，并覆盖全角符号密集的语料
+// 用法: polyglot_lexer_bench [语料MB数=16] [重复次数=5] [选项]
+//   --json               以 JSON 输出结果（便于跨版本跟踪回归）
+//   --identifiers=<权重> --comments=<权重> --strings=<权重> --seed=<种子>   合成语料的参数（见 corpus.h）
+//   --file=<路径>        改为测试给定文件（可重复；.文达 文件按本地化模式扫描），不再生成语料
+// 每项结果给出 MB/s、tokens/s 与每个 Token 的堆分配次数。
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "corpus.h"
+#include "lexer.h"
+#include "lexer_simd.h"
+#include "source_file.h"
+
+// 统计堆分配次数：替换全局 operator new（数组形式与 nothrow 形式默认转发到这里）
+static std::atomic<size_t> gAllocations{0};
+
+void* operator new(std::size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+struct Measurement {
+    std::string mode;
+    double seconds = 0;      // 最快一轮的耗时
+    size_t tokens = 0;
+    size_t allocations = 0;  // 最快一轮的堆分配次数
+};
+
+struct CorpusReport {
+    std::string name;
+    size_t bytes = 0;
+    std::vector<Measurement> results;
+};
+
+// 重复 repeats 轮取最快；run 返回Token数
+static Measurement measure(std::string mode, int repeats, const std::function<size_t()>& run) {
+    Measurement m;
+    m.mode = std::move(mode);
+    m.seconds = 1e100;
+    for (int r = 0; r < repeats; ++r) {
+        size_t allocationsBefore = gAllocations.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+        size_t tokens = run();
+        auto end = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        if (seconds < m.seconds) {
+            m.seconds = seconds;
+            m.tokens = tokens;
+            m.allocations = gAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+        }
+    }
+    return m;
+}
+
+// 只扫描到紧凑的 TokenStore
+static size_t run_scan(const SourceBuffer& buffer, bool foldNewlines = false) {
+    Lexer lexer(buffer);
+    lexer.setFoldNewlines(foldNewlines);
+    return lexer.scan().size();
+}
+
+// 扫描并物化为带行列号的 Token 列表
+static size_t run_tokenize(const SourceBuffer& buffer) {
+    Lexer lexer(buffer);
+    return lexer.tokenize().size();
+}
+
+// 多线程扫描
+static size_t run_parallel(const SourceBuffer& buffer, unsigned threads) {
+    Lexer lexer(buffer);
+    return lexer.scanParallel(threads).size();
+}
+
+// 拉取模式：逐个 next()，不物化Token序列
+static size_t run_stream(const SourceBuffer& buffer) {
+    Lexer lexer(buffer);
+    size_t count = 1;
+    while (lexer.next().type != TokenType::EOF_TOKEN) ++count;
+    return count;
+}
+
+static void print_measurement(const CorpusReport& report, const Measurement& m, const std::string& extra = "") {
+    const double mb = static_cast<double>(report.bytes) / (1024.0 * 1024.0);
+    std::cout << "  " << m.mode << ": " << (mb / m.seconds) << " MB/s"
+              << ", " << (static_cast<double>(m.tokens) / m.seconds / 1e6) << " M tokens/s"
+              << ", " << m.tokens << " tokens"
+              << ", 分配/Token " << (m.tokens ? static_cast<double>(m.allocations) / m.tokens : 0.0) << extra
+              << std::endl;
+}
+
+static CorpusReport run_corpus(const std::string& name, SourceBuffer& buffer, int repeats, bool quiet) {
+    CorpusReport report;
+    report.name = name;
+    report.bytes = buffer.size();
+    auto record = [&](Measurement m, const std::string& extra = "") {
+        if (!quiet) print_measurement(report, m, extra);
+        report.results.push_back(std::move(m));
+    };
+    if (!quiet) {
+        std::cout << "[" << name << "] 语料大小: " << (report.bytes / (1024.0 * 1024.0)) << " MB, 重复 " << repeats
+                  << " 次取最快" << std::endl;
+    }
+
+    const lexer_simd::Level best = lexer_simd::activeLevel();
+    const std::string bestName = lexer_simd::levelName(best);
+    std::vector<lexer_simd::Level> levels = {lexer_simd::Level::Scalar};
+    if (best >= lexer_simd::Level::SSE2) levels.push_back(lexer_simd::Level::SSE2);
+    if (best >= lexer_simd::Level::AVX2) levels.push_back(lexer_simd::Level::AVX2);
+
+    double scalarSeconds = 0;
+    for (auto level : levels) {
+        lexer_simd::forceLevel(level);
+        Measurement m = measure(std::string("scan/") + lexer_simd::levelName(level), repeats,
+                                [&] { return run_scan(buffer); });
+        if (level == lexer_simd::Level::Scalar) scalarSeconds = m.seconds;
+        record(m, ", 加速比 " + std::to_string(scalarSeconds / m.seconds) + "x");
+    }
+    lexer_simd::forceLevel(best);
+
+    record(measure("scan-fold/" + bestName, repeats, [&] { return run_scan(buffer, true); }));
+
+    Measurement tokenized = measure("tokenize/" + bestName, repeats, [&] { return run_tokenize(buffer); });
+    record(tokenized, ", Token 列表 " + std::to_string(tokenized.tokens * sizeof(Token) / (1024.0 * 1024.0)) +
+                          " MB，紧凑存储 " + std::to_string(tokenized.tokens * 9 / (1024.0 * 1024.0)) + " MB");
+
+    double singleSeconds = 0;
+    for (unsigned threads : {1u, 2u, 4u, 8u}) {
+        Measurement m = measure("parallel-" + std::to_string(threads) + "/" + bestName, repeats,
+                                [&] { return run_parallel(buffer, threads); });
+        if (threads == 1) singleSeconds = m.seconds;
+        record(m, ", 加速比 " + std::to_string(singleSeconds / m.seconds) + "x");
+    }
+
+    record(measure("stream/" + bestName, repeats, [&] { return run_stream(buffer); }));
+
+    // 以上均未校验编码（词法分析逐字符检查）；校验之后改走免检解码或纯 ASCII 路径
+    bool ascii = false;
+    lexer_simd::forceLevel(lexer_simd::Level::Scalar);
+    Measurement scalarValidate = measure("validate-utf8/scalar", repeats, [&] {
+        lexer_simd::validateUtf8(buffer.data(), buffer.size());
+        return size_t{0};
+    });
+    lexer_simd::forceLevel(best);
+    Measurement validate = measure("validate-utf8/" + bestName, repeats, [&] {
+        ascii = lexer_simd::validateUtf8(buffer.data(), buffer.size()).ascii;
+        return size_t{0};
+    });
+    record(validate, ", 加速比 " + std::to_string(scalarValidate.seconds / validate.seconds) + "x" +
+                         (ascii ? ", 纯 ASCII" : ", 含多字节字符"));
+    buffer.validate();
+    record(measure("scan-validated/" + bestName, repeats, [&] { return run_scan(buffer); }));
+    return report;
+}
+
+static void json_string(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+static void print_json(const std::vector<CorpusReport>& reports, int repeats) {
+    std::cout << "{\n  \"simd\": ";
+    json_string(std::cout, lexer_simd::levelName(lexer_simd::activeLevel()));
+    std::cout << ",\n  \"repeats\": " << repeats << ",\n  \"corpora\": [";
+    for (size_t i = 0; i < reports.size(); ++i) {
+        const CorpusReport& report = reports[i];
+        const double mb = static_cast<double>(report.bytes) / (1024.0 * 1024.0);
+        std::cout << (i ? "," : "") << "\n    {\n      \"name\": ";
+        json_string(std::cout, report.name);
+        std::cout << ",\n      \"bytes\": " << report.bytes << ",\n      \"results\": [";
+        for (size_t j = 0; j < report.results.size(); ++j) {
+            const Measurement& m = report.results[j];
+            std::cout << (j ? "," : "") << "\n        {\"mode\": ";
+            json_string(std::cout, m.mode);
+            std::cout << ", \"seconds\": " << m.seconds << ", \"mb_per_s\": " << (mb / m.seconds)
+                      << ", \"tokens\": " << m.tokens
+                      << ", \"tokens_per_s\": " << (static_cast<double>(m.tokens) / m.seconds)
+                      << ", \"allocations\": " << m.allocations << ", \"allocations_per_token\": "
+                      << (m.tokens ? static_cast<double>(m.allocations) / m.tokens : 0.0) << "}";
+        }
+        std::cout << "\n      ]\n    }";
+    }
+    std::cout << "\n  ]\n}" << std::endl;
+}
+
+static bool ends_with(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    size_t megabytes = 16;
+    int repeats = 5;
+    bool json = false;
+    CorpusOptions options;
+    std::vector<std::string> files;
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&](const char* prefix) { return arg.substr(std::string(prefix).size()); };
+        if (arg == "--json") {
+            json = true;
+        } else if (arg.rfind("--identifiers=", 0) == 0) {
+            options.identifierDensity = std::atof(value("--identifiers=").c_str());
+        } else if (arg.rfind("--comments=", 0) == 0) {
+            options.commentDensity = std::atof(value("--comments=").c_str());
+        } else if (arg.rfind("--strings=", 0) == 0) {
+            options.stringDensity = std::atof(value("--strings=").c_str());
+        } else if (arg.rfind("--seed=", 0) == 0) {
+            options.seed = std::strtoull(value("--seed=").c_str(), nullptr, 10);
+        } else if (arg.rfind("--file=", 0) == 0) {
+            files.push_back(value("--file="));
+        } else if (positional == 0) {
+            megabytes = static_cast<size_t>(std::atoi(arg.c_str()));
+            ++positional;
+        } else if (positional == 1) {
+            repeats = std::atoi(arg.c_str());
+            ++positional;
+        } else {
+            std::cerr << "未知参数: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (megabytes == 0) megabytes = 1;
+    if (repeats <= 0) repeats = 1;
+
+    std::vector<CorpusReport> reports;
+    auto run = [&](const std::string& name, SourceBuffer& buffer, bool localized) {
+        if (localized) Lexer::UseBuiltinLocalizedSymbols();
+        reports.push_back(run_corpus(name, buffer, repeats, json));
+        if (localized) Lexer::ClearOverride();
+    };
+
+    if (!files.empty()) {
+        for (const std::string& path : files) {
+            SourceBuffer buffer(SourceFile::open(path));
+            run(path, buffer, ends_with(path, ".文达"));
+        }
+    } else {
+        options.targetBytes = megabytes * 1024 * 1024;
+        options.fullWidth = false;
+        SourceBuffer ascii(generateCorpus(options));
+        run("ASCII .pg", ascii, false);
+
+        options.fullWidth = true;
+        SourceBuffer fullwidth(generateCorpus(options));
+        run("全角 .文达", fullwidth, true);
+    }
+
+    if (json) print_json(reports, repeats);
+    return 0;
+}
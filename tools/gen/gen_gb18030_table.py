@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+# 根据 Python 标准库的 gb18030 编解码器生成 GB18030 → Unicode 转码表
+#
+# 用法: gen_gb18030_table.py <输出头文件>
+#
+# 生成两张表：
+#   kTwoByte          双字节区（首字节 0x81–0xFE，尾字节 0x40–0x7E、0x80–0xFE）逐个码位的 BMP 码点
+#   kFourByteRanges   四字节 BMP 区（81 30 81 30 – 84 31 A4 39）按线性序号分段，每段内码点连续
+# 四字节的辅助平面区（90 30 81 30 起）与码点是线性关系，不需要查表。
+
+import sys
+from pathlib import Path
+
+TRAIL_BYTES = list(range(0x40, 0x7F)) + list(range(0x80, 0xFF))
+FOUR_BYTE_BMP_COUNT = 39420  # 81 30 81 30 – 84 31 A4 39
+
+
+def four_byte(linear: int) -> bytes:
+    b4 = linear % 10
+    linear //= 10
+    b3 = linear % 126
+    linear //= 126
+    return bytes([linear // 10 + 0x81, linear % 10 + 0x30, b3 + 0x81, b4 + 0x30])
+
+
+def main():
+    if len(sys.argv) != 2:
+        raise SystemExit("用法: gen_gb18030_table.py <输出头文件>")
+
+    two_byte = []
+    for lead in range(0x81, 0xFF):
+        for trail in TRAIL_BYTES:
+            cp = ord(bytes([lead, trail]).decode("gb18030"))
+            assert cp <= 0xFFFF, "双字节区只映射到 BMP"
+            two_byte.append(cp)
+
+    ranges = []
+    for linear in range(FOUR_BYTE_BMP_COUNT):
+        cp = ord(four_byte(linear).decode("gb18030"))
+        if not ranges or cp != ranges[-1][1] + (linear - ranges[-1][0]):
+            ranges.append((linear, cp))
+
+    lines = [
+        "// 此文件由 tools/gen/gen_gb18030_table.py 在构建期生成，请勿手工修改",
+        "#pragma once",
+        "",
+        "#include <cstdint>",
+        "",
+        "namespace gb18030_tables {",
+        "",
+        "// 双字节区：下标为 (首字节 - 0x81) * 190 + 尾字节序号（0x40–0x7E 为 0–62，0x80–0xFE 为 63–189）",
+        f"inline constexpr uint16_t kTwoByte[{len(two_byte)}] = {{",
+    ]
+    for i in range(0, len(two_byte), 16):
+        lines.append("    " + ", ".join(f"0x{cp:04X}" for cp in two_byte[i:i + 16]) + ",")
+    lines.append("};")
+    lines.append("")
+    lines.append("// 四字节 BMP 区：线性序号 = (b1 - 0x81) * 12600 + (b2 - 0x30) * 1260 + (b3 - 0x81) * 10 + (b4 - 0x30)，")
+    lines.append("// 每段从 linear 开始、码点从 codepoint 开始连续递增，直到下一段")
+    lines.append("struct FourByteRange {")
+    lines.append("    uint16_t linear;")
+    lines.append("    uint16_t codepoint;")
+    lines.append("};")
+    lines.append(f"inline constexpr uint32_t kFourByteBmpCount = {FOUR_BYTE_BMP_COUNT};")
+    lines.append(f"inline constexpr FourByteRange kFourByteRanges[{len(ranges)}] = {{")
+    for i in range(0, len(ranges), 6):
+        lines.append("    " + ", ".join(f"{{{linear}, 0x{cp:04X}}}" for linear, cp in ranges[i:i + 6]) + ",")
+    lines.append("};")
+    lines.append("")
+    lines.append("} // namespace gb18030_tables")
+    content = "\n".join(lines) + "\n"
+
+    out = Path(sys.argv[1])
+    if not out.exists() or out.read_text(encoding="utf-8") != content:
+        out.parent.mkdir(parents=True, exist_ok=True)
+        out.write_text(content, encoding="utf-8")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,231 @@
+#!/usr/bin/env python3
+# 根据 symbol_mapping.json 生成词法分析器使用的 constexpr 完美哈希表
+#
+# 用法: gen_symbol_tables.py <symbol_mapping.json> <token_types.h> <输出头文件>
+#
+# 生成三张哈希表：
+#   kDefaultKeywords    英文默认模式下的关键字（类型名、布尔值、自身引用 _）
+#   kLocalizedKeywords  本地化模式下的关键字（JSON 中形如标识符的符号 + 中文关键字）
+#   kLocalizedSymbols   本地化模式下的全部符号（半角 + 全角，与 SymbolConfigLoader 的合并规则一致）
+# 以及两台按字节工作的运算符 DFA：
+#   kDefaultDfa         半角运算符
+#   kLocalizedDfa       半角运算符 + JSON 中含非 ASCII 字节的符号（》》、《-、：= 等）
+# 哈希函数必须与 compiler/symbol_tables.h 中的 hashKey 保持一致。
+
+import json
+import re
+import sys
+from pathlib import Path
+
+# 英文默认关键字（与词法分析器历史上的内置映射一致）
+DEFAULT_KEYWORDS = [
+    ("i8", "TYPE_I8"), ("i16", "TYPE_I16"), ("i32", "TYPE_I32"), ("i64", "TYPE_I64"),
+    ("f32", "TYPE_F32"), ("f64", "TYPE_F64"), ("bool", "TYPE_BOOL"),
+    ("string", "TYPE_STRING"), ("char", "TYPE_CHAR"),
+    ("true", "TRUE"), ("false", "FALSE"),
+    ("_", "SELF_REF"),
+]
+
+# 半角运算符（与词法分析器历史上的 scanSymbol 分支一致；"->" 按 CONTINUE_STMT 处理）
+ASCII_OPERATORS = [
+    (">", "GREATER_THAN"), (">>", "IMPORT"), (">=", "GREATER_EQUAL"),
+    ("<", "LESS_THAN"), ("<<", "BREAK_STMT"), ("<-", "RETURN_ARROW"), ("<=", "LESS_EQUAL"),
+    (":", "COLON"), (":=", "CONDITIONAL_ASSIGN"),
+    ("-", "MINUS"), ("->", "CONTINUE_STMT"), ("-=", "MINUS_ASSIGN"),
+    ("=", "ASSIGN"), ("==", "EQUAL"), ("!", "LOGICAL_NOT"), ("!=", "NOT_EQUAL"),
+    ("&", "IMPL_DEF"), ("&&", "LOGICAL_AND"), ("||", "LOGICAL_OR"),
+    ("+", "PLUS"), ("+=", "PLUS_ASSIGN"),
+    ("@", "STRUCT_DEF"), ("%", "INTERFACE"), ("#", "ENUM"), ("^", "LOOP"),
+    ("$", "VARIABLE_PREFIX"), ("_", "SELF_REF"), ("*", "CONSTANT"), ("?", "QUESTION"),
+    ("/", "SLASH"), ("(", "LEFT_PAREN"), (")", "RIGHT_PAREN"), ("{", "LEFT_BRACE"),
+    ("}", "RIGHT_BRACE"), ("[", "LEFT_BRACKET"), ("]", "RIGHT_BRACKET"),
+    (",", "COMMA"), (";", "SEMICOLON"), (".", "DOT"),
+]
+
+# JSON 键名与 TokenType 名称不一致的特例（其余按大写转换）
+KEY_ALIASES = {"variable_declaration": "QUESTION"}
+SYMBOL_SECTIONS = ["core_symbols", "operators", "punctuation"]
+
+MASK = 0xFFFFFFFF
+
+
+def hash_key(data: bytes, seed: int) -> int:
+    n = len(data)
+    h = (n * 0x9E3779B9) & MASK
+    if n:
+        h ^= data[0] | (data[min(1, n - 1)] << 8) | (data[n - 1] << 16) | (data[max(n - 2, 0)] << 24)
+        h = (h + data[n // 2] * 0x85EBCA6B) & MASK
+    h ^= h >> 15
+    return (h * seed) & MASK
+
+
+def token_type_names(header: Path) -> set:
+    text = header.read_text(encoding="utf-8")
+    body = text[text.index("{"):text.index("};")]
+    return set(re.findall(r"^\s*([A-Z0-9_]+)\s*,?", body, re.M))
+
+
+def is_identifier_like(word: str) -> bool:
+    return all(c.isascii() and (c.isalnum() or c == "_") or "\u4e00" <= c <= "\u9fff" for c in word)
+
+
+def build_table(name, entries):
+    keys = [k.encode("utf-8") for k, _ in entries]
+    if len(set(keys)) != len(keys):
+        raise SystemExit(f"{name}: 存在重复键")
+    bits = max(1, (len(keys) * 2 - 1).bit_length())
+    while bits <= 16:
+        seed = 0x2545F491
+        for _ in range(200000):
+            slots = {}
+            for k in keys:
+                slot = hash_key(k, seed) >> (32 - bits)
+                if slot in slots:
+                    break
+                slots[slot] = k
+            else:
+                return bits, seed, slots
+            seed = (seed * 6364136223846793005 + 1442695040888963407) & MASK | 1
+        bits += 1
+    raise SystemExit(f"{name}: 找不到无冲突的哈希种子")
+
+
+def cpp_string(data: bytes) -> str:
+    out = []
+    for b in data:
+        if 0x20 <= b < 0x7F and chr(b) not in '"\\?':
+            out.append(chr(b))
+        else:
+            out.append(f"\\{b:03o}")
+    return '"' + "".join(out) + '"'
+
+
+def emit_table(lines, name, entries):
+    bits, seed, slots = build_table(name, entries)
+    types = {k.encode("utf-8"): t for k, t in entries}
+    lines.append(f"inline constexpr SymbolEntry {name}Slots[{1 << bits}] = {{")
+    for i in range(1 << bits):
+        key = slots.get(i)
+        if key is None:
+            lines.append("    {},")
+        else:
+            lines.append(f"    {{{cpp_string(key)}, TokenType::{types[key]}}}, // {key.decode('utf-8')}")
+    lines.append("};")
+    lines.append(f"inline constexpr PerfectHashTable {name}{{{name}Slots, {bits}u, 0x{seed:08x}u, {len(entries)}u}};")
+    lines.append("")
+
+
+def build_dfa(entries):
+    """按字节构建识别有限符号集的 DFA（前缀树），再把转移列相同的字节合并为同一字节类。
+    状态 0 为死状态，状态 1 为起始状态。"""
+    trans = [[0] * 256, [0] * 256]
+    accept = ["UNKNOWN", "UNKNOWN"]
+    for text, tt in entries:
+        state = 1
+        for b in text.encode("utf-8"):
+            if trans[state][b] == 0:
+                trans.append([0] * 256)
+                accept.append("UNKNOWN")
+                trans[state][b] = len(trans) - 1
+            state = trans[state][b]
+        accept[state] = tt
+
+    columns = {}
+    byte_class = []
+    for b in range(256):
+        column = tuple(row[b] for row in trans)
+        if b == 0 or not any(column):
+            column = None  # 不出现在任何符号中的字节统一归入 0 类
+        byte_class.append(columns.setdefault(column, len(columns)))
+    if byte_class[0] != 0:
+        raise SystemExit("字节类 0 必须是死类")
+    class_count = len(columns)
+    table = [0] * (len(trans) * class_count)
+    for state, row in enumerate(trans):
+        for b in range(256):
+            table[state * class_count + byte_class[b]] = row[b]
+    return byte_class, table, accept, class_count
+
+
+def emit_dfa(lines, name, entries):
+    byte_class, table, accept, class_count = build_dfa(entries)
+    state_count = len(accept)
+    lines.append(f"// {name}: {len(entries)} 个符号, {state_count} 个状态, {class_count} 个字节类")
+    lines.append(f"inline constexpr uint8_t {name}Classes[256] = {{")
+    for i in range(0, 256, 32):
+        lines.append("    " + ", ".join(str(c) for c in byte_class[i:i + 32]) + ",")
+    lines.append("};")
+    lines.append(f"inline constexpr uint16_t {name}Next[{len(table)}] = {{")
+    for state in range(state_count):
+        row = table[state * class_count:(state + 1) * class_count]
+        lines.append("    " + ", ".join(str(x) for x in row) + ",")
+    lines.append("};")
+    lines.append(f"inline constexpr TokenType {name}Accept[{state_count}] = {{")
+    for i in range(0, state_count, 4):
+        lines.append("    " + ", ".join(f"TokenType::{a}" for a in accept[i:i + 4]) + ",")
+    lines.append("};")
+    lines.append(f"inline constexpr SymbolDfa {name}{{{name}Classes, {name}Next, {name}Accept, {class_count}u}};")
+    lines.append("")
+
+
+def main():
+    if len(sys.argv) != 4:
+        raise SystemExit(__doc__ or "用法: gen_symbol_tables.py <json> <token_types.h> <输出>")
+    mapping = json.loads(Path(sys.argv[1]).read_text(encoding="utf-8"))["symbol_mappings"]
+    valid = token_type_names(Path(sys.argv[2]))
+
+    # 符号：按 core_symbols → operators → punctuation 顺序合并，后出现的覆盖先出现的
+    symbols = {}
+    for section in SYMBOL_SECTIONS:
+        for key, variants in mapping.get(section, {}).items():
+            tt = KEY_ALIASES.get(key, key.upper())
+            if tt not in valid:
+                continue
+            for v in variants:
+                if v:
+                    symbols[v] = tt
+
+    localized_keywords = {s: t for s, t in symbols.items() if is_identifier_like(s)}
+    for word, tt in mapping.get("keywords", {}).items():
+        if tt in valid:  # BUILTIN_PRINT 等非 Token 类型由语义层处理
+            localized_keywords[word] = tt
+
+    for _, tt in DEFAULT_KEYWORDS + ASCII_OPERATORS:
+        assert tt in valid, tt
+
+    # 本地化 DFA 的半角部分沿用默认运算符，全角部分取自 JSON
+    localized_operators = dict(ASCII_OPERATORS)
+    for text, tt in symbols.items():
+        if not text.isascii():
+            localized_operators[text] = tt
+
+    lines = [
+        "// 此文件由 tools/gen/gen_symbol_tables.py 根据 symbol_mapping.json 在构建期生成，请勿手工修改",
+        "// 由 symbol_tables.h 在末尾包含，生成目录不需要能找到编译器头文件",
+        "#pragma once",
+        "",
+        "namespace symbol_tables {",
+        "",
+    ]
+    emit_table(lines, "kDefaultKeywords", DEFAULT_KEYWORDS)
+    emit_table(lines, "kLocalizedKeywords", list(localized_keywords.items()))
+    emit_table(lines, "kLocalizedSymbols", list(symbols.items()))
+    lines.append("// 半角运算符列表（运行期根据自定义映射重建 DFA 时使用）")
+    lines.append(f"inline constexpr SymbolEntry kDefaultOperators[{len(ASCII_OPERATORS)}] = {{")
+    for text, tt in ASCII_OPERATORS:
+        lines.append(f"    {{{cpp_string(text.encode('utf-8'))}, TokenType::{tt}}},")
+    lines.append("};")
+    lines.append("")
+    emit_dfa(lines, "kDefaultDfa", ASCII_OPERATORS)
+    emit_dfa(lines, "kLocalizedDfa", list(localized_operators.items()))
+    lines.append("} // namespace symbol_tables")
+    content = "\n".join(lines) + "\n"
+
+    out = Path(sys.argv[3])
+    if not out.exists() or out.read_text(encoding="utf-8") != content:
+        out.parent.mkdir(parents=True, exist_ok=True)
+        out.write_text(content, encoding="utf-8")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,192 @@
+#pragma once
+
+// 单元测试的最小框架：TEST 注册用例，CHECK/CHECK_EQ 失败时记下位置后继续执行，
+// 由 运行单元测试.cpp 统一运行（ctest 中的 unit_tests）。
+// 另外提供几个比对词法/语法结果时共用的辅助函数。
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ast.h"
+#include "error.h"
+#include "lexer.h"
+
+namespace unit_test {
+
+struct Case {
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+inline int& failureCount() {
+    static int count = 0;
+    return count;
+}
+
+struct Registrar {
+    Registrar(const char* name, void (*run)()) { registry().push_back({name, run}); }
+};
+
+inline void fail(const char* file, int line, const std::string& message) {
+    ++failureCount();
+    std::cerr << "  " << file << ":" << line << ": " << message << std::endl;
+}
+
+// Token 的完整描述（类型、位置、词素、折叠换行标志与数值），逐字段比对时用
+inline std::string describe(const Token& token) {
+    uint64_t bits = 0;
+    std::memcpy(&bits, &token.number, sizeof(bits));
+    std::ostringstream out;
+    out << static_cast<int>(token.type) << " " << token.line << ":" << token.column << " '" << token.text << "'"
+        << (token.newlineBefore ? " nl" : "") << " #" << bits;
+    return out.str();
+}
+
+inline std::string describe(const std::vector<Token>& tokens) {
+    std::string text;
+    for (const Token& token : tokens) {
+        text += describe(token);
+        text += '\n';
+    }
+    return text;
+}
+
+// 紧凑Token序列的逐字段描述（类型、换行标志、偏移、长度与数值），不经过行列号换算
+inline std::string describe(const TokenStore& tokens) {
+    std::ostringstream out;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        uint64_t bits = 0;
+        NumberValue number = tokens.number(i);
+        std::memcpy(&bits, &number, sizeof(bits));
+        out << static_cast<int>(tokens.kind(i)) << (tokens.newlineBefore(i) ? " nl " : " ") << tokens.offset(i)
+            << "+" << tokens.length(i) << " #" << bits << "\n";
+    }
+    return out.str();
+}
+
+// 运行 action，返回它抛出的 CompilerError 的完整信息（含行列号）；没有抛出时返回空串
+template <typename Action>
+std::string errorOf(Action&& action) {
+    try {
+        action();
+    } catch (const CompilerError& e) {
+        return e.getFullMessage();
+    }
+    return std::string();
+}
+
+// 语法树的完整描述：每个节点一行（缩进表示层级），含种类、位置、名字、类型、运算符、字面值与顶层项的 Token 区间。
+// 骨架模式下的函数体在这里通过 getBody() 解析
+inline void dump(std::ostream& out, ASTNode* node, int depth) {
+    out << std::string(depth * 2, ' ');
+    if (!node) {
+        out << "-\n";
+        return;
+    }
+    out << static_cast<int>(node->kind) << " " << node->line << ":" << node->column;
+    auto type = [](const TypeNode* t) { return t ? std::string(t->name) : std::string("-"); };
+    auto span = [](const TokenSpan& s) {
+        return " [" + std::to_string(s.begin) + "," + std::to_string(s.end) + ") #" + std::to_string(s.hash);
+    };
+    ::visit(node, [&](auto* n) {
+        using T = std::remove_pointer_t<decltype(n)>;
+        if constexpr (std::is_same_v<T, Program>) {
+            out << " program\n";
+            for (ASTNode* stmt : n->statements) dump(out, stmt, depth + 1);
+        } else if constexpr (std::is_same_v<T, ImportDecl>) {
+            out << " import " << n->moduleName << "\n";
+        } else if constexpr (std::is_same_v<T, TypeNode>) {
+            out << " type " << n->name << "\n";
+        } else if constexpr (std::is_same_v<T, FunctionDecl>) {
+            out << " fn " << n->name << " -> " << type(n->returnType) << span(n->span) << "\n";
+            for (ASTNode* param : n->parameters) dump(out, param, depth + 1);
+            dump(out, n->getBody(), depth + 1);
+        } else if constexpr (std::is_same_v<T, StructDecl>) {
+            out << " struct " << n->name << span(n->span) << "\n";
+            for (ASTNode* field : n->fields) dump(out, field, depth + 1);
+        } else if constexpr (std::is_same_v<T, ImplBlock>) {
+            out << " impl " << n->structName << span(n->span) << "\n";
+            for (ASTNode* method : n->methods) dump(out, method, depth + 1);
+        } else if constexpr (std::is_same_v<T, VariableDecl>) {
+            out << " var " << n->name << ": " << type(n->type) << (n->isConst ? " const" : "") << "\n";
+            if (n->initializer) dump(out, n->initializer, depth + 1);
+        } else if constexpr (std::is_same_v<T, Block>) {
+            out << " block\n";
+            for (ASTNode* stmt : n->statements) dump(out, stmt, depth + 1);
+        } else if constexpr (std::is_same_v<T, ReturnStmt>) {
+            out << " return\n";
+            dump(out, n->value, depth + 1);
+        } else if constexpr (std::is_same_v<T, ExpressionStmt>) {
+            out << " expr\n";
+            dump(out, n->expression, depth + 1);
+        } else if constexpr (std::is_same_v<T, Identifier>) {
+            out << " id " << n->name << "\n";
+        } else if constexpr (std::is_same_v<T, Literal>) {
+            out << " literal " << n->type << " " << n->value << " " << n->intValue << " " << n->floatValue << "\n";
+        } else if constexpr (std::is_same_v<T, BinaryOp>) {
+            out << " binary " << n->operator_ << "\n";
+            dump(out, n->left, depth + 1);
+            dump(out, n->right, depth + 1);
+        } else if constexpr (std::is_same_v<T, UnaryOp>) {
+            out << " unary " << n->operator_ << "\n";
+            dump(out, n->operand, depth + 1);
+        } else if constexpr (std::is_same_v<T, FunctionCall>) {
+            out << " call " << n->name << "\n";
+            for (ASTNode* arg : n->arguments) dump(out, arg, depth + 1);
+        }
+    });
+}
+
+inline std::string dump(ASTNode* node) {
+    std::ostringstream out;
+    dump(out, node, 0);
+    return out.str();
+}
+
+// 作用域内把 std::cout 重定向到缓冲区（语法分析的日志），text() 取出已写入的内容
+class CapturedOutput {
+private:
+    std::ostringstream buffer;
+    std::streambuf* original;
+
+public:
+    CapturedOutput() : original(std::cout.rdbuf(buffer.rdbuf())) {}
+    ~CapturedOutput() { std::cout.rdbuf(original); }
+    std::string text() const { return buffer.str(); }
+};
+
+// 作用域内启用构建期生成的本地化符号表（.文达 源码），离开时恢复默认的 ASCII 表
+struct LocalizedSymbols {
+    LocalizedSymbols() { Lexer::UseBuiltinLocalizedSymbols(); }
+    ~LocalizedSymbols() { Lexer::ClearOverride(); }
+};
+
+}  // namespace unit_test
+
+#define TEST(name)                                                   \
+    static void name();                                              \
+    static unit_test::Registrar name##_registrar(#name, &name);     \
+    static void name()
+
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) unit_test::fail(__FILE__, __LINE__, "不成立: " #condition); \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                    \
+    do {                                                                              \
+        const auto& actual_ = (actual);                                               \
+        const auto& expected_ = (expected);                                           \
+        if (!(actual_ == expected_)) {                                                \
+            std::ostringstream message_;                                              \
+            message_ << "不相等: " #actual " == " #expected "\n    实得: " << actual_ \
+                     << "\n    期望: " << expected_;                                  \
+            unit_test::fail(__FILE__, __LINE__, message_.str());                      \
+        }                                                                             \
+    } while (0)
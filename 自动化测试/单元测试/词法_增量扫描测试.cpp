@@ -0,0 +1,195 @@
+// IncrementalLexer::relex 与对编辑后全文 tokenize() 的一致性
+#include "单元测试.h"
+#include "corpus.h"
+#include "incremental_lexer.h"
+
+namespace {
+
+const char* const kSource =
+    "// 文件头注释\n"
+    "import \"std/io\"\n"
+    "\n"
+    "add(a: i32, b: i32) -> i32 {\n"
+    "    total := a + b * 0x10\n"
+    "    /* 多行\n"
+    "       注释 */\n"
+    "    name: string = \"hello \\\"world\\\"\"\n"
+    "    <- total\n"
+    "}\n"
+    "\n"
+    "main() {\n"
+    "    print(add(1, 2))\n"
+    "    c := 'x'\n"
+    "}\n";
+
+std::string fullTokens(const std::string& text) {
+    SourceBuffer buffer(text);
+    return unit_test::describe(Lexer(buffer).tokenize());
+}
+
+// 应用一次编辑并与全文重新扫描比对；编辑后的源码有词法错误时，relex 须抛出同样的错误且文档保持原样
+void checkEdit(IncrementalLexer& document, size_t offset, size_t length, const std::string& replacement) {
+    const std::string oldText = document.sourceText();
+    const std::string oldTokens = unit_test::describe(document.tokens());
+    const size_t oldSize = document.size();
+    std::string newText = oldText;
+    newText.replace(offset, length, replacement);
+
+    SourceBuffer buffer(newText);
+    std::string expected;
+    const std::string expectedError = unit_test::errorOf([&] {
+        expected = unit_test::describe(Lexer(buffer).tokenize());
+    });
+
+    // 报告的区间在 relex 返回时就换算好：新旧序列只在区间内不同，文档大小由区间长度决定
+    bool ordered = false;
+    size_t expectedSize = 0;
+    const std::string error = unit_test::errorOf([&] {
+        const RelexResult r = document.relex({offset, length}, replacement);
+        ordered = r.changedBegin <= r.changedEnd && r.changedBegin <= r.oldChangedEnd;
+        expectedSize = oldSize - (r.oldChangedEnd - r.changedBegin) + (r.changedEnd - r.changedBegin);
+    });
+    CHECK_EQ(error, expectedError);
+    if (!expectedError.empty()) {
+        CHECK_EQ(document.sourceText(), oldText);
+        CHECK_EQ(unit_test::describe(document.tokens()), oldTokens);
+        return;
+    }
+
+    CHECK_EQ(document.sourceText(), newText);
+    CHECK_EQ(unit_test::describe(document.tokens()), expected);
+    CHECK(ordered);
+    CHECK_EQ(document.size(), expectedSize);
+}
+
+size_t find(const IncrementalLexer& document, const std::string& needle) {
+    return document.sourceText().find(needle);
+}
+
+}  // namespace
+
+TEST(增量扫描_开头中间末尾的编辑) {
+    IncrementalLexer document(kSource);
+    CHECK_EQ(unit_test::describe(document.tokens()), fullTokens(kSource));
+
+    checkEdit(document, 0, 0, "x := 1\n");                    // 开头插入一行
+    checkEdit(document, 0, 2, "yy");                          // 开头改写
+    checkEdit(document, 0, 7, "");                            // 开头删除一行
+    checkEdit(document, find(document, "total :="), 5, "sum");  // 中间改名（后面的行号、偏移整体平移）
+    checkEdit(document, find(document, "0x10"), 4, "0b1_0");
+    checkEdit(document, find(document, "main"), 0, "helper() {\n}\n\n");
+    checkEdit(document, document.sourceSize(), 0, "extra()");  // 末尾追加（没有结尾换行）
+    checkEdit(document, document.sourceSize() - 7, 7, "");
+    checkEdit(document, document.sourceSize() - 1, 1, "");     // 删除最后的换行
+    checkEdit(document, document.sourceSize(), 0, "\n\n");
+}
+
+TEST(增量扫描_跨行编辑) {
+    IncrementalLexer document(kSource);
+    // 用两行替换三行
+    const size_t begin = find(document, "    total");
+    const size_t end = find(document, "    name");
+    checkEdit(document, begin, end - begin, "    t := 1\n    u := t\n");
+    // 把一个函数整体并入上一行
+    checkEdit(document, find(document, "}\n\nmain"), 3, "} ");
+    // 删除跨越注释边界的区间
+    const size_t comment = find(document, "/* 多行");
+    checkEdit(document, comment + 3, find(document, "注释 */") - comment, "x");
+    // 在多行注释中间加入换行与文本
+    checkEdit(document, find(document, "import"), 0, "/* 一\n二\n三 */ ");
+}
+
+TEST(增量扫描_字符串与注释内的编辑) {
+    IncrementalLexer document(kSource);
+    checkEdit(document, find(document, "hello") + 2, 0, " 中间 ");
+    checkEdit(document, find(document, "llo"), 3, "\\t\\\\");
+    checkEdit(document, find(document, "std/io"), 3, "");
+    // 打开一个多行注释：其后的Token全部变成注释，直到再次闭合
+    checkEdit(document, find(document, "add("), 0, "/* ");
+    checkEdit(document, find(document, "main"), 0, "*/ ");
+    // 注释开头被删除后恢复为代码
+    checkEdit(document, find(document, "/* add"), 3, "");
+    checkEdit(document, find(document, "*/ main"), 3, "");
+    // 字符串中的 // 与 /* 不是注释
+    checkEdit(document, find(document, "world"), 0, "// /* ");
+    checkEdit(document, find(document, "'x'") + 1, 1, "\\n");
+}
+
+TEST(增量扫描_编辑引入词法错误时保持原样) {
+    IncrementalLexer document(kSource);
+    checkEdit(document, find(document, "hello"), 0, "\"");      // 引号不配对：字符串跨行
+    checkEdit(document, find(document, "print"), 0, "：");      // ASCII 模式下的全角符号
+    checkEdit(document, find(document, "0x10"), 4, "0x");       // 缺少数字
+    checkEdit(document, find(document, "/* 多行") + 1, 1, "");  // 注释收尾孤立的 */ 仍可扫描
+    checkEdit(document, find(document, "c := "), 0, "/* ");     // 到文件末尾都没有结束的注释
+    // 出错之后文档仍可继续编辑
+    checkEdit(document, find(document, "main"), 4, "start");
+}
+
+TEST(增量扫描_CRLF与本地化源码) {
+    std::string crlf = kSource;
+    for (size_t i = crlf.find('\n'); i != std::string::npos; i = crlf.find('\n', i + 2)) {
+        crlf.insert(i, "\r");
+    }
+    IncrementalLexer windows(crlf);
+    CHECK_EQ(unit_test::describe(windows.tokens()), fullTokens(crlf));
+    checkEdit(windows, find(windows, "total"), 0, "x := 1\r\n    ");
+    checkEdit(windows, find(windows, "\r\n"), 1, "");
+    checkEdit(windows, find(windows, "main"), 0, "\r\n\r\n");
+
+    unit_test::LocalizedSymbols localized;
+    const std::string chinese = "主函数（）-》整数 {\n    计数：= 1\n    打印(“中文 \\” 引号”)\n    《- 计数\n}\n";
+    IncrementalLexer document(chinese);
+    CHECK_EQ(unit_test::describe(document.tokens()), fullTokens(chinese));
+    checkEdit(document, find(document, "计数："), 6, "总和");
+    checkEdit(document, find(document, "中文"), 6, "英文 “");
+    checkEdit(document, find(document, "《-"), 0, "打印（总和）\n    ");
+}
+
+TEST(增量扫描_随机编辑与全文扫描一致) {
+    CorpusOptions options;
+    options.targetBytes = 24 * 1024;
+    options.seed = 3;
+    IncrementalLexer document(generateCorpus(options));
+
+    static const char* const kSnippets[] = {
+        "x", " ", "\n", "\"", "/*", "*/", "//", "123", "1_0", "0x", "(", ")", "{", "}\n", "\\",
+        "'a'", ":=", "<- ", "\r\n", "total", "\"s\\n\"", "\n\n\n", "count + 1\n", "/* \n */",
+    };
+    corpus_detail::Random random{42};
+    size_t cursor = 0;
+    for (int step = 0; step < 400; ++step) {
+        const size_t size = document.sourceSize();
+        // 多数编辑集中在一处附近，模拟连续输入；偶尔跳到别处
+        cursor = random.below(8) == 0 ? random.below(size + 1) : std::min(size, cursor + random.below(16));
+        const size_t length = std::min(size - cursor, random.below(3) == 0 ? random.below(40) : 0);
+        std::string replacement;
+        for (size_t n = random.below(3); n-- > 0;) {
+            replacement += kSnippets[random.below(sizeof(kSnippets) / sizeof(kSnippets[0]))];
+        }
+        const int failures = unit_test::failureCount();
+        checkEdit(document, cursor, length, replacement);
+        if (unit_test::failureCount() != failures) {
+            std::cerr << "  第 " << step << " 次编辑: offset=" << cursor << " length=" << length << std::endl;
+            return;
+        }
+    }
+}
+
+TEST(增量扫描_局部编辑只重扫所在的行) {
+    CorpusOptions options;
+    options.targetBytes = 1024 * 1024;
+    IncrementalLexer document(generateCorpus(options));
+    const size_t total = document.size();
+
+    // 文件中部改一个字符：重新扫描的Token只有这一行，其余Token原样保留
+    const size_t middle = document.sourceText().find(" := ", document.sourceSize() / 2) - 1;
+    RelexResult result = document.relex({middle, 1}, "7");
+    CHECK(result.changedEnd - result.changedBegin < 64);
+    CHECK(result.oldChangedEnd - result.changedBegin < 64);
+    CHECK_EQ(document.size(), total);
+    // 接着在附近插入一行
+    result = document.relex({middle, 0}, "\n    y := 1\n   ");
+    CHECK(result.changedEnd - result.changedBegin < 64);
+    CHECK_EQ(unit_test::describe(document.tokens()), fullTokens(document.sourceText()));
+}
@@ -0,0 +1,121 @@
+// Lexer::scanParallel 与顺序扫描 scan() 逐字节一致（Token、符号风格统计与报错）
+// 用很小的 minChunk 强制切块，使分块边界落在几乎每个换行上
+#include "单元测试.h"
+#include "corpus.h"
+
+namespace {
+
+// 跨行注释里的引号、字符串里的注释符号、行注释里的 */ 等，单独扫描某一块时都会误判
+const char* const kTrickySource =
+    "main() {\n"
+    "    /* 多行注释开始\n"
+    "       \"这里像是未结束的字符串\n"
+    "       // 也像是行注释\n"
+    "       'x\n"
+    "    */ a := 1\n"
+    "    s := \"字符串里的 /* 不是注释\"\n"
+    "    t := \"还有 // 也不是\"\n"
+    "    // 行注释里的 */ 与 \" 都不算\n"
+    "    /* 单行块注释 */ b := 0x1F + 1_000 * 2.5e3\n"
+    "    /*\n"
+    "\n"
+    "    */\n"
+    "    中文名 := '中'\n"
+    "}\n"
+    "/* 文件末尾的注释 */";
+
+std::string statsOf(const SymbolStats& stats) {
+    std::ostringstream out;
+    out << stats.halfWidth << "/" << stats.fullWidth << "/" << stats.neutral << " @" << stats.firstHalfOffset << ","
+        << stats.firstFullOffset;
+    return out.str();
+}
+
+std::string toCrlf(std::string text) {
+    for (size_t i = text.find('\n'); i != std::string::npos; i = text.find('\n', i + 2)) {
+        text.insert(i, "\r");
+    }
+    return text;
+}
+
+// 对每组线程数与分块下限，比对并行与顺序扫描的Token序列、统计与报错
+void checkParallel(const std::string& text, const std::vector<unsigned>& threadCounts,
+                   const std::vector<size_t>& minChunks) {
+    for (bool validated : {false, true}) {
+        SourceBuffer buffer(text);
+        if (validated && buffer.validate() != buffer.size()) continue;
+        for (bool fold : {false, true}) {
+            Lexer sequential(buffer);
+            sequential.setFoldNewlines(fold);
+            std::string expected;
+            const std::string expectedError =
+                unit_test::errorOf([&] { expected = unit_test::describe(sequential.scan()); });
+
+            for (unsigned threads : threadCounts) {
+                for (size_t minChunk : minChunks) {
+                    Lexer parallel(buffer);
+                    parallel.setFoldNewlines(fold);
+                    std::string actual;
+                    const std::string error = unit_test::errorOf(
+                        [&] { actual = unit_test::describe(parallel.scanParallel(threads, minChunk)); });
+                    const int failures = unit_test::failureCount();
+                    CHECK_EQ(error, expectedError);
+                    CHECK_EQ(actual, expected);
+                    if (expectedError.empty()) {
+                        CHECK_EQ(statsOf(parallel.symbolStats()), statsOf(sequential.symbolStats()));
+                    }
+                    if (unit_test::failureCount() != failures) {
+                        std::cerr << "  threads=" << threads << " minChunk=" << minChunk << " fold=" << fold
+                                  << " validated=" << validated << std::endl;
+                        return;
+                    }
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+
+TEST(并行扫描_基准语料与顺序扫描一致) {
+    CorpusOptions options;
+    options.targetBytes = 96 * 1024;
+    checkParallel(generateCorpus(options), {2, 4, 7}, {512, 8 * 1024});
+
+    // 注释与字符串密集的语料：跨块的多行注释更多
+    options.identifierDensity = 0.1;
+    options.commentDensity = 0.6;
+    options.seed = 11;
+    checkParallel(generateCorpus(options), {3, 8}, {256, 4 * 1024});
+
+    unit_test::LocalizedSymbols localized;
+    options = CorpusOptions();
+    options.targetBytes = 96 * 1024;
+    options.fullWidth = true;
+    checkParallel(generateCorpus(options), {2, 5}, {512, 8 * 1024});
+}
+
+TEST(并行扫描_分块边界在注释与字符串附近) {
+    checkParallel(kTrickySource, {2, 3, 5, 8, 16}, {1, 3, 8, 20, 64});
+    // 单独一块从多行注释中间开始，后面全是注释
+    checkParallel(std::string("/*\n") + std::string(40, '\n') + "x := \"a\n*/ y := 1\n", {4, 16}, {1, 2});
+}
+
+TEST(并行扫描_CRLF换行) {
+    checkParallel(toCrlf(kTrickySource), {2, 3, 8, 16}, {1, 5, 32});
+    CorpusOptions options;
+    options.targetBytes = 48 * 1024;
+    checkParallel(toCrlf(generateCorpus(options)), {4}, {256});
+}
+
+TEST(并行扫描_后续分块中的词法错误) {
+    const std::string prefix = kTrickySource;
+    // 只有最后一块有错
+    checkParallel(prefix + "\nz := 1 ： 2\n", {2, 4, 16}, {1, 16, 64});
+    // 两处错误分别落在不同分块：报告的是源码中靠前的那一处
+    checkParallel(prefix + "\nz := \"跨行\n" + prefix + "\nn := 99999999999999999999\n", {2, 4, 16}, {1, 16, 64});
+    // 未结束的多行注释吞掉后面所有分块
+    checkParallel(prefix + "\n/* 未结束\n" + prefix, {2, 4, 16}, {1, 16, 64});
+    // 行尾截断的多字节序列吞掉换行（未校验编码时）
+    checkParallel(prefix + "\nw := 1 \xE4\nv := 2\n", {2, 4, 16}, {1, 16});
+}
@@ -0,0 +1,148 @@
+// 拉取模式（next()/peek() 环形缓冲区）与 tokenize() 的一致性
+#include "单元测试.h"
+#include "corpus.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+const char* const kAsciiSource =
+    "\xEF\xBB\xBF// 开头带 BOM\r\n"
+    "import \"std/io\"\r\n"
+    "main() -> i32 {\n"
+    "    total := 0x1F + 0b101 + 1_000 * 3.5e2 /* 行内\n"
+    "       多行注释 */ - 'a'\n"
+    "    name: string = \"tab\\t quote\\\" end\"\n"
+    "    (total >= 10 && total != 3) ? { print(name) } : { print(\"no\") }\n"
+    "    <- total % 7\n"
+    "}\n";
+
+const char* const kLocalizedSource =
+    "主函数（）-》整数 {\n"
+    "    计数：= 1\n"
+    "    （计数 》= 0）？ {\n"
+    "        打印(“中文引号 \\” 转义”)\n"
+    "    }\n"
+    "    《- 计数\n"
+    "}";
+
+// 逐步拉取整个流：每一步先用 peek(0..kMaxLookahead) 比对前方的Token，再 next()
+void checkStream(const std::string& text, bool fold) {
+    SourceBuffer buffer(text);
+    Lexer batch(buffer);
+    batch.setFoldNewlines(fold);
+    const std::vector<Token> expected = batch.tokenize();
+
+    Lexer stream(buffer);
+    stream.setFoldNewlines(fold);
+    std::string pulled;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        for (size_t k = 0; k <= Lexer::kMaxLookahead; ++k) {
+            // 越过 EOF 的前瞻一律是 EOF
+            const Token& ahead = expected[std::min(i + k, expected.size() - 1)];
+            const std::string peeked = unit_test::describe(stream.peek(k));
+            if (peeked != unit_test::describe(ahead)) {
+                CHECK_EQ(peeked, unit_test::describe(ahead));
+                return;
+            }
+        }
+        pulled += unit_test::describe(stream.next()) + "\n";
+    }
+    CHECK_EQ(pulled, unit_test::describe(expected));
+
+    // 到达末尾后反复返回 EOF
+    CHECK(stream.next().type == TokenType::EOF_TOKEN);
+    CHECK(stream.peek(Lexer::kMaxLookahead).type == TokenType::EOF_TOKEN);
+    CHECK(stream.next().type == TokenType::EOF_TOKEN);
+}
+
+// text 在 errorOffset 处有词法错误：拉取模式先给出与 tokenize(text[0, errorOffset)) 相同的Token，
+// 再抛出与 tokenize(text) 相同的错误；在错误之前 k 个Token处 peek(k) 就会抛出
+void checkStreamError(const std::string& text, size_t errorOffset) {
+    SourceBuffer buffer(text);
+    const std::string expectedError = unit_test::errorOf([&] { Lexer(buffer).tokenize(); });
+    CHECK(!expectedError.empty());
+
+    SourceBuffer prefixBuffer(text.substr(0, errorOffset));
+    std::vector<Token> prefix = Lexer(prefixBuffer).tokenize();
+    prefix.pop_back();  // EOF
+    CHECK(prefix.size() >= 2);
+
+    // 逐个 next()：前缀一致，随后抛出同样的错误
+    Lexer stream(buffer);
+    std::string pulled;
+    const std::string error = unit_test::errorOf([&] {
+        while (true) {
+            const Token& token = stream.next();
+            if (token.type == TokenType::EOF_TOKEN) break;
+            pulled += unit_test::describe(token) + "\n";
+        }
+    });
+    CHECK_EQ(error, expectedError);
+    CHECK_EQ(pulled, unit_test::describe(prefix));
+
+    // 前瞻提前触发同一个错误：错误之前的Token仍可正常前瞻
+    Lexer lookahead(buffer);
+    for (size_t i = 0; i + 2 < prefix.size(); ++i) lookahead.next();
+    CHECK_EQ(unit_test::describe(lookahead.peek(0)), unit_test::describe(prefix[prefix.size() - 2]));
+    CHECK_EQ(unit_test::describe(lookahead.peek(1)), unit_test::describe(prefix[prefix.size() - 1]));
+    CHECK_EQ(unit_test::errorOf([&] { lookahead.peek(2); }), expectedError);
+}
+
+}  // namespace
+
+TEST(拉取模式_ASCII源码与tokenize一致) {
+    checkStream(kAsciiSource, false);
+    checkStream(kAsciiSource, true);
+    checkStream("", false);
+    checkStream("x", true);
+    checkStream("\n\n\n", false);
+}
+
+TEST(拉取模式_本地化源码与tokenize一致) {
+    unit_test::LocalizedSymbols localized;
+    checkStream(kLocalizedSource, false);
+    checkStream(kLocalizedSource, true);
+}
+
+TEST(拉取模式_基准语料与tokenize一致) {
+    CorpusOptions options;
+    options.targetBytes = 64 * 1024;
+    checkStream(generateCorpus(options), true);
+    checkStream(generateCorpus(options), false);
+
+    unit_test::LocalizedSymbols localized;
+    options.fullWidth = true;
+    options.seed = 7;
+    checkStream(generateCorpus(options), true);
+}
+
+TEST(拉取模式_前瞻超出环形缓冲区) {
+    SourceBuffer buffer{std::string(kAsciiSource)};
+    Lexer stream(buffer);
+    bool threw = false;
+    try {
+        stream.peek(Lexer::kMaxLookahead + 1);
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    // 最远的前瞻结果在随后的 kMaxLookahead 次 next() 与新的最远前瞻之后仍然有效
+    const std::vector<Token> expected = Lexer(buffer).tokenize();
+    const Token& far = stream.peek(Lexer::kMaxLookahead);
+    for (size_t i = 0; i < Lexer::kMaxLookahead; ++i) {
+        stream.next();
+        stream.peek(Lexer::kMaxLookahead);
+    }
+    CHECK_EQ(unit_test::describe(far), unit_test::describe(expected[Lexer::kMaxLookahead]));
+    CHECK_EQ(unit_test::describe(stream.next()), unit_test::describe(expected[Lexer::kMaxLookahead]));
+}
+
+TEST(拉取模式_词法错误与tokenize一致) {
+    const std::string good = "main() {\n    a := 1 + 2\n    print(\"ok\")\n";
+    checkStreamError(good + "    b := 3 ： 4\n}\n", good.size() + 11);
+    checkStreamError(good + "    s := \"未结束\n}\n", good.size() + 9);
+    checkStreamError(good + "    n := 99999999999999999999\n", good.size() + 9);
+    checkStreamError(good + "    c := 1 /* 未结束的注释\n", good.size() + 11);
+}
@@ -0,0 +1,168 @@
+// Parser::reparse 与完整解析 parse() 一致：改动、调换、插入与删除顶层项后语法树相同，
+// 只有改动过的项重新解析；哈希相同但Token不同的项不复用；连续增量重解析到上限后改做完整解析
+#include "单元测试.h"
+#include "parser.h"
+
+namespace {
+
+// 一个版本的源码及其Token序列（两种形式都保留：紧凑模式与批量模式各跑一遍）
+struct Version {
+    SourceBuffer buffer;
+    TokenStore store;
+    std::vector<Token> tokens;
+};
+
+std::unique_ptr<Version> lex(const std::vector<std::string>& items) {
+    std::string source;
+    for (const std::string& item : items) {
+        source += item;
+        source += "\n\n";
+    }
+    auto version = std::make_unique<Version>();
+    version->buffer = SourceBuffer(source);
+    Lexer lexer(version->buffer);
+    lexer.setFoldNewlines(true);
+    version->store = lexer.scan();
+    version->tokens = version->store.toTokens();
+    return version;
+}
+
+std::string function(const std::string& name, int value) {
+    return name + "(a: i32) {\n    v: i32 = " + std::to_string(value) + "\n    print(\"" + name + "\", a, -v)\n    <- a\n}";
+}
+
+const std::string kStruct = "@Point {\n    x: i32,\n    y: f64\n}";
+const std::string kImpl = "&Point {\n    norm(p: i32) {\n        <- p\n    }\n    zero() {\n    }\n}";
+
+std::string itemName(ASTNode* item) {
+    if (auto function = nodeCast<FunctionDecl>(item)) return std::string(function->name);
+    if (auto structDecl = nodeCast<StructDecl>(item)) return "@" + std::string(structDecl->name);
+    if (auto impl = nodeCast<ImplBlock>(item)) return "&" + std::string(impl->structName);
+    return std::string();
+}
+
+std::string names(const std::vector<ASTNode*>& items) {
+    std::string text;
+    for (ASTNode* item : items) text += itemName(item) + " ";
+    return text;
+}
+
+std::string names(const std::vector<std::string>& items) {
+    std::string text;
+    for (const std::string& item : items) text += item + " ";
+    return text;
+}
+
+// 按同样的模式（紧凑或批量、是否骨架）完整解析
+std::unique_ptr<Program> parseFresh(const Version& version, bool vectorTokens, bool skeleton) {
+    Parser parser = vectorTokens ? Parser(version.tokens) : Parser(version.store);
+    parser.setSkeleton(skeleton);
+    return parser.parse();
+}
+
+Parser::Reparse reparseFrom(std::unique_ptr<Program> previous, const Version& before, const Version& after,
+                            bool vectorTokens, bool skeleton) {
+    Parser parser = vectorTokens ? Parser(after.tokens) : Parser(after.store);
+    parser.setSkeleton(skeleton);
+    return vectorTokens ? parser.reparse(std::move(previous), before.tokens)
+                        : parser.reparse(std::move(previous), before.store);
+}
+
+struct Edit {
+    const char* what;
+    std::vector<std::string> items;
+    std::string changed;  // 重新解析的项（按源码顺序）
+    std::string removed;  // 未被复用的旧项
+};
+
+}  // namespace
+
+TEST(增量重解析_改动调换插入删除后与完整解析一致) {
+    const std::vector<std::string> base = {">> \"std/io\"", function("alpha", 1), kStruct, kImpl,
+                                           function("beta", 2), function("gamma", 3)};
+    const Edit edits[] = {
+        {"改动函数体", {">> \"std/io\"", function("alpha", 1), kStruct, kImpl, function("beta", 20), function("gamma", 3)},
+         "beta ", "beta "},
+        {"调换顺序", {function("gamma", 3), ">> \"std/io\"", function("beta", 20), kImpl, kStruct, function("alpha", 1)},
+         "", ""},
+        {"插入", {function("gamma", 3), ">> \"std/io\"", function("beta", 20), function("delta", 4), kImpl, kStruct,
+                  function("alpha", 1)},
+         "delta ", ""},
+        {"删除", {function("gamma", 3), function("beta", 20), function("delta", 4), kStruct, function("alpha", 1)},
+         "", "&Point "},
+        // 内容完全相同的项各自复用一个旧项
+        {"重复的项", {function("gamma", 3), kStruct, function("gamma", 3), kStruct, function("alpha", 1)},
+         "gamma @Point ", "beta delta "},
+    };
+
+    for (bool vectorTokens : {false, true}) {
+        for (bool skeleton : {false, true}) {
+            unit_test::CapturedOutput captured;
+            auto before = lex(base);
+            std::unique_ptr<Program> program = parseFresh(*before, vectorTokens, skeleton);
+            for (const Edit& edit : edits) {
+                auto after = lex(edit.items);
+                Parser::Reparse result = reparseFrom(std::move(program), *before, *after, vectorTokens, skeleton);
+                const int failures = unit_test::failureCount();
+                CHECK_EQ(unit_test::dump(result.program.get()),
+                         unit_test::dump(parseFresh(*after, vectorTokens, skeleton).get()));
+                CHECK_EQ(names(result.changed), edit.changed);
+                CHECK_EQ(names(result.removed), edit.removed);
+                if (unit_test::failureCount() != failures) {
+                    std::cerr << "  " << edit.what << " vectorTokens=" << vectorTokens << " skeleton=" << skeleton
+                              << std::endl;
+                }
+                program = std::move(result.program);
+                before = std::move(after);
+            }
+        }
+    }
+}
+
+TEST(增量重解析_哈希相同但Token不同时不复用) {
+    unit_test::CapturedOutput captured;
+    auto before = lex({function("alpha", 1), function("beta", 2)});
+    auto after = lex({function("alpha", 1), function("beta", 3)});
+    std::unique_ptr<Program> program = Parser(before->store).parse();
+    std::unique_ptr<Program> expected = Parser(after->store).parse();
+
+    // 伪造一次哈希碰撞：旧的 beta 带上新 beta 的哈希，只比哈希就会错误地复用旧的函数体
+    auto beta = [](Program& p) { return nodeCast<FunctionDecl>(p.statements[1]); };
+    beta(*program)->span.hash = beta(*expected)->span.hash;
+
+    Parser::Reparse result = Parser(after->store).reparse(std::move(program), before->store);
+    CHECK_EQ(unit_test::dump(result.program.get()), unit_test::dump(expected.get()));
+    CHECK_EQ(names(result.changed), std::string("beta "));
+    CHECK_EQ(result.reused, size_t(1));
+}
+
+TEST(增量重解析_达到上限后完整解析) {
+    unit_test::CapturedOutput captured;
+    std::vector<std::string> items;
+    for (int i = 0; i < 20; ++i) items.push_back(function("f_" + std::to_string(i), i));
+    auto before = lex(items);
+    std::unique_ptr<Program> program = Parser(before->store).parse();
+
+    for (uint32_t round = 1; round <= Parser::kMaxReparses + 1; ++round) {
+        items[round % items.size()] = function("f_" + std::to_string(round % items.size()), 100 + round);
+        auto after = lex(items);
+        Parser::Reparse result = Parser(after->store).reparse(std::move(program), before->store);
+        std::unique_ptr<Program> fresh = Parser(after->store).parse();
+        CHECK_EQ(unit_test::dump(result.program.get()), unit_test::dump(fresh.get()));
+        if (round <= Parser::kMaxReparses) {
+            // 只重解析改动的一项，旧节点留在 arena 中
+            CHECK_EQ(result.program->reparses, round);
+            CHECK_EQ(result.reused, items.size() - 1);
+            CHECK(result.program->arena.bytesUsed() > fresh->arena.bytesUsed());
+        } else {
+            // 上限之后的一次完整解析：全部项重新解析，arena 回到一次解析的大小
+            CHECK_EQ(result.program->reparses, 0u);
+            CHECK_EQ(result.reused, size_t(0));
+            CHECK_EQ(result.changed.size(), items.size());
+            CHECK_EQ(result.removed.size(), items.size());
+            CHECK_EQ(result.program->arena.bytesUsed(), fresh->arena.bytesUsed());
+        }
+        program = std::move(result.program);
+        before = std::move(after);
+    }
+}
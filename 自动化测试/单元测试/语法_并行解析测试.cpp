@@ -0,0 +1,117 @@
+// Parser::parseParallel 与顺序解析 parse() 一致（语法树、日志与报错）
+// 用很小的 minChunk 强制切块，覆盖多种线程数、花括号不配对时的顺序回退，以及落在不同分块中的语法错误
+#include "单元测试.h"
+#include "corpus.h"
+#include "parser.h"
+
+namespace {
+
+// 可通过语法分析的程序：函数、@结构体、&实现块与导入交替出现
+std::string generateProgram(size_t items, uint64_t seed) {
+    corpus_detail::Random random{seed};
+    std::string out = ">> \"std/io\"\n\n";
+    for (size_t i = 0; i < items; ++i) {
+        const std::string n = std::to_string(i);
+        switch (random.below(6)) {
+            case 0:
+                out += "@Point" + n + " {\n    x: i32,\n    y: f64\n}\n\n";
+                break;
+            case 1:
+                out += "&Point" + n + " {\n    norm(p: i32) {\n        <- p * p\n    }\n    zero() {\n    }\n}\n\n";
+                break;
+            case 2:
+                out += ">> \"module" + n + "\"\n";
+                break;
+            default: {
+                out += "compute_" + n + "(a: i32, b: i32) {\n";
+                for (size_t s = 2 + random.below(6); s-- > 0;) {
+                    switch (random.below(4)) {
+                        case 0: out += "    v" + std::to_string(s) + ": i32 = " + std::to_string(random.below(1000)) + "\n"; break;
+                        case 1: out += "    print(\"item " + n + "\", -a, b * 2)\n"; break;
+                        case 2: out += "    w := (a + b) * " + std::to_string(random.below(100)) + " == b\n"; break;
+                        default: out += "    t: string = \"{ 字符串里的花括号 }\"\n"; break;
+                    }
+                }
+                out += "    <- a\n}\n\n";
+            }
+        }
+    }
+    return out;
+}
+
+struct Outcome {
+    std::string tree;
+    std::string log;
+    std::string error;
+};
+
+// threads 为 0 时顺序解析；vectorTokens 为 true 时改用物化的 Token 列表（批量模式），否则用紧凑的 TokenStore
+Outcome parseWith(const TokenStore& store, const std::vector<Token>& tokens, bool vectorTokens, unsigned threads,
+                  size_t minChunk) {
+    Outcome outcome;
+    unit_test::CapturedOutput captured;
+    outcome.error = unit_test::errorOf([&] {
+        Parser parser = vectorTokens ? Parser(tokens) : Parser(store);
+        std::unique_ptr<Program> program = threads ? parser.parseParallel(threads, minChunk) : parser.parse();
+        outcome.tree = unit_test::dump(program.get());
+    });
+    outcome.log = captured.text();
+    return outcome;
+}
+
+void checkParallel(const std::string& source, const std::vector<unsigned>& threadCounts,
+                   const std::vector<size_t>& minChunks) {
+    SourceBuffer buffer(source);
+    Lexer lexer(buffer);
+    lexer.setFoldNewlines(true);
+    const TokenStore store = lexer.scan();
+    const std::vector<Token> tokens = store.toTokens();
+
+    for (bool vectorTokens : {false, true}) {
+        const Outcome expected = parseWith(store, tokens, vectorTokens, 0, 0);
+        for (unsigned threads : threadCounts) {
+            for (size_t minChunk : minChunks) {
+                const Outcome actual = parseWith(store, tokens, vectorTokens, threads, minChunk);
+                const int failures = unit_test::failureCount();
+                CHECK_EQ(actual.error, expected.error);
+                CHECK_EQ(actual.tree, expected.tree);
+                CHECK_EQ(actual.log, expected.log);
+                if (unit_test::failureCount() != failures) {
+                    std::cerr << "  threads=" << threads << " minChunk=" << minChunk
+                              << " vectorTokens=" << vectorTokens << std::endl;
+                    return;
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+
+TEST(并行解析_与顺序解析一致) {
+    checkParallel(generateProgram(60, 1), {2, 3, 4, 7, 16}, {1, 16, 200});
+    checkParallel(generateProgram(400, 2), {2, 5, 8}, {64, 1024});
+    // 只有一个顶层项、Token 不足以切块时退回 parse()
+    checkParallel("main() {\n    print(1)\n}\n", {2, 4}, {1, 1000});
+    checkParallel("", {4}, {1});
+}
+
+TEST(并行解析_花括号不配对时回退到顺序解析) {
+    const std::string good = generateProgram(30, 3);
+    // 顶层多出的 '}' 被跳过；按深度切出的边界与解析器实际停下的位置不同
+    checkParallel(good + "}\n}\n" + good, {2, 3, 4, 8}, {1, 8, 64});
+    // 结构体缺少右花括号：切分时它与后面的项连成一段
+    checkParallel(good + "@Broken {\n    x: i32\n\n" + good, {2, 4, 8}, {1, 16});
+    // 缺少右花括号的函数吞掉后面所有的项，直到文件末尾
+    checkParallel(good + "open(a: i32) {\n    print(a)\n" + good, {2, 4, 8}, {1, 16});
+}
+
+TEST(并行解析_分块中的语法错误与顺序解析一致) {
+    const std::string good = generateProgram(40, 4);
+    // 错误只在最后一块
+    checkParallel(good + good + "late(a: i32) {\n    x := (a + 1\n}\n", {2, 4, 8}, {1, 32});
+    // 错误在第一块，后面的分块都成功：报告第一块的错误
+    checkParallel("early() {\n    print(1,\n}\n" + good + good, {2, 4, 8}, {1, 32});
+    // 两处错误分别在不同分块：报告源码中靠前的那一处
+    checkParallel(good + "@ {\n}\n" + good + "bad(: i32) {\n}\n" + good, {2, 3, 4, 8}, {1, 32});
+}
@@ -0,0 +1,180 @@
+// 骨架模式：函数体只在语义分析从入口函数出发用到时才解析。
+// 用到的函数体与 parse() 的结果一致（语法树、语义错误、扁平 AST），用不到的函数体中的语法错误不报告
+#include "单元测试.h"
+#include "flat_ast.h"
+#include "parser.h"
+#include "semantic.h"
+
+namespace {
+
+const std::string kUsed =
+    "main() {\n"
+    "    helper(1)\n"
+    "    print(\"main\", -2)\n"
+    "}\n"
+    "\n"
+    "helper(a: i32) {\n"
+    "    b := a\n"
+    "    leaf()\n"
+    "    <- b\n"
+    "}\n"
+    "\n"
+    "leaf() {\n"
+    "    print(\"leaf\")\n"
+    "}\n";
+
+const std::string kBroken = "\nbroken() {\n    x := (1 +\n}\n";
+
+struct Compiled {
+    SourceBuffer buffer;  // tokens 与尚未解析的函数体都指向它
+    TokenStore tokens;
+    std::unique_ptr<Program> program;
+    std::string error;
+    std::string semanticErrors;
+    std::string unparsed;  // 语义分析结束时仍未解析的函数体
+};
+
+// 词法分析后解析（可选骨架模式）并做语义分析；语法错误（含语义分析中补解析函数体时的）记在 error
+std::unique_ptr<Compiled> compile(const std::string& source, bool skeleton, bool analyze = true) {
+    auto compiled = std::make_unique<Compiled>();
+    compiled->buffer = SourceBuffer(source);
+    Lexer lexer(compiled->buffer);
+    lexer.setFoldNewlines(true);
+    compiled->tokens = lexer.scan();
+
+    unit_test::CapturedOutput captured;
+    compiled->error = unit_test::errorOf([&] {
+        Parser parser(compiled->tokens);
+        parser.setSkeleton(skeleton);
+        compiled->program = parser.parse();
+        if (!analyze) return;
+        SemanticAnalyzer analyzer;
+        analyzer.analyze(compiled->program);
+        for (const SemanticErrorInfo& error : analyzer.getErrors()) {
+            compiled->semanticErrors += std::to_string(error.line) + ":" + std::to_string(error.column) + " " +
+                                        error.message + "\n";
+        }
+        for (const FunctionDecl* function : analyzer.getUnparsedBodies()) {
+            compiled->unparsed += std::string(function->name) + " ";
+        }
+    });
+    return compiled;
+}
+
+FunctionDecl* findFunction(Program& program, const std::string& name) {
+    for (ASTNode* stmt : program.statements) {
+        if (auto function = nodeCast<FunctionDecl>(stmt)) {
+            if (function->name == name) return function;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+TEST(骨架模式_只解析用到的函数体) {
+    auto skeleton = compile(kUsed + "\nunused(p: i32) {\n    print(p)\n}\n", true);
+    CHECK_EQ(skeleton->error, std::string());
+    CHECK_EQ(skeleton->semanticErrors, std::string());
+    // main 调用 helper，helper 再调用 leaf；unused 没有被调用
+    for (const char* name : {"main", "helper", "leaf"}) {
+        FunctionDecl* function = findFunction(*skeleton->program, name);
+        CHECK(function && !function->lazyBody && function->body);
+    }
+    FunctionDecl* unused = findFunction(*skeleton->program, "unused");
+    CHECK(unused && unused->lazyBody && !unused->body);
+    CHECK_EQ(skeleton->unparsed, std::string("unused "));
+
+    // 转换为扁平 AST 时也不解析用不到的函数体
+    const flat_ast::Ast flat = flat_ast::Ast::fromProgram(*skeleton->program);
+    CHECK(unused->lazyBody);
+    const flat_ast::Ast full = flat_ast::Ast::fromProgram(*compile(kUsed, false)->program);
+    CHECK_EQ(flat.nodeCount(), full.nodeCount() + 2);  // unused 的声明与参数
+}
+
+TEST(骨架模式_未用到的函数体语法错误不报告) {
+    const std::string source = kUsed + kBroken;
+    const std::string expected = compile(source, false)->error;
+    CHECK(!expected.empty());
+
+    auto skeleton = compile(source, true);
+    CHECK_EQ(skeleton->error, std::string());
+    CHECK_EQ(skeleton->semanticErrors, std::string());
+    FunctionDecl* broken = findFunction(*skeleton->program, "broken");
+    CHECK(broken && broken->lazyBody);
+    CHECK_EQ(skeleton->unparsed, std::string("broken "));
+    // 用到的部分与去掉坏函数后完整解析的结果相同（坏函数在末尾，前面各项的位置与区间不变）
+    auto full = compile(kUsed, false);
+    CHECK_EQ(unit_test::dump(findFunction(*skeleton->program, "main")),
+             unit_test::dump(findFunction(*full->program, "main")));
+    CHECK_EQ(unit_test::dump(findFunction(*skeleton->program, "helper")),
+             unit_test::dump(findFunction(*full->program, "helper")));
+
+    // 坏函数被调用时，语义分析补解析它的函数体，报出与 parse() 相同的语法错误
+    std::string calling = source;
+    calling.replace(calling.find("leaf()\n"), 7, "broken()\n");
+    const std::string reported = compile(calling, true)->error;
+    const std::string reportedByParse = compile(calling, false)->error;
+    CHECK_EQ(reported, reportedByParse);
+    CHECK_EQ(reported, expected);
+}
+
+TEST(骨架模式_报告未解析的函数体) {
+    // 只被引用、没有被直接调用的函数也分析函数体，其中的语义错误照常报告
+    const std::string referenced = "leaf() {\n    s: i32 = \"text\"\n}\n\nmain() {\n    g := leaf\n}\n";
+    auto skeleton = compile(referenced, true);
+    auto full = compile(referenced, false);
+    CHECK(!full->semanticErrors.empty());
+    CHECK_EQ(skeleton->semanticErrors, full->semanticErrors);
+    CHECK_EQ(skeleton->unparsed, std::string());
+
+    // 实现块的方法不做语义分析，骨架模式下它们的函数体与用不到的函数一起报告，不被静默跳过
+    auto impl = compile(kUsed + kBroken + "\n@Point {\n    x: i32\n}\n&Point {\n    norm() {\n    }\n}\n", true);
+    CHECK_EQ(impl->error, std::string());
+    CHECK_EQ(impl->unparsed, std::string("broken norm "));
+    const std::string eager = compile(kUsed, false)->unparsed;
+    CHECK_EQ(eager, std::string());
+}
+
+TEST(骨架模式_扁平AST只解析顶层入口函数) {
+    // 实现块里名为 main 的方法不是入口：它的函数体有语法错误，转换时也不解析
+    auto skeleton =
+        compile(kUsed + "\n@Point {\n    x: i32\n}\n&Point {\n    main() {\n        y := (1 +\n    }\n}\n", true);
+    CHECK_EQ(skeleton->error, std::string());
+    auto impl = nodeCast<ImplBlock>(skeleton->program->statements.back());
+    CHECK(impl && nodeCast<FunctionDecl>(impl->methods[0])->lazyBody);
+    std::string error = unit_test::errorOf([&] { flat_ast::Ast::fromProgram(*skeleton->program); });
+    CHECK_EQ(error, std::string());
+
+    // 没有经过语义分析时，顶层入口函数的函数体在转换时解析，其中的语法错误与 parse() 相同
+    const std::string broken = "main() {\n    x := (1 +\n}\n";
+    auto unanalyzed = compile(broken, true, false);
+    FunctionDecl* entry = findFunction(*unanalyzed->program, "main");
+    CHECK(entry && entry->lazyBody);
+    error = unit_test::errorOf([&] { flat_ast::Ast::fromProgram(*unanalyzed->program); });
+    const std::string expected = compile(broken, false)->error;
+    CHECK(!expected.empty());
+    CHECK_EQ(error, expected);
+}
+
+TEST(骨架模式_与完整解析结果一致) {
+    // 全部函数都用到时，骨架模式的语法树、语义错误与扁平 AST 都与 parse() 相同
+    const std::string sources[] = {
+        kUsed,
+        // 用到的函数体中的语义错误照常报告
+        kUsed + "\nextra() {\n    s: i32 = \"text\"\n    print(missing)\n}\n" + "\n主函数() {\n    extra()\n}\n",
+        // 入口函数之外的函数互相调用（含递归）只分析一次
+        "main() {\n    ping(3)\n}\nping(n: i32) {\n    pong(n - 1)\n}\npong(n: i32) {\n    ping(n)\n}\n",
+    };
+    for (const std::string& source : sources) {
+        auto skeleton = compile(source, true);
+        auto full = compile(source, false);
+        CHECK_EQ(skeleton->error, full->error);
+        CHECK_EQ(skeleton->semanticErrors, full->semanticErrors);
+        const flat_ast::Ast flatSkeleton = flat_ast::Ast::fromProgram(*skeleton->program);
+        const flat_ast::Ast flatFull = flat_ast::Ast::fromProgram(*full->program);
+        CHECK_EQ(flatSkeleton.nodeCount(), flatFull.nodeCount());
+        CHECK_EQ(flatSkeleton.bytesUsed(), flatFull.bytesUsed());
+        CHECK_EQ(unit_test::dump(skeleton->program.get()), unit_test::dump(full->program.get()));
+    }
+}
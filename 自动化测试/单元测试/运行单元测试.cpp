@@ -0,0 +1,30 @@
+// 单元测试入口：依次运行所有 TEST，输出格式与金样测试一致；有失败时返回 1
+// 用法: polyglot_unit_tests [用例名片段]   只运行名字包含该片段的用例
+#include "单元测试.h"
+#include <exception>
+
+int main(int argc, char* argv[]) {
+    const std::string filter = argc > 1 ? argv[1] : "";
+    int passed = 0;
+    int failed = 0;
+    for (const unit_test::Case& test : unit_test::registry()) {
+        if (!filter.empty() && std::string(test.name).find(filter) == std::string::npos) continue;
+
+        const int before = unit_test::failureCount();
+        try {
+            test.run();
+        } catch (const std::exception& e) {
+            unit_test::fail(test.name, 0, std::string("未捕获的异常: ") + e.what());
+        }
+        if (unit_test::failureCount() == before) {
+            ++passed;
+            std::cout << "[通过] " << test.name << std::endl;
+        } else {
+            ++failed;
+            std::cout << "[失败] " << test.name << std::endl;
+        }
+    }
+
+    std::cout << "\n[unit] 总数=" << passed + failed << " 通过=" << passed << " 失败=" << failed << std::endl;
+    return failed == 0 ? 0 : 1;
+}
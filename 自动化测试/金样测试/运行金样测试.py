@@ -7,6 +7,9 @@ import os
 import json
 import difflib
 import re
+import shlex
+import shutil
+import tempfile
 from pathlib import Path
 
 # 统一控制台编码为 UTF-8
@@ -62,6 +65,13 @@ def 解析可执行(path: Path) -> Path:
     return path
 
 
+def 执行(执行器: Path, 源: Path, 目录: Path, *选项: str):
+    进程 = subprocess.run([
+        str(执行器), '--quiet', *选项, str(源)
+    ], cwd=str(目录), stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True, encoding='utf-8')
+    return 过滤日志(规范化(进程.stdout)), 过滤日志(规范化(进程.stderr)), 进程.returncode
+
+
 def 运行用例(目录: Path) -> dict:
     输入_pg = 目录 / 'input.pg'
     输入_中文 = 目录 / '输入.文达'
@@ -70,6 +80,8 @@ def 运行用例(目录: Path) -> dict:
         期望_输出 = 目录 / '期望.文本'
     期望_错误 = 目录 / '期望.错误'
     期望_退出 = 目录 / '期望.退出'
+    选项文件 = 目录 / '选项'
+    对照文件 = 目录 / '对照选项'
 
     if not 期望_输出.exists() and not 期望_错误.exists():
         return {'名称': 目录.name, '状态': '错误', '原因': '缺少 期望.输出/期望.文本 或 期望.错误'}
@@ -94,17 +106,26 @@ def 运行用例(目录: Path) -> dict:
         except Exception:
             return {'名称': 目录.name, '状态': '错误', '原因': '期望.退出 不是有效整数'}
 
+    # 选项：每次运行都带上的命令行选项；对照选项：每行一组额外选项，结果须与默认运行完全一致
+    选项 = shlex.split(选项文件.read_text(encoding='utf-8')) if 选项文件.exists() else []
+    对照组 = []
+    if 对照文件.exists():
+        对照组 = [shlex.split(行) for 行 in 对照文件.read_text(encoding='utf-8').splitlines() if 行.strip()]
+
+    # 默认在扁平 AST 上解释执行；再以 --tree-walk 遍历指针树运行一次，两者的输出、错误与退出码须完全一致
     try:
-        进程 = subprocess.run([
-            str(执行器), '--quiet', str(源)
-        ], cwd=str(根), stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True, encoding='utf-8')
+        实得_出, 实得_错, 实得_退 = 执行(执行器, 源, 目录, *选项)
+        树_出, 树_错, 树_退 = 执行(执行器, 源, 目录, *选项, '--tree-walk')
+        对照结果 = []
+        for 额外 in 对照组:
+            # 对照运行可能在源文件旁写出文件（如 -v 导出 AST），在用例目录的副本中进行
+            with tempfile.TemporaryDirectory() as 临时:
+                副本 = Path(临时) / 目录.name
+                shutil.copytree(目录, 副本)
+                对照结果.append((额外, 执行(执行器, 副本 / 源.name, 副本, *选项, *额外)))
     except Exception as e:
         return {'名称': 目录.name, '状态': '错误', '原因': f'执行失败: {e}'}
 
-    实得_出 = 过滤日志(规范化(进程.stdout))
-    实得_错 = 过滤日志(规范化(进程.stderr))
-    实得_退 = 进程.returncode
-
     通过 = False
     结果 = {'名称': 目录.name, '退出码': 实得_退, 'stdout': 实得_出, 'stderr': 实得_错}
 
@@ -117,6 +138,16 @@ def 运行用例(目录: Path) -> dict:
         通过 = (实得_退 == 退出码期望) and (实得_出 == 期望_出)
         结果['expected_stdout'] = 期望_出
 
+    if (树_出, 树_错, 树_退) != (实得_出, 实得_错, 实得_退):
+        通过 = False
+        结果['tree_walk'] = {'退出码': 树_退, 'stdout': 树_出, 'stderr': 树_错}
+
+    for 额外, (对照_出, 对照_错, 对照_退) in 对照结果:
+        if (对照_出, 对照_错, 对照_退) != (实得_出, 实得_错, 实得_退):
+            通过 = False
+            结果.setdefault('对照', []).append(
+                {'选项': ' '.join(额外), '退出码': 对照_退, 'stdout': 对照_出, 'stderr': 对照_错})
+
     结果['状态'] = '通过' if 通过 else '失败'
     return 结果
 
@@ -158,6 +189,16 @@ def 主程序():
                 print(实得)
                 exp_exit = 0 if 'expected_stdout' in r else (r.get('expected_exit', 1))
                 print(f"  exit: got {r.get('退出码')} expected {exp_exit}")
+            if 'tree_walk' in r:
+                树 = r['tree_walk']
+                print('  树遍历（--tree-walk）与扁平 AST 的结果不一致:')
+                print(f"  --- tree-walk (exit {树['退出码']}) ---")
+                print(树['stdout'])
+                print(树['stderr'])
+            for 对照 in r.get('对照', []):
+                print(f"  对照选项 {对照['选项']} 的结果与默认运行不一致 (exit {对照['退出码']}):")
+                print(对照['stdout'])
+                print(对照['stderr'])
         else:
             统计['错误'] += 1
             print(f"[错误] {r['名称']}: {r.get('原因','')}")